@@ -0,0 +1,243 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <utki/debug.hpp>
+
+// Number helpers shared by the parser and binary format codecs, not part of the public API.
+
+namespace jsondom::internal {
+
+enum class binary_number_kind {
+	// non-negative integer, the value is in 'uint'
+	unsigned_integer,
+
+	// negative integer, the value is -1 - 'uint'
+	negative_integer,
+
+	// floating point number, the value is in 'floating'
+	floating,
+
+	// number cannot be represented exactly, it has to be stored as text
+	text
+};
+
+/**
+ * @brief Representation of a JSON number in binary formats.
+ */
+struct binary_number {
+	binary_number_kind kind = binary_number_kind::text;
+	uint64_t uint = 0;
+	double floating = 0;
+};
+
+/**
+ * @brief Check that the string is a valid JSON number.
+ * @param s - string to check.
+ * @return true if the string is a valid JSON number.
+ * @return false otherwise.
+ */
+inline bool is_valid_number(std::string_view s)
+{
+	auto is_dec_digit = [](char c) {
+		return '0' <= c && c <= '9';
+	};
+
+	enum class state {
+		idle,
+		sign,
+		integer,
+		dot,
+		fraction,
+		exponent,
+		exponent_sign,
+		exponent_integer
+	} cur_state = state::idle;
+
+	for (auto c : s) {
+		switch (cur_state) {
+			case state::idle:
+				if (c == '-') {
+					cur_state = state::sign; // sign parsed
+					break;
+				} else if (is_dec_digit(c)) {
+					cur_state = state::integer;
+					break;
+				}
+				return false;
+			case state::sign:
+				if (is_dec_digit(c)) {
+					cur_state = state::integer;
+					break;
+				}
+				return false;
+			case state::integer:
+				if (is_dec_digit(c)) {
+					break;
+				} else if (c == '.') {
+					cur_state = state::dot; // dot parsed
+					break;
+				} else if (c == 'e' || c == 'E') {
+					cur_state = state::exponent; // exponent parsed
+					break;
+				}
+				return false;
+			case state::dot:
+				if (is_dec_digit(c)) {
+					cur_state = state::fraction;
+					break;
+				}
+				return false;
+			case state::fraction:
+				if (is_dec_digit(c)) {
+					break;
+				} else if (c == 'e' || c == 'E') {
+					cur_state = state::exponent; // exponent parsed
+					break;
+				}
+				return false;
+			case state::exponent:
+				if (c == '-' || c == '+') {
+					cur_state = state::exponent_sign; // exponent sign parsed
+					break;
+				} else if (is_dec_digit(c)) {
+					cur_state = state::exponent_integer;
+					break;
+				}
+				return false;
+			case state::exponent_sign:
+				if (is_dec_digit(c)) {
+					cur_state = state::exponent_integer;
+					break;
+				}
+				return false;
+			case state::exponent_integer:
+				if (is_dec_digit(c)) {
+					break;
+				}
+				return false;
+		}
+	}
+
+	if (cur_state == state::idle || cur_state == state::sign || cur_state == state::dot ||
+		cur_state == state::exponent || cur_state == state::exponent_sign)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Format double to the shortest string which parses back to the same double.
+ * @param d - double to format.
+ * @return formatted number.
+ */
+inline std::string format_double(double d)
+{
+	constexpr auto buf_size = 32;
+	std::array<char, buf_size> buf{};
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+	auto res = std::to_chars(buf.data(), std::next(buf.data(), buf.size()), d);
+	ASSERT(res.ec == std::errc())
+	return {buf.data(), res.ptr};
+#else
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+	int res = snprintf(buf.data(), buf.size(), "%.17g", d);
+	ASSERT(0 <= res && res < int(buf.size()))
+	return {buf.data(), size_t(res)};
+#endif
+}
+
+/**
+ * @brief Format negative integer -1 - n.
+ * @param n - number to format.
+ * @return formatted number.
+ */
+inline std::string format_negative_integer(uint64_t n)
+{
+	if (n == std::numeric_limits<uint64_t>::max()) {
+		// -1 - n overflows 64 bits
+		return "-18446744073709551616";
+	}
+	return std::string("-").append(std::to_string(n + 1));
+}
+
+/**
+ * @brief Find binary representation which converts back to exactly the same number string.
+ * @param str - number string.
+ * @return binary representation of the number.
+ */
+inline binary_number to_binary_number(std::string_view str)
+{
+	binary_number ret;
+
+	bool negative = !str.empty() && str.front() == '-';
+	auto digits = negative ? str.substr(1) : str;
+
+	// canonical integers only, i.e. no leading zeros, no plus sign, no "-0"
+	bool is_canonical_integer = !digits.empty() && digits.find_first_not_of("0123456789") == std::string_view::npos &&
+		(digits.front() != '0' || (digits.size() == 1 && !negative));
+
+	if (is_canonical_integer) {
+		uint64_t magnitude = 0;
+		auto res = std::from_chars(digits.data(), std::next(digits.data(), ptrdiff_t(digits.size())), magnitude);
+		if (res.ec == std::errc()) {
+			if (negative) {
+				ret.kind = binary_number_kind::negative_integer;
+				ret.uint = magnitude - 1;
+			} else {
+				ret.kind = binary_number_kind::unsigned_integer;
+				ret.uint = magnitude;
+			}
+			return ret;
+		}
+	}
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+	double d = 0;
+	auto res = std::from_chars(str.data(), std::next(str.data(), ptrdiff_t(str.size())), d);
+	if (res.ec == std::errc() && res.ptr == std::next(str.data(), ptrdiff_t(str.size())) && format_double(d) == str) {
+		ret.kind = binary_number_kind::floating;
+		ret.floating = d;
+	}
+#endif
+
+	return ret;
+}
+
+} // namespace jsondom::internal
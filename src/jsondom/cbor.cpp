@@ -0,0 +1,531 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "cbor.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <utki/string.hpp>
+
+#include "binary_number.hpp"
+#include "dom_parser.hpp"
+
+using namespace std::string_view_literals;
+
+using namespace jsondom;
+
+namespace {
+enum class major_type : uint8_t {
+	unsigned_integer = 0,
+	negative_integer = 1,
+	byte_string = 2,
+	text_string = 3,
+	array = 4,
+	map = 5,
+	tag = 6,
+	simple_or_float = 7
+};
+
+constexpr auto byte_bits = std::numeric_limits<uint8_t>::digits;
+
+constexpr auto major_type_shift = 5;
+constexpr uint8_t additional_info_mask = 0x1f;
+
+// additional info values
+constexpr uint8_t one_byte_argument = 24;
+constexpr uint8_t two_bytes_argument = 25;
+constexpr uint8_t four_bytes_argument = 26;
+constexpr uint8_t eight_bytes_argument = 27;
+constexpr uint8_t indefinite_length = 31;
+
+// simple values
+constexpr uint8_t simple_false = 20;
+constexpr uint8_t simple_true = 21;
+constexpr uint8_t simple_null = 22;
+
+// half, single and double precision floats use 2, 4 and 8 bytes argument additional info values
+constexpr uint8_t half_float = two_bytes_argument;
+constexpr uint8_t single_float = four_bytes_argument;
+constexpr uint8_t double_float = eight_bytes_argument;
+
+constexpr uint8_t break_byte = 0xff;
+
+constexpr auto flush_threshold = size_t(utki::kilobyte) * 64;
+
+// protects decoder from stack overflow on malicious input
+constexpr auto max_nesting_depth = 1024;
+} // namespace
+
+namespace {
+class cbor_encoder
+{
+	fsif::file* fi;
+
+public:
+	std::vector<uint8_t> buf;
+
+	cbor_encoder(fsif::file* fi = nullptr) :
+		fi(fi)
+	{}
+
+	void flush()
+	{
+		if (!this->fi) {
+			return;
+		}
+		this->fi->write(utki::make_span(this->buf));
+		this->buf.clear();
+	}
+
+	void write_head(major_type type, uint64_t argument)
+	{
+		auto initial_byte = uint8_t(uint8_t(type) << major_type_shift);
+
+		size_t num_bytes = 0;
+		if (argument < one_byte_argument) {
+			this->buf.push_back(initial_byte | uint8_t(argument));
+			return;
+		} else if (argument <= std::numeric_limits<uint8_t>::max()) {
+			this->buf.push_back(initial_byte | one_byte_argument);
+			num_bytes = sizeof(uint8_t);
+		} else if (argument <= std::numeric_limits<uint16_t>::max()) {
+			this->buf.push_back(initial_byte | two_bytes_argument);
+			num_bytes = sizeof(uint16_t);
+		} else if (argument <= std::numeric_limits<uint32_t>::max()) {
+			this->buf.push_back(initial_byte | four_bytes_argument);
+			num_bytes = sizeof(uint32_t);
+		} else {
+			this->buf.push_back(initial_byte | eight_bytes_argument);
+			num_bytes = sizeof(uint64_t);
+		}
+
+		// big-endian
+		for (size_t i = num_bytes; i != 0; --i) {
+			this->buf.push_back(uint8_t(argument >> ((i - 1) * byte_bits)));
+		}
+	}
+
+	void write_text(std::string_view str)
+	{
+		this->write_head(major_type::text_string, str.size());
+		this->buf.insert(this->buf.end(), str.begin(), str.end());
+	}
+
+	void write_number(const string_number& num)
+	{
+		const auto& str = num.get_string();
+		auto bn = internal::to_binary_number(str);
+		switch (bn.kind) {
+			case internal::binary_number_kind::unsigned_integer:
+				this->write_head(major_type::unsigned_integer, bn.uint);
+				break;
+			case internal::binary_number_kind::negative_integer:
+				this->write_head(major_type::negative_integer, bn.uint);
+				break;
+			case internal::binary_number_kind::floating:
+				{
+					uint64_t bits = 0;
+					static_assert(sizeof(bits) == sizeof(bn.floating));
+					std::memcpy(&bits, &bn.floating, sizeof(bits));
+					this->buf.push_back(uint8_t(uint8_t(major_type::simple_or_float) << major_type_shift) | double_float);
+					for (size_t i = sizeof(bits); i != 0; --i) {
+						this->buf.push_back(uint8_t(bits >> ((i - 1) * byte_bits)));
+					}
+				}
+				break;
+			case internal::binary_number_kind::text:
+				this->write_head(major_type::tag, cbor_number_tag);
+				this->write_text(str);
+				break;
+		}
+	}
+
+	void write_simple(uint8_t simple)
+	{
+		this->buf.push_back(uint8_t(uint8_t(major_type::simple_or_float) << major_type_shift) | simple);
+	}
+
+	void write(const value& v)
+	{
+		switch (v.get_type()) {
+			default:
+			case type::null:
+				this->write_simple(simple_null);
+				break;
+			case type::boolean:
+				this->write_simple(v.boolean() ? simple_true : simple_false);
+				break;
+			case type::number:
+				this->write_number(v.number());
+				break;
+			case type::string:
+				this->write_text(v.string());
+				break;
+			case type::array:
+				this->write_head(major_type::array, v.array().size());
+				for (const auto& e : v.array()) {
+					this->write(e);
+					if (this->buf.size() >= flush_threshold) {
+						this->flush();
+					}
+				}
+				break;
+			case type::object:
+				this->write_head(major_type::map, v.object().size());
+				for (const auto& kv : v.object()) {
+					this->write_text(kv.first);
+					this->write(kv.second);
+					if (this->buf.size() >= flush_threshold) {
+						this->flush();
+					}
+				}
+				break;
+		}
+	}
+};
+} // namespace
+
+void jsondom::write_cbor(
+	fsif::file& fi, //
+	const value& v
+)
+{
+	fsif::file::guard file_guard(
+		fi, //
+		fsif::mode::create
+	);
+
+	cbor_encoder e(&fi);
+	e.write(v);
+	e.flush();
+}
+
+std::vector<uint8_t> jsondom::to_cbor(const value& v)
+{
+	cbor_encoder e;
+	e.write(v);
+	return std::move(e.buf);
+}
+
+namespace {
+class cbor_decoder
+{
+	utki::span<const uint8_t> data;
+	size_t pos = 0;
+
+	parser& p;
+
+	// holds concatenated chunks of indefinite length strings and formatted numbers
+	std::string scratch;
+
+	[[noreturn]] void throw_malformed(std::string_view message)
+	{
+		throw malformed_binary_data_error(utki::cat(
+			"jsondom: malformed CBOR data at offset "sv, //
+			this->pos,
+			": "sv,
+			message
+		));
+	}
+
+	uint8_t read_byte()
+	{
+		if (this->pos == this->data.size()) {
+			this->throw_malformed("unexpected end of data"sv);
+		}
+		return this->data[this->pos++];
+	}
+
+	uint64_t read_big_endian(size_t num_bytes)
+	{
+		if (this->data.size() - this->pos < num_bytes) {
+			this->throw_malformed("unexpected end of data"sv);
+		}
+		uint64_t ret = 0;
+		for (size_t i = 0; i != num_bytes; ++i) {
+			ret = (ret << byte_bits) | this->data[this->pos++];
+		}
+		return ret;
+	}
+
+	uint64_t read_argument(uint8_t additional_info)
+	{
+		if (additional_info < one_byte_argument) {
+			return additional_info;
+		}
+		switch (additional_info) {
+			case one_byte_argument:
+				return this->read_big_endian(sizeof(uint8_t));
+			case two_bytes_argument:
+				return this->read_big_endian(sizeof(uint16_t));
+			case four_bytes_argument:
+				return this->read_big_endian(sizeof(uint32_t));
+			case eight_bytes_argument:
+				return this->read_big_endian(sizeof(uint64_t));
+			default:
+				this->throw_malformed("invalid additional information value"sv);
+		}
+	}
+
+	utki::span<const char> read_definite_text(uint64_t length)
+	{
+		if (this->data.size() - this->pos < length) {
+			this->throw_malformed("unexpected end of data"sv);
+		}
+		auto ret = utki::to_char(this->data.subspan(this->pos, size_t(length)));
+		this->pos += size_t(length);
+		return ret;
+	}
+
+	// read text string which head has already been read
+	utki::span<const char> read_text(uint8_t additional_info)
+	{
+		if (additional_info != indefinite_length) {
+			return this->read_definite_text(this->read_argument(additional_info));
+		}
+
+		// indefinite length string consists of definite length chunks followed by break byte
+		this->scratch.clear();
+		while (true) {
+			auto b = this->read_byte();
+			if (b == break_byte) {
+				break;
+			}
+			if (major_type(b >> major_type_shift) != major_type::text_string ||
+				(b & additional_info_mask) == indefinite_length)
+			{
+				this->throw_malformed("invalid chunk of indefinite length text string"sv);
+			}
+			auto chunk = this->read_definite_text(this->read_argument(b & additional_info_mask));
+			this->scratch.append(chunk.data(), chunk.size());
+		}
+		return utki::make_span(this->scratch);
+	}
+
+	void notify_number(const std::string& str)
+	{
+		this->p.on_number_parsed(utki::make_span(str));
+	}
+
+	void notify_number_text(utki::span<const char> str)
+	{
+		if (!internal::is_valid_number(std::string_view(str.data(), str.size()))) {
+			this->throw_malformed("number tag content is not a valid number"sv);
+		}
+		this->p.on_number_parsed(str);
+	}
+
+	void notify_float(double d)
+	{
+		if (!std::isfinite(d)) {
+			this->throw_malformed("non-finite floating point number has no JSON equivalent"sv);
+		}
+		this->notify_number(internal::format_double(d));
+	}
+
+	static double half_to_double(uint16_t half)
+	{
+		// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+		int exponent = (half >> 10) & 0x1f;
+		int mantissa = half & 0x3ff;
+		double d = 0;
+		if (exponent == 0) {
+			d = std::ldexp(mantissa, -24);
+		} else if (exponent != 31) {
+			d = std::ldexp(mantissa + 1024, exponent - 25);
+		} else {
+			d = mantissa == 0 ? INFINITY : NAN;
+		}
+		return (half & 0x8000) ? -d : d;
+		// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+	}
+
+	// returns true if break byte was read instead of data item
+	bool decode_item(unsigned depth, bool break_allowed)
+	{
+		if (depth > max_nesting_depth) {
+			this->throw_malformed("nesting is too deep"sv);
+		}
+
+		auto initial_byte = this->read_byte();
+
+		// skip tags in a loop rather than recursively, so that long runs of tags do not exhaust the stack
+		while (major_type(initial_byte >> major_type_shift) == major_type::tag) {
+			if (this->read_argument(initial_byte & additional_info_mask) == cbor_number_tag) {
+				auto b = this->read_byte();
+				if (major_type(b >> major_type_shift) != major_type::text_string) {
+					this->throw_malformed("number tag is not followed by text string"sv);
+				}
+				this->notify_number_text(this->read_text(b & additional_info_mask));
+				return false;
+			}
+			// ignore unknown tags
+			initial_byte = this->read_byte();
+		}
+
+		auto type = major_type(initial_byte >> major_type_shift);
+		uint8_t additional_info = initial_byte & additional_info_mask;
+
+		switch (type) {
+			case major_type::unsigned_integer:
+				this->notify_number(std::to_string(this->read_argument(additional_info)));
+				break;
+			case major_type::negative_integer:
+				this->notify_number(internal::format_negative_integer(this->read_argument(additional_info)));
+				break;
+			case major_type::byte_string:
+				this->throw_malformed("byte strings have no JSON equivalent"sv);
+			case major_type::text_string:
+				this->p.on_string_parsed(this->read_text(additional_info));
+				break;
+			case major_type::array:
+				this->p.on_array_start();
+				if (additional_info == indefinite_length) {
+					while (!this->decode_item(depth + 1, true)) {
+					}
+				} else {
+					for (auto n = this->read_argument(additional_info); n != 0; --n) {
+						this->decode_item(depth + 1, false);
+					}
+				}
+				this->p.on_array_end();
+				break;
+			case major_type::map:
+				this->p.on_object_start();
+				if (additional_info == indefinite_length) {
+					while (!this->decode_key(true)) {
+						this->decode_item(depth + 1, false);
+					}
+				} else {
+					for (auto n = this->read_argument(additional_info); n != 0; --n) {
+						this->decode_key(false);
+						this->decode_item(depth + 1, false);
+					}
+				}
+				this->p.on_object_end();
+				break;
+			case major_type::tag:
+				// tags are skipped above
+				ASSERT(false)
+				break;
+			case major_type::simple_or_float:
+				switch (additional_info) {
+					case simple_false:
+						this->p.on_boolean_parsed(false);
+						break;
+					case simple_true:
+						this->p.on_boolean_parsed(true);
+						break;
+					case simple_null:
+						this->p.on_null_parsed();
+						break;
+					case half_float:
+						this->notify_float(half_to_double(uint16_t(this->read_big_endian(sizeof(uint16_t)))));
+						break;
+					case single_float:
+						{
+							auto bits = uint32_t(this->read_big_endian(sizeof(uint32_t)));
+							float f = 0;
+							std::memcpy(&f, &bits, sizeof(f));
+							this->notify_float(double(f));
+						}
+						break;
+					case double_float:
+						{
+							auto bits = this->read_big_endian(sizeof(uint64_t));
+							double d = 0;
+							std::memcpy(&d, &bits, sizeof(d));
+							this->notify_float(d);
+						}
+						break;
+					case indefinite_length:
+						if (!break_allowed) {
+							this->throw_malformed("unexpected break"sv);
+						}
+						return true;
+					default:
+						this->throw_malformed("simple value has no JSON equivalent"sv);
+				}
+				break;
+		}
+		return false;
+	}
+
+	// returns true if break byte was read instead of key
+	bool decode_key(bool break_allowed)
+	{
+		auto initial_byte = this->read_byte();
+		if (break_allowed && initial_byte == break_byte) {
+			return true;
+		}
+		if (major_type(initial_byte >> major_type_shift) != major_type::text_string) {
+			this->throw_malformed("map key is not a text string"sv);
+		}
+		this->p.on_key_parsed(this->read_text(initial_byte & additional_info_mask));
+		return false;
+	}
+
+public:
+	cbor_decoder(
+		utki::span<const uint8_t> data, //
+		parser& p
+	) :
+		data(data),
+		p(p)
+	{}
+
+	void decode()
+	{
+		this->decode_item(0, false);
+		if (this->pos != this->data.size()) {
+			this->throw_malformed("extra data after the root data item"sv);
+		}
+	}
+};
+} // namespace
+
+void jsondom::read_cbor(
+	utki::span<const uint8_t> data, //
+	parser& p
+)
+{
+	cbor_decoder(data, p).decode();
+}
+
+value jsondom::read_cbor(utki::span<const uint8_t> data)
+{
+	dom_parser p;
+	read_cbor(data, p);
+	return p.release_document();
+}
+
+value jsondom::read_cbor(const fsif::file& fi)
+{
+	return read_cbor(utki::make_span(fi.load()));
+}
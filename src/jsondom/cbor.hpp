@@ -0,0 +1,97 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <fsif/file.hpp>
+#include <utki/span.hpp>
+
+#include "dom.hpp"
+#include "parser.hpp"
+
+namespace jsondom {
+
+/**
+ * @brief CBOR tag for numbers stored as text.
+ * JSON numbers are written to CBOR as integers or as 64-bit floats when that
+ * represents the number string exactly, i.e. the number string is restored exactly when read back.
+ * Otherwise, the number is written as a text string tagged with this tag.
+ */
+constexpr const uint64_t cbor_number_tag = 0x4a4e; // 'JN'
+
+/**
+ * @brief Write JSON document to file in CBOR format.
+ * CBOR format is specified by RFC 8949.
+ * @param fi - file to write the document to.
+ * @param v - root value of the document to write.
+ */
+void write_cbor(
+	fsif::file& fi, //
+	const value& v
+);
+
+/**
+ * @brief Encode JSON document to CBOR format.
+ * @param v - root value of the document to encode.
+ * @return CBOR encoded document.
+ */
+std::vector<uint8_t> to_cbor(const value& v);
+
+/**
+ * @brief Read JSON document from CBOR data.
+ * CBOR data items which have no JSON equivalent, like byte strings, non-text map keys
+ * or non-finite floating point numbers, are considered malformed data.
+ * Tags other than cbor_number_tag are ignored.
+ * @param data - CBOR data to read.
+ * @return the read JSON document.
+ * @throw malformed_binary_data_error in case the data is malformed.
+ */
+value read_cbor(utki::span<const uint8_t> data);
+
+/**
+ * @brief Read JSON document from CBOR file.
+ * @param fi - file to read the CBOR data from.
+ * @return the read JSON document.
+ * @throw malformed_binary_data_error in case the data is malformed.
+ */
+value read_cbor(const fsif::file& fi);
+
+/**
+ * @brief Decode CBOR data to parser events.
+ * Invokes parser's on_*() callbacks as if equivalent JSON text was fed to the parser.
+ * @param data - CBOR data to decode.
+ * @param p - parser to invoke callbacks of.
+ * @throw malformed_binary_data_error in case the data is malformed.
+ */
+void read_cbor(
+	utki::span<const uint8_t> data, //
+	parser& p
+);
+
+} // namespace jsondom
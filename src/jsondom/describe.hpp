@@ -0,0 +1,215 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace jsondom {
+
+/**
+ * @brief Description of a struct field.
+ * Maps JSON object key to a struct member.
+ * Use field() function to create field descriptions.
+ */
+template <typename class_type, typename member_type>
+struct field_description {
+	std::string_view key;
+	member_type class_type::*pointer;
+};
+
+/**
+ * @brief Describe struct field.
+ * @param key - JSON object key the field is mapped to.
+ * @param pointer - pointer to the struct member.
+ * @return field description.
+ */
+template <typename class_type, typename member_type>
+constexpr field_description<class_type, member_type> field(
+	std::string_view key, //
+	member_type class_type::*pointer
+)
+{
+	return {key, pointer};
+}
+
+/**
+ * @brief Description of a struct for typed reading and writing.
+ * In order to make a struct readable from and writable to JSON object,
+ * specialize this template for the struct and define tuple of field descriptions
+ * as constexpr static member named 'fields'. For example:
+ * @code{.cpp}
+ * struct quote {
+ *     std::string symbol;
+ *     double last = 0;
+ *     std::optional<std::vector<int>> volumes;
+ * };
+ *
+ * template <>
+ * struct jsondom::describe<quote> {
+ *     static constexpr auto fields = std::make_tuple(
+ *         jsondom::field("symbol", &quote::symbol),
+ *         jsondom::field("last", &quote::last),
+ *         jsondom::field("volumes", &quote::volumes)
+ *     );
+ * };
+ * @endcode
+ */
+template <typename T>
+struct describe;
+
+template <typename T, typename = void>
+struct is_described : std::false_type {};
+
+template <typename T>
+struct is_described<T, std::void_t<decltype(describe<T>::fields)>> : std::true_type {};
+
+/**
+ * @brief Check if the type has description.
+ */
+template <typename T>
+constexpr bool is_described_v = is_described<T>::value;
+
+} // namespace jsondom
+
+namespace jsondom::internal {
+
+template <typename T>
+constexpr size_t num_fields_v = std::tuple_size_v<std::remove_cv_t<decltype(describe<T>::fields)>>;
+
+template <typename T, size_t... index>
+constexpr std::array<std::string_view, sizeof...(index)> field_keys(std::index_sequence<index...>)
+{
+	return {std::get<index>(describe<T>::fields).key...};
+}
+
+/**
+ * @brief Keys of described struct fields, in the order of description.
+ */
+template <typename T>
+constexpr auto field_keys_v = field_keys<T>(std::make_index_sequence<num_fields_v<T>>());
+
+constexpr uint32_t key_hash(
+	std::string_view key, //
+	uint32_t seed
+)
+{
+	// FNV-1a with seeded offset basis
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+	uint32_t hash = 2166136261U ^ seed;
+	for (auto c : key) {
+		hash ^= uint8_t(c);
+		// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+		hash *= 16777619U;
+	}
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+	return hash ^ (hash >> 16);
+}
+
+/**
+ * @brief Perfect hash table of struct field keys.
+ * The table maps each key to a distinct slot.
+ * Slots hold field index plus one, zero means empty slot.
+ */
+template <size_t num_keys>
+struct perfect_hash_table {
+	// load factor of 1/8 keeps the search for collision free seed short
+	static constexpr size_t size = [] {
+		size_t ret = 1;
+		// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+		while (ret < num_keys * 8) {
+			ret <<= 1;
+		}
+		return ret;
+	}();
+
+	uint32_t seed = 0;
+	std::array<uint16_t, size> slots{};
+
+	constexpr size_t find(std::string_view key, const std::array<std::string_view, num_keys>& keys) const
+	{
+		auto slot = this->slots[key_hash(key, this->seed) & (size - 1)];
+		if (slot == 0 || keys[slot - 1] != key) {
+			return num_keys;
+		}
+		return slot - 1;
+	}
+};
+
+template <size_t num_keys>
+constexpr perfect_hash_table<num_keys> make_perfect_hash_table(const std::array<std::string_view, num_keys>& keys)
+{
+	static_assert(num_keys < std::numeric_limits<uint16_t>::max(), "too many fields");
+
+	for (size_t i = 0; i != num_keys; ++i) {
+		for (size_t j = i + 1; j != num_keys; ++j) {
+			if (keys[i] == keys[j]) {
+				throw std::logic_error("duplicate field key in jsondom::describe");
+			}
+		}
+	}
+
+	using table_type = perfect_hash_table<num_keys>;
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+	constexpr uint32_t max_seed = 10000;
+
+	for (uint32_t seed = 0; seed != max_seed; ++seed) {
+		table_type table;
+		table.seed = seed;
+
+		bool collision = false;
+		for (size_t i = 0; i != num_keys; ++i) {
+			auto& slot = table.slots[key_hash(keys[i], seed) & (table_type::size - 1)];
+			if (slot != 0) {
+				collision = true;
+				break;
+			}
+			slot = uint16_t(i + 1);
+		}
+
+		if (!collision) {
+			return table;
+		}
+	}
+
+	throw std::logic_error("could not find perfect hash for jsondom::describe field keys");
+}
+
+/**
+ * @brief Perfect hash table of described struct field keys, generated at compile time.
+ */
+template <typename T>
+constexpr auto field_table_v = make_perfect_hash_table(field_keys_v<T>);
+
+} // namespace jsondom::internal
@@ -0,0 +1,420 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+
+#include "document.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "dom_parser.hpp"
+
+using namespace std::string_view_literals;
+
+using namespace jsondom;
+
+namespace {
+// the parser can only parse objects at the root level, so the values are wrapped into an object
+constexpr auto wrapper_begin = R"({"":)"sv;
+constexpr auto wrapper_end = "}"sv;
+} // namespace
+
+namespace {
+bool is_whitespace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+} // namespace
+
+namespace {
+size_t skip_whitespace(
+	std::string_view text, //
+	size_t pos
+)
+{
+	for (; pos != text.size() && is_whitespace(text[pos]); ++pos) {
+	}
+	return pos;
+}
+} // namespace
+
+namespace {
+// Returns position right after the closing quote, std::string_view::npos in case the string is not terminated.
+size_t skip_string(
+	std::string_view text, //
+	size_t quote_pos
+)
+{
+	ASSERT(text[quote_pos] == '"')
+	for (size_t i = quote_pos + 1; i < text.size(); ++i) {
+		switch (text[i]) {
+			case '\\':
+				++i;
+				break;
+			case '"':
+				return i + 1;
+			default:
+				break;
+		}
+	}
+	return std::string_view::npos;
+}
+} // namespace
+
+namespace {
+// Returns position right after the number, boolean or null value.
+size_t skip_scalar(
+	std::string_view text, //
+	size_t pos
+)
+{
+	for (; pos != text.size(); ++pos) {
+		auto c = text[pos];
+		if (c == ',' || c == '}' || c == ']' || is_whitespace(c)) {
+			break;
+		}
+	}
+	return pos;
+}
+} // namespace
+
+namespace {
+// Returns position right after the bracket matching the opening one,
+// std::string_view::npos in case there is no matching bracket.
+size_t find_container_end(
+	std::string_view text, //
+	size_t begin
+)
+{
+	ASSERT(text[begin] == '{' || text[begin] == '[')
+
+	size_t depth = 0;
+	for (size_t i = begin; i != text.size(); ++i) {
+		switch (text[i]) {
+			case '"':
+				i = skip_string(text, i);
+				if (i == std::string_view::npos) {
+					return i;
+				}
+				--i;
+				break;
+			case '{':
+			case '[':
+				++depth;
+				break;
+			case '}':
+			case ']':
+				--depth;
+				if (depth == 0) {
+					return i + 1;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	return std::string_view::npos;
+}
+} // namespace
+
+namespace {
+// Get key as it is parsed from its text.
+std::string decode_key(std::string_view key_text)
+{
+	if (key_text.find('\\') == std::string_view::npos) {
+		return std::string(key_text);
+	}
+
+	// the key has escape sequences, let the parser decode it
+	dom_parser p;
+	constexpr auto key_begin = R"({")"sv;
+	constexpr auto key_end = R"(":null})"sv;
+	p.feed(utki::make_span(key_begin.data(), key_begin.size()));
+	p.feed(utki::make_span(key_text.data(), key_text.size()));
+	p.feed(utki::make_span(key_end.data(), key_end.size()));
+	return p.release_document().object().begin()->first;
+}
+} // namespace
+
+size_t document::scan(
+	std::string_view text, //
+	size_t pos,
+	size_t parent_begin,
+	const jsondom::value* v,
+	node& n
+)
+{
+	ASSERT(text[pos] == '{' || text[pos] == '[')
+	ASSERT(!v || (text[pos] == '{' ? v->is_object() : v->is_array()))
+
+	n.begin = pos - parent_begin;
+	n.children.clear();
+
+	bool is_object = text[pos] == '{';
+	auto closing_bracket = is_object ? '}' : ']';
+
+	size_t num_members = 0;
+
+	pos = skip_whitespace(text, pos + 1);
+	while (text[pos] != closing_bracket) {
+		std::string_view key_text;
+		if (is_object) {
+			auto key_end = skip_string(text, pos);
+			key_text = text.substr(pos + 1, key_end - pos - 2);
+			if (std::any_of(key_text.begin(), key_text.end(), is_whitespace)) {
+				// the parser treats whitespace inside keys as start of an escape sequence,
+				// so the text cannot be split into values without parsing it
+				return std::string_view::npos;
+			}
+			pos = skip_whitespace(text, key_end);
+			ASSERT(text[pos] == ':')
+			pos = skip_whitespace(text, pos + 1);
+		}
+
+		switch (text[pos]) {
+			case '"':
+				pos = skip_string(text, pos);
+				break;
+			case '{':
+			case '[':
+				{
+					node child;
+					const jsondom::value* child_value = nullptr;
+					if (is_object) {
+						child.key = decode_key(key_text);
+						if (v) {
+							if (auto i = v->object().find(child.key); i != v->object().end()) {
+								child_value = &i->second;
+							}
+						}
+					} else {
+						child.index = num_members;
+						if (v && num_members < v->array().size()) {
+							child_value = &v->array()[num_members];
+						}
+					}
+
+					// the value can be of other type in case the member is overwritten by other member with the same key
+					if (child_value && (text[pos] == '{' ? !child_value->is_object() : !child_value->is_array())) {
+						child_value = nullptr;
+					}
+
+					pos = scan(text, pos, parent_begin + n.begin, child_value, child);
+					if (pos == std::string_view::npos) {
+						return pos;
+					}
+					n.children.push_back(std::move(child));
+				}
+				break;
+			default:
+				pos = skip_scalar(text, pos);
+				break;
+		}
+
+		++num_members;
+
+		pos = skip_whitespace(text, pos);
+		if (text[pos] == ',') {
+			pos = skip_whitespace(text, pos + 1);
+		}
+	}
+
+	if (is_object) {
+		// in case of duplicate keys the last member overwrites the previous ones,
+		// in case the value is unknown, then it is overwritten as well
+		n.has_duplicate_keys = !v || num_members != v->object().size();
+	}
+
+	++pos;
+	n.size = pos - (n.begin + parent_begin);
+	return pos;
+}
+
+document::document(std::string text) :
+	text(std::move(text))
+{
+	this->parse();
+}
+
+void document::parse()
+{
+	dom_parser p;
+	p.feed(utki::make_span(this->text.data(), this->text.size()));
+
+	// the parser does not know where the document ends, so check that the root object is complete
+	auto root_begin = skip_whitespace(this->text, 0);
+	if (root_begin != this->text.size() &&
+		(this->text[root_begin] != '{' || find_container_end(this->text, root_begin) == std::string_view::npos))
+	{
+		throw malformed_json_error("jsondom::document: unexpected end of document");
+	}
+
+	auto v = p.release_document();
+
+	node n;
+	if (v.is_object()) {
+		if (scan(this->text, root_begin, 0, &v, n) == std::string_view::npos) {
+			// locations are unknown, all edits will cause parsing the whole document
+			n = node();
+		}
+	}
+
+	this->root = std::move(v);
+	this->root_node = std::move(n);
+}
+
+bool document::reparse_part(
+	size_t offset, //
+	size_t removed_length,
+	size_t inserted_length
+)
+{
+	// find the smallest object or array which encloses the edited part, not including the brackets
+	auto encloses = [offset, removed_length](const node& n, size_t begin) {
+		return begin < offset && offset + removed_length < begin + n.size;
+	};
+
+	if (!encloses(this->root_node, this->root_node.begin)) {
+		return false;
+	}
+
+	// path from the root node to the enclosing node, along with positions of the nodes in the text
+	std::vector<std::pair<node*, size_t>> path = {
+		{&this->root_node, this->root_node.begin}
+	};
+	while (true) {
+		auto [n, begin] = path.back();
+
+		// first child starting at or after the edited part
+		auto i = std::lower_bound(
+			n->children.begin(),
+			n->children.end(),
+			offset - begin,
+			[](const node& child, size_t pos) {
+				return child.begin < pos;
+			}
+		);
+		if (i == n->children.begin()) {
+			break;
+		}
+		--i;
+		if (!encloses(*i, begin + i->begin)) {
+			break;
+		}
+		if (n->has_duplicate_keys) {
+			// the object's member may be overwritten by other member with the same key
+			return false;
+		}
+		path.emplace_back(&*i, begin + i->begin);
+	}
+
+	auto [target, target_begin] = path.back();
+
+	auto size = target->size + inserted_length - removed_length;
+	auto text = std::string_view(this->text).substr(target_begin, size);
+
+	// the edit may have split the object or array into several values
+	if (find_container_end(text, 0) != text.size()) {
+		return false;
+	}
+
+	jsondom::value v;
+	try {
+		dom_parser p;
+		p.feed(utki::make_span(wrapper_begin.data(), wrapper_begin.size()));
+		p.feed(utki::make_span(text.data(), text.size()));
+		p.feed(utki::make_span(wrapper_end.data(), wrapper_end.size()));
+		v = std::move(p.release_document().object().begin()->second);
+	} catch (malformed_json_error&) {
+		return false;
+	}
+
+	node n;
+	if (scan(text, 0, 0, &v, n) == std::string_view::npos) {
+		return false;
+	}
+	n.begin = target->begin;
+	n.key = target->key;
+	n.index = target->index;
+
+	// put the parsed value into the value tree
+	jsondom::value* parent = &this->root;
+	for (auto i = std::next(path.begin()); i != path.end(); ++i) {
+		if (parent->is_object()) {
+			auto j = parent->object().find(i->first->key);
+			ASSERT(j != parent->object().end())
+			parent = &j->second;
+		} else {
+			parent = &parent->array()[i->first->index];
+		}
+	}
+	*parent = std::move(v);
+
+	// update the locations, the sizes are unsigned, so growing works for shrinking as well
+	auto grow = [inserted_length, removed_length](size_t& x) {
+		x = x + inserted_length - removed_length;
+	};
+
+	*target = std::move(n);
+	for (auto i = std::next(path.rbegin()); i != path.rend(); ++i) {
+		auto& ancestor = *i->first;
+		grow(ancestor.size);
+
+		// shift the siblings which follow the edited part
+		auto child_index = size_t(std::prev(i)->first - ancestor.children.data());
+		for (auto j = child_index + 1; j < ancestor.children.size(); ++j) {
+			grow(ancestor.children[j].begin);
+		}
+	}
+
+	return true;
+}
+
+bool document::edit(
+	size_t offset, //
+	size_t removed_length,
+	std::string_view inserted
+)
+{
+	if (offset > this->text.size() || removed_length > this->text.size() - offset) {
+		throw std::out_of_range("jsondom::document::edit(): edited part is out of the text");
+	}
+
+	auto removed = this->text.substr(offset, removed_length);
+	this->text.replace(offset, removed_length, inserted);
+
+	try {
+		if (this->reparse_part(offset, removed_length, inserted.size())) {
+			return true;
+		}
+		this->parse();
+		return false;
+	} catch (...) {
+		// restore the text
+		this->text.replace(offset, inserted.size(), removed);
+		throw;
+	}
+}
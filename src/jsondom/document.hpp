@@ -0,0 +1,143 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dom.hpp"
+
+namespace jsondom {
+
+/**
+ * @brief JSON document text along with its parsed value.
+ * Keeps locations of all objects and arrays in the text, so that after an edit of the text
+ * only the smallest object or array enclosing the edited part is parsed again and the result is put
+ * into the existing value tree. This way the time it takes to parse the document after a small edit
+ * does not depend on the size of the document.
+ * Locations of the nested objects and arrays are stored relative to their parents,
+ * so that only the locations of the siblings which follow the edited part need updating.
+ */
+class document
+{
+	std::string text;
+	jsondom::value root;
+
+	// location of an object or an array in the text
+	struct node {
+		// position of the opening bracket relative to the parent's opening bracket,
+		// for root node it is relative to the beginning of the text
+		size_t begin = 0;
+
+		// size of the text including the brackets
+		size_t size = 0;
+
+		// key in the parent object
+		std::string key;
+
+		// index in the parent array
+		size_t index = 0;
+
+		// whether the object has more than one member with the same key
+		bool has_duplicate_keys = false;
+
+		// nested objects and arrays in the order of appearance in the text
+		std::vector<node> children;
+	};
+
+	node root_node;
+
+	// v is the parsed object or array, nullptr in case it is unknown,
+	// returns position right after the object or array, std::string_view::npos in case
+	// the locations could not be determined
+	static size_t scan(
+		std::string_view text, //
+		size_t pos,
+		size_t parent_begin,
+		const jsondom::value* v,
+		node& n
+	);
+
+	void parse();
+
+	bool reparse_part(
+		size_t offset, //
+		size_t removed_length,
+		size_t inserted_length
+	);
+
+public:
+	/**
+	 * @brief Parse JSON document.
+	 * @param text - JSON document text.
+	 * @throw malformed_json_error in case the document is not a valid JSON.
+	 */
+	explicit document(std::string text);
+
+	/**
+	 * @brief Get the document text.
+	 * @return the document text.
+	 */
+	const std::string& get_text() const noexcept
+	{
+		return this->text;
+	}
+
+	/**
+	 * @brief Get parsed root value of the document.
+	 * @return the parsed root value.
+	 */
+	const jsondom::value& get_value() const noexcept
+	{
+		return this->root;
+	}
+
+	/**
+	 * @brief Edit the document text.
+	 * Replaces part of the text and parses the edited document.
+	 * Only the smallest object or array enclosing the edited part of the text is parsed again
+	 * in case the edit does not change the structure of the document outside of that object or array.
+	 * Otherwise, the whole document is parsed again.
+	 * In case the edited document is not a valid JSON, the document remains unchanged.
+	 * @param offset - position in the text of the part to replace.
+	 * @param removed_length - length of the part to replace.
+	 * @param inserted - text to insert in place of the replaced part.
+	 * @return true in case only part of the document has been parsed again.
+	 * @return false in case the whole document has been parsed again.
+	 * @throw std::out_of_range in case the replaced part is out of the text.
+	 * @throw malformed_json_error in case the edited document is not a valid JSON.
+	 */
+	bool edit(
+		size_t offset, //
+		size_t removed_length,
+		std::string_view inserted
+	);
+};
+
+} // namespace jsondom
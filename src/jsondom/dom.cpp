@@ -26,12 +26,20 @@ SOFTWARE.
 
 #include "dom.hpp"
 
-#include <fsif/span_file.hpp>
-#include <fsif/vector_file.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+
 #include <utki/string.hpp>
 #include <utki/util.hpp>
 
-#include "parser.hpp"
+#include "dom_parser.hpp"
+#include "writer.hpp"
 
 #ifdef assert
 #	undef assert
@@ -54,192 +62,306 @@ value::value(jsondom::type type) :
 			case jsondom::type::string:
 				return variant_type(std::string());
 			case jsondom::type::object:
-				return variant_type(object_type());
+				return variant_type(std::make_shared<shared_container<object_type>>());
 			case jsondom::type::array:
-				return variant_type(array_type());
+				return variant_type(std::make_shared<shared_container<array_type>>());
 		}
 	}())
 {}
 
-namespace {
-std::string type_to_name(type type)
+std::string_view jsondom::to_string(type type)
 {
 	switch (type) {
 		default:
 		case type::null:
-			return "null";
+			return "null"sv;
 		case type::boolean:
-			return "boolean";
+			return "boolean"sv;
 		case type::number:
-			return "number";
+			return "number"sv;
 		case type::string:
-			return "string";
+			return "string"sv;
 		case type::object:
-			return "object";
+			return "object"sv;
 		case type::array:
-			return "array";
+			return "array"sv;
 	}
 }
-} // namespace
 
 void value::throw_access_error(type tried_access) const
 {
 	throw unexpected_value_type(utki::cat(
 		"jsondom: could not access "sv, //
-		type_to_name(tried_access),
+		jsondom::to_string(tried_access),
 		"value, stored value is of another type ("sv,
-		type_to_name(this->get_type()),
+		jsondom::to_string(this->get_type()),
 		")"sv
 	));
 }
 
 namespace {
-struct dom_parser : public parser {
-	value doc{type::array};
+// Estimate size of the memory block actually taken from the heap by allocation of the given size.
+// Typical allocators put a machine word sized header in front of each block and round the blocks up
+// to two machine words, the smallest block being four machine words.
+size_t heap_block_size(size_t size)
+{
+	if (size == 0) {
+		return 0;
+	}
 
-	std::string key;
+	constexpr auto header_size = sizeof(void*);
+	constexpr auto alignment = sizeof(void*) * 2;
+	constexpr auto min_block_size = sizeof(void*) * 4;
 
-	std::vector<value*> stack = {&this->doc};
+	size = (size + header_size + alignment - 1) / alignment * alignment;
+	return std::max(size, min_block_size);
+}
 
-	void on_object_start() override
-	{
-		ASSERT(!this->stack.empty())
-		auto back = this->stack.back();
-		switch (back->get_type()) {
-			case type::array:
-				back->array().emplace_back(type::object);
-				this->stack.push_back(&back->array().back());
-				break;
-			case type::object:
-				back->object()[this->key] = value(type::object);
-				this->stack.push_back(&back->object()[this->key]);
-				this->key.clear();
-				break;
-			default:
-				ASSERT(false)
-				break;
-		}
-	}
+size_t string_heap_size(const std::string& str)
+{
+	// short strings are stored within the std::string object itself
+	static const auto small_string_capacity = std::string().capacity();
 
-	void on_object_end() override
-	{
-		this->stack.pop_back();
+	if (str.capacity() <= small_string_capacity) {
+		return 0;
 	}
+	// one more byte for the terminating zero
+	return heap_block_size(str.capacity() + 1);
+}
 
-	void on_array_start() override
-	{
-		ASSERT(!this->stack.empty())
-		auto back = this->stack.back();
-		switch (back->get_type()) {
-			case type::array:
-				back->array().emplace_back(type::array);
-				this->stack.push_back(&back->array().back());
+// std::map node holds the color, the parent and two child pointers in front of the key-value pair
+constexpr auto map_node_header_size = sizeof(void*) * 4;
+
+// std::make_shared() places the virtual table pointer and two reference counters in front of the object
+constexpr auto shared_control_block_size = sizeof(void*) + sizeof(int) * 2;
+} // namespace
+
+memory_usage_stats value::memory_usage() const
+{
+	memory_usage_stats ret;
+
+	// containers shared within the tree are counted once
+	std::unordered_set<const void*> visited;
+
+	auto add = [&ret, &visited](const value& v, const auto& add) -> void {
+		switch (v.get_type()) {
+			case type::number:
+				ret.numbers += string_heap_size(v.number().get_string());
+				break;
+			case type::string:
+				ret.strings += string_heap_size(v.string());
 				break;
 			case type::object:
-				back->object()[this->key] = value(type::array);
-				this->stack.push_back(&back->object()[this->key]);
-				this->key.clear();
+				if (!visited.insert(&v.object()).second) {
+					break;
+				}
+				ret.containers +=
+					heap_block_size(shared_control_block_size + sizeof(shared_container<object_type>));
+				for (const auto& kv : v.object()) {
+					ret.containers += heap_block_size(map_node_header_size + sizeof(object_type::value_type));
+					ret.keys += string_heap_size(kv.first);
+					add(kv.second, add);
+				}
+				break;
+			case type::array:
+				if (!visited.insert(&v.array()).second) {
+					break;
+				}
+				ret.containers +=
+					heap_block_size(shared_control_block_size + sizeof(shared_container<array_type>));
+				ret.containers += heap_block_size(v.array().capacity() * sizeof(value));
+				for (const auto& e : v.array()) {
+					add(e, add);
+				}
 				break;
 			default:
-				ASSERT(false)
 				break;
 		}
-	}
+	};
 
-	void on_array_end() override
-	{
-		this->stack.pop_back();
-	}
+	add(*this, add);
 
-	void on_key_parsed(utki::span<const char> str) override
-	{
-		this->key = utki::make_string(str);
-	}
+	return ret;
+}
+
+namespace {
+// Reads the file from a separate thread into a ring of buffers.
+// The file must be opened before constructing the reader and must not be closed until the reader is destroyed.
+class background_reader
+{
+	const fsif::file& fi;
+
+	std::vector<std::vector<uint8_t>> buffers;
 
-	void on_string_parsed(utki::span<const char> str) override
+	std::mutex mutex;
+	std::condition_variable cv;
+
+	// indices of buffers available for reading into
+	std::deque<size_t> free_buffers;
+
+	// indices of buffers holding the read data along with the data size,
+	// zero size indicates end of file
+	std::deque<std::pair<size_t, size_t>> filled_buffers;
+
+	bool stop_requested = false;
+	std::exception_ptr exception;
+
+	// index of the buffer currently being parsed, to be returned to the free buffers
+	std::optional<size_t> current_buffer;
+
+	std::thread thread;
+
+	void run()
 	{
-		ASSERT(!this->stack.empty())
-		auto back = this->stack.back();
-		switch (back->get_type()) {
-			case type::array:
-				back->array().emplace_back(utki::make_string(str));
-				break;
-			case type::object:
-				back->object()[this->key] = value(utki::make_string(str));
-				this->key.clear();
-				break;
-			default:
-				ASSERT(false)
-				break;
+		try {
+			while (true) {
+				size_t index = 0;
+				{
+					std::unique_lock lock(this->mutex);
+					this->cv.wait(lock, [this]() {
+						return this->stop_requested || !this->free_buffers.empty();
+					});
+					if (this->stop_requested) {
+						return;
+					}
+					index = this->free_buffers.front();
+					this->free_buffers.pop_front();
+				}
+
+				auto& buf = this->buffers[index];
+				auto res = this->fi.read(utki::make_span(buf));
+				utki::assert(res <= buf.size(), SL);
+
+				{
+					std::lock_guard lock(this->mutex);
+					this->filled_buffers.emplace_back(index, res);
+				}
+				this->cv.notify_all();
+
+				if (res == 0) {
+					return;
+				}
+			}
+		} catch (...) {
+			{
+				std::lock_guard lock(this->mutex);
+				this->exception = std::current_exception();
+			}
+			this->cv.notify_all();
 		}
 	}
 
-	void on_number_parsed(utki::span<const char> str) override
+public:
+	background_reader(
+		const fsif::file& fi, //
+		size_t chunk_size,
+		unsigned num_buffers
+	) :
+		fi(fi)
 	{
-		ASSERT(!this->stack.empty())
-		auto back = this->stack.back();
-		switch (back->get_type()) {
-			case type::array:
-				back->array().emplace_back(string_number(utki::make_string(str)));
-				break;
-			case type::object:
-				back->object()[this->key] = value(string_number(utki::make_string(str)));
-				this->key.clear();
-				break;
-			default:
-				ASSERT(false)
-				break;
+		ASSERT(num_buffers != 0)
+		ASSERT(chunk_size != 0)
+		this->buffers.resize(num_buffers);
+		for (size_t i = 0; i != this->buffers.size(); ++i) {
+			this->buffers[i].resize(chunk_size);
+			this->free_buffers.push_back(i);
 		}
+
+		this->thread = std::thread([this]() {
+			this->run();
+		});
 	}
 
-	void on_boolean_parsed(bool b) override
+	background_reader(const background_reader&) = delete;
+	background_reader& operator=(const background_reader&) = delete;
+
+	background_reader(background_reader&&) = delete;
+	background_reader& operator=(background_reader&&) = delete;
+
+	~background_reader()
 	{
-		ASSERT(!this->stack.empty())
-		auto back = this->stack.back();
-		switch (back->get_type()) {
-			case type::array:
-				back->array().emplace_back(b);
-				break;
-			case type::object:
-				back->object()[this->key] = value(b);
-				this->key.clear();
-				break;
-			default:
-				ASSERT(false)
-				break;
+		{
+			std::lock_guard lock(this->mutex);
+			this->stop_requested = true;
 		}
+		this->cv.notify_all();
+		this->thread.join();
 	}
 
-	void on_null_parsed() override
+	/**
+	 * @brief Get next chunk of read data.
+	 * The previously returned chunk becomes invalid.
+	 * @return next chunk of data, empty span means end of file.
+	 */
+	utki::span<const uint8_t> next()
 	{
-		ASSERT(!this->stack.empty())
-		auto back = this->stack.back();
-		switch (back->get_type()) {
-			case type::array:
-				back->array().emplace_back();
-				break;
-			case type::object:
-				back->object()[this->key] = value();
-				this->key.clear();
-				break;
-			default:
-				ASSERT(false)
-				break;
+		std::unique_lock lock(this->mutex);
+
+		if (this->current_buffer.has_value()) {
+			this->free_buffers.push_back(this->current_buffer.value());
+			this->current_buffer.reset();
+			this->cv.notify_all();
+		}
+
+		this->cv.wait(lock, [this]() {
+			return this->exception || !this->filled_buffers.empty();
+		});
+
+		if (this->filled_buffers.empty()) {
+			ASSERT(this->exception)
+			std::rethrow_exception(this->exception);
 		}
+
+		auto [index, size] = this->filled_buffers.front();
+		this->filled_buffers.pop_front();
+		this->current_buffer = index;
+
+		return utki::make_span(this->buffers[index].data(), size);
 	}
 };
 } // namespace
 
-jsondom::value jsondom::read(const fsif::file& fi)
+void jsondom::internal::apply_read_options(
+	parser& p, //
+	const read_options& options
+)
 {
-	dom_parser p;
+	if (options.stats) {
+		p.enable_stats(options.measure_parsing_time);
+	}
 
-	{
-		fsif::file::guard file_guard(fi);
+	if (options.limits) {
+		p.set_limits(*options.limits);
+	}
+}
+
+void jsondom::internal::store_read_stats(
+	const parser& p, //
+	const read_options& options
+)
+{
+	if (options.stats) {
+		ASSERT(p.get_stats())
+		*options.stats = *p.get_stats();
+	}
+}
+
+void jsondom::read(
+	const fsif::file& fi, //
+	parser& p,
+	const read_options& options
+)
+{
+	if (options.chunk_size == 0) {
+		throw std::invalid_argument("jsondom::read(): chunk_size is 0");
+	}
 
-		// no need to init read buffer
-		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
-		std::array<uint8_t, size_t(utki::kilobyte) * 4> buf;
+	fsif::file::guard file_guard(fi);
+
+	internal::apply_read_options(p, options);
+
+	if (options.num_background_buffers == 0) {
+		std::vector<uint8_t> buf(options.chunk_size);
 
 		while (true) {
 			auto res = fi.read(utki::make_span(buf));
@@ -249,32 +371,62 @@ jsondom::value jsondom::read(const fsif::file& fi)
 			}
 			p.feed(utki::make_span(buf.data(), res));
 		}
+	} else {
+		background_reader reader(
+			fi, //
+			options.chunk_size,
+			options.num_background_buffers
+		);
+
+		for (auto chunk = reader.next(); !chunk.empty(); chunk = reader.next()) {
+			p.feed(utki::to_char(chunk));
+		}
 	}
 
-	ASSERT(p.stack.size() == 1, [&](auto& o) {
-		o << "p.stack.size() = " << p.stack.size();
-	})
-	ASSERT(p.doc.is<type::array>())
-
-	if (p.doc.array().empty()) {
-		return {};
-	}
-
-	return std::move(p.doc.array().front());
+	internal::store_read_stats(p, options);
 }
 
-jsondom::value jsondom::read(utki::span<const char> data)
+jsondom::value jsondom::read(
+	const fsif::file& fi, //
+	const read_options& options
+)
 {
-	const fsif::span_file fi(data);
+	dom_parser p;
+	read(fi, p, options);
+	return p.release_document();
+}
 
-	return read(fi);
+jsondom::value jsondom::read(
+	utki::span<const char> data, //
+	const read_options& options
+)
+{
+	// the data is already in memory, no need to read it by chunks
+	dom_parser p;
+	internal::apply_read_options(p, options);
+	p.feed(data);
+	internal::store_read_stats(p, options);
+	return p.release_document();
 }
 
-jsondom::value jsondom::read(utki::span<const uint8_t> data)
+jsondom::value jsondom::read(
+	utki::span<const uint8_t> data, //
+	const read_options& options
+)
 {
-	const fsif::span_file fi(data);
+	return read(utki::to_char(data), options);
+}
 
-	return read(fi);
+jsondom::value jsondom::read(
+	const padded_buffer& data, //
+	const read_options& options
+)
+{
+	dom_parser p;
+	internal::apply_read_options(p, options);
+	p.feed(data);
+	internal::store_read_stats(p, options);
+	return p.release_document();
 }
 
 jsondom::value jsondom::read(const char* str)
@@ -290,134 +442,36 @@ jsondom::value jsondom::read(const char* str)
 }
 
 namespace {
-const auto open_curly_brace = utki::make_span("{");
-const auto close_curly_brace = utki::make_span("}");
-const auto open_square_brace = utki::make_span("[");
-const auto close_square_brace = utki::make_span("]");
-const auto double_quote = utki::make_span("\"");
-const auto double_quote_and_colon = utki::make_span("\":");
-const auto comma = utki::make_span(",");
-const auto word_true = utki::make_span("true");
-const auto word_false = utki::make_span("false");
-const auto word_null = utki::make_span("null");
-} // namespace
-
-namespace {
-std::string escape_string(const std::string& str)
-{
-	std::stringstream ss;
-
-	for (auto c : str) {
-		switch (c) {
-			case '"':
-				ss << '\\' << '"';
-				break;
-			case '\\':
-				ss << '\\' << '\\';
-				break;
-			case '/':
-				ss << '\\' << '/';
-				break;
-			case '\b':
-				ss << '\\' << 'b';
-				break;
-			case '\f':
-				ss << '\\' << 'f';
-				break;
-			case '\n':
-				ss << '\\' << 'n';
-				break;
-			case '\r':
-				ss << '\\' << 'r';
-				break;
-			case '\t':
-				ss << '\\' << 't';
-				break;
-			default:
-				ss << c;
-				break;
-		}
-	}
-
-	return ss.str();
-}
-} // namespace
-
-namespace {
-void write_internal(
-	fsif::file& fi, //
-	const jsondom::value& v
-)
+void throw_if_not_object_root(const jsondom::value& v)
 {
-	switch (v.get_type()) {
-		default:
-		case type::null:
-			fi.write(word_null);
-			break;
-		case type::boolean:
-			if (v.boolean()) {
-				fi.write(word_true);
-			} else {
-				fi.write(word_false);
-			}
-			break;
-		case type::number:
-			fi.write(utki::make_span(v.number().get_string()));
-			break;
-		case type::string:
-			{
-				fi.write(double_quote);
-				fi.write(escape_string(v.string()));
-				fi.write(double_quote);
-				break;
-			}
-		case type::array:
-			fi.write(open_square_brace);
-			for (auto i = v.array().begin(); i != v.array().end(); ++i) {
-				if (i != v.array().begin()) {
-					fi.write(comma);
-				}
-				write_internal(fi, *i);
-			}
-			fi.write(close_square_brace);
-			break;
-		case type::object:
-			fi.write(open_curly_brace);
-			for (auto i = v.object().begin(); i != v.object().end(); ++i) {
-				if (i != v.object().begin()) {
-					fi.write(comma);
-				}
-				fi.write(double_quote);
-				fi.write(escape_string(i->first));
-				fi.write(double_quote_and_colon);
-				write_internal(fi, i->second);
-			}
-			fi.write(close_curly_brace);
-			break;
+	if (!v.is<type::object>()) {
+		throw std::logic_error("tried to write JSON with non-object root element");
 	}
 }
 } // namespace
 
 void jsondom::write(
 	fsif::file& fi, //
-	const jsondom::value& v
+	const jsondom::value& v,
+	const write_options& options
 )
 {
-	if (!v.is<type::object>()) {
-		throw std::logic_error("tried to write JSON with non-object root element");
-	}
+	throw_if_not_object_root(v);
 
 	fsif::file::guard file_guard(
 		fi, //
 		fsif::mode::create
 	);
 
-	write_internal(fi, v);
+	writer w(fi, options);
+	w.value(v);
 }
 
-std::string value::to_string() const
+std::string value::to_string(const write_options& options) const
 {
-	fsif::vector_file file;
-	jsondom::write(file, *this);
-	return utki::make_string(file.reset_data());
+	throw_if_not_object_root(*this);
+
+	writer w(options);
+	w.value(*this);
+	return w.reset_data();
 }
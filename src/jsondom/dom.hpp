@@ -26,8 +26,12 @@ SOFTWARE.
 
 #pragma once
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -36,10 +40,20 @@ SOFTWARE.
 #include <utki/types.hpp>
 
 #include "errors.hpp"
+#include "padded_buffer.hpp"
 #include "string_number.hpp"
 
 namespace jsondom {
 
+class parser;
+class writer;
+struct parser_limits;
+struct parser_stats;
+
+namespace internal {
+struct serialized_cache;
+} // namespace internal
+
 /**
  * @brief Type of the JSON value.
  * JSON specifies only 6 value types, this enumeration
@@ -56,12 +70,107 @@ enum class type {
 	enum_size
 };
 
+/**
+ * @brief Get name of JSON value type.
+ * @param type - value type.
+ * @return name of the value type, e.g. "object".
+ */
+std::string_view to_string(type type);
+
+/**
+ * @brief Options for writing JSON document.
+ */
+struct write_options {
+	/**
+	 * @brief Escape all non-ASCII characters.
+	 * If true, then all non-ASCII characters of strings and keys are written
+	 * as \uXXXX escape sequences (surrogate pairs for characters outside of the Basic Multilingual Plane),
+	 * so that the output consists of ASCII characters only.
+	 * Invalid UTF-8 sequences are written as U+FFFD replacement character.
+	 * If false, then non-ASCII characters are written as is.
+	 */
+	bool ensure_ascii = false;
+
+	/**
+	 * @brief Number of threads to serialize large documents with.
+	 * If greater than 1, then large arrays and objects are split into pieces which are serialized
+	 * to separate memory buffers in parallel, the pieces are then written out in order.
+	 * Values of small estimated serialized size are always serialized from the calling thread.
+	 * Value of 0 means using as many threads as there are hardware threads available.
+	 */
+	unsigned num_threads = 1;
+
+	/**
+	 * @brief Cache serialized text of objects and arrays.
+	 * If true, then serialized text of each written object and array is stored along with it,
+	 * so that next time the unchanged subtrees are written by copying the stored text.
+	 * Accessing an object or array for modification via non-constant object() or array()
+	 * drops its stored text, so after a small modification only the objects and arrays
+	 * on the path from the modified value to the root are serialized again.
+	 * Because of that, references to objects, arrays and their elements obtained before the writing
+	 * must not be used for modification after the writing, the modifications must be done starting
+	 * from the root value each time.
+	 * The stored text does not duplicate the text of nested objects and arrays,
+	 * so that the memory overhead is about the size of the serialized document.
+	 * The num_threads option is ignored when writing with the cache.
+	 */
+	bool cache_subtrees = false;
+};
+
+/**
+ * @brief Heap memory used by a JSON value tree.
+ * All sizes are in bytes and are estimates, they include estimated overhead of the heap allocator
+ * for each allocated memory block.
+ */
+struct memory_usage_stats {
+	/**
+	 * @brief Memory used by objects and arrays themselves.
+	 * Includes the array element buffers and the object member nodes,
+	 * which also hold the values of the array elements and of the object members.
+	 */
+	size_t containers = 0;
+
+	/**
+	 * @brief Memory used by text of string values.
+	 * Short strings stored within the std::string object itself take no heap memory.
+	 */
+	size_t strings = 0;
+
+	/**
+	 * @brief Memory used by text of object member keys.
+	 * Short keys stored within the std::string object itself take no heap memory.
+	 */
+	size_t keys = 0;
+
+	/**
+	 * @brief Memory used by text of number values.
+	 * Short numbers stored within the std::string object itself take no heap memory.
+	 */
+	size_t numbers = 0;
+
+	/**
+	 * @brief Get total memory usage.
+	 * @return sum of all the memory usage components.
+	 */
+	size_t total() const noexcept
+	{
+		return this->containers + this->strings + this->keys + this->numbers;
+	}
+};
+
 /**
  * @brief JSON value.
  * This class encapsulates the JSON value along with its type.
+ *
+ * Copying the value is cheap, because objects and arrays are shared between the copies
+ * and are only copied when they are accessed for modification via non-constant object() or array().
+ * Only the accessed object or array itself is copied then, its nested objects and arrays remain shared.
+ * The reference counting is atomic, so that copies of the same value can be used from different threads.
  */
 class value
 {
+	friend class writer;
+
 public:
 	using array_type = std::vector<value>;
 
@@ -72,13 +181,22 @@ public:
 		>;
 
 private:
+	template <typename container_type>
+	struct shared_container {
+		container_type container;
+
+		// serialized text of the container, see write_options::cache_subtrees
+		mutable std::shared_ptr<const internal::serialized_cache> cache;
+	};
+
 	using variant_type = std::variant<
 		std::nullptr_t, //
 		bool,
 		string_number,
 		std::string,
-		object_type,
-		array_type //
+		// objects and arrays are shared between copies of the value and copied on modification
+		std::shared_ptr<shared_container<object_type>>,
+		std::shared_ptr<shared_container<array_type>> //
 		>;
 
 	// check that variant types order corresponds to type enum order
@@ -124,18 +242,18 @@ private:
 			utki::remove_const_reference_t< //
 				decltype(std::get<size_t(jsondom::type::object)>(std::declval<variant_type>())) //
 				>,
-			object_type //
+			std::shared_ptr<shared_container<object_type>> //
 			>,
-		"type of object variant alternative is not object_type"
+		"type of object variant alternative is not std::shared_ptr<shared_container<object_type>>"
 	);
 	static_assert(
 		std::is_same_v<
 			utki::remove_const_reference_t< //
 				decltype(std::get<size_t(jsondom::type::array)>(std::declval<variant_type>())) //
 				>,
-			array_type //
+			std::shared_ptr<shared_container<array_type>> //
 			>,
-		"type of array variant alternative is not array_type"
+		"type of array variant alternative is not std::shared_ptr<shared_container<array_type>>"
 	);
 #endif
 
@@ -151,14 +269,58 @@ private:
 		}
 	}
 
+	template <typename container_type>
+	container_type& get_unshared()
+	{
+		auto& p = std::get<std::shared_ptr<shared_container<container_type>>>(this->var);
+		ASSERT(p)
+		if (p.use_count() != 1) {
+			// the container is shared with other values, copy it before giving out modifiable reference,
+			// the copy shares the nested containers
+			p = std::make_shared<shared_container<container_type>>(
+				shared_container<container_type>{std::as_const(p->container), nullptr}
+			);
+		} else {
+			// synchronize with releasing of the container by other values in other threads
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			// the container is going to be modified, the serialized text becomes invalid
+			p->cache.reset();
+		}
+		return p->container;
+	}
+
+	// get serialized text cache of the object or array value
+	std::shared_ptr<const internal::serialized_cache>& serialized_cache() const
+	{
+		if (this->is_object()) {
+			return std::get<std::shared_ptr<shared_container<object_type>>>(this->var)->cache;
+		}
+		ASSERT(this->is_array())
+		return std::get<std::shared_ptr<shared_container<array_type>>>(this->var)->cache;
+	}
+
 public:
 	value() = default;
 
 	value(const value&) = default;
 	value& operator=(const value&) = default;
 
-	value(value&& v) = default;
-	value& operator=(value&&) = default;
+	// moved-from value becomes null, because moving the shared container out leaves a null pointer behind
+	value(value&& v) noexcept :
+		var(std::move(v.var))
+	{
+		v.var = nullptr;
+	}
+
+	value& operator=(value&& v) noexcept
+	{
+		if (this != &v) {
+			this->var = std::move(v.var);
+			v.var = nullptr;
+		}
+		return *this;
+	}
 
 	~value() = default;
 
@@ -354,13 +516,15 @@ public:
 
 	/**
 	 * @brief Get array value.
-	 * @return reference to the underlying array value.
+	 * In case the array is shared with other copies of the value, it is copied first.
+	 * @return reference to the underlying array value. The reference must not be used
+	 *         for modification after the value has been copied.
 	 * @throw unexpected_value_type in case the stored value is not an array.
 	 */
 	array_type& array()
 	{
 		this->throw_if_type_is_not<type::array>();
-		return std::get<array_type>(this->var);
+		return this->get_unshared<array_type>();
 	}
 
 	/**
@@ -371,18 +535,20 @@ public:
 	const array_type& array() const
 	{
 		this->throw_if_type_is_not<type::array>();
-		return std::get<array_type>(this->var);
+		return std::get<std::shared_ptr<shared_container<array_type>>>(this->var)->container;
 	}
 
 	/**
 	 * @brief Get object value.
-	 * @return reference to the underlying object value.
+	 * In case the object is shared with other copies of the value, it is copied first.
+	 * @return reference to the underlying object value. The reference must not be used
+	 *         for modification after the value has been copied.
 	 * @throw unexpected_value_type in case the stored value is not an object.
 	 */
 	object_type& object()
 	{
 		this->throw_if_type_is_not<type::object>();
-		return std::get<object_type>(this->var);
+		return this->get_unshared<object_type>();
 	}
 
 	/**
@@ -393,42 +559,156 @@ public:
 	const object_type& object() const
 	{
 		this->throw_if_type_is_not<type::object>();
-		return std::get<object_type>(this->var);
+		return std::get<std::shared_ptr<shared_container<object_type>>>(this->var)->container;
 	}
 
-	std::string to_string() const;
+	/**
+	 * @brief Serialize the JSON document to string.
+	 * @param options - writing options.
+	 * @return JSON document text.
+	 */
+	std::string to_string(const write_options& options = {}) const;
+
+	/**
+	 * @brief Estimate heap memory used by the value and all its nested values.
+	 * Objects and arrays shared between copies of values are counted once within the value tree,
+	 * but they are counted by each of the value trees sharing them.
+	 * Serialized text stored along with objects and arrays when writing with write_options::cache_subtrees
+	 * is not counted.
+	 * @return estimated heap memory usage.
+	 */
+	memory_usage_stats memory_usage() const;
 };
 
 /**
  * @brief Write the JSON document to a file.
  * @param fi - file to write the JSON document to.
  * @param v - root value of the JSON document to write.
+ * @param options - writing options.
  */
 void write(
 	fsif::file& fi, //
-	const value& v
+	const value& v,
+	const write_options& options = {}
 );
 
+/**
+ * @brief Options for reading JSON document.
+ * When reading from memory, the chunk_size and num_background_buffers options are ignored.
+ */
+struct read_options {
+	/**
+	 * @brief Size of a single read buffer in bytes.
+	 * The file is read and fed to the parser by chunks of this size.
+	 */
+	size_t chunk_size = size_t(utki::kilobyte) * 4;
+
+	/**
+	 * @brief Number of read buffers used by background I/O thread.
+	 * If 0, then the file is read from the calling thread, i.e. reading
+	 * and parsing of the read data alternate.
+	 * Otherwise, a separate I/O thread fills up to the given number of buffers
+	 * in advance while the calling thread parses the already read ones,
+	 * so that I/O latency overlaps with parsing time.
+	 * This is beneficial for slow files, like ones located on network filesystems or pipes.
+	 */
+	unsigned num_background_buffers = 0;
+
+	/**
+	 * @brief Object to store parsing statistics to.
+	 * If not null, then statistics of parsing the document are collected
+	 * and stored to the pointed object when the reading is complete.
+	 */
+	parser_stats* stats = nullptr;
+
+	/**
+	 * @brief Whether to measure parsing time when collecting statistics.
+	 * See parser::enable_stats() for details.
+	 */
+	bool measure_parsing_time = false;
+
+	/**
+	 * @brief Parsing limits.
+	 * If not null, then the pointed limits are set to the parser before reading.
+	 * Reading fails with limit_exceeded_error in case the document exceeds any of the limits.
+	 * See parser_limits for details.
+	 */
+	const parser_limits* limits = nullptr;
+};
+
+namespace internal {
+// set the stats and limits options to the parser before reading
+void apply_read_options(
+	parser& p, //
+	const read_options& options
+);
+
+// store the collected statistics to the options after reading
+void store_read_stats(
+	const parser& p, //
+	const read_options& options
+);
+} // namespace internal
+
 /**
  * @brief Read JSON document from file.
  * @param fi - file to read the JSON document from.
+ * @param options - reading options.
  * @return the read JSON document.
  */
-value read(const fsif::file& fi);
+value read(
+	const fsif::file& fi, //
+	const read_options& options = {}
+);
+
+/**
+ * @brief Feed JSON document from file to a parser.
+ * Reads the file the same way as read() does, but feeds the data to the given parser
+ * instead of building the document.
+ * @param fi - file to read the JSON document from.
+ * @param p - parser to feed the data to.
+ * @param options - reading options.
+ */
+void read(
+	const fsif::file& fi, //
+	parser& p,
+	const read_options& options = {}
+);
 
 /**
  * @brief Read JSON document from memory.
  * @param data - memory span to read the JSON document from.
+ * @param options - reading options, the stats and limits are used.
  * @return the read JSON document.
  */
-value read(utki::span<const char> data);
+value read(
+	utki::span<const char> data, //
+	const read_options& options = {}
+);
 
 /**
  * @brief Read JSON document from memory.
  * @param data - memory span to read the JSON document from.
+ * @param options - reading options, the stats and limits are used.
  * @return the read JSON document.
  */
-value read(utki::span<const uint8_t> data);
+value read(
+	utki::span<const uint8_t> data, //
+	const read_options& options = {}
+);
+
+/**
+ * @brief Read JSON document from padded memory buffer.
+ * This is the fastest way of reading JSON document, because the parser
+ * is allowed to read past the end of the data when scanning the input.
+ * @param data - memory buffer to read the JSON document from.
+ * @param options - reading options, the stats and limits are used.
+ * @return the read JSON document.
+ */
+value read(
+	const padded_buffer& data, //
+	const read_options& options = {}
+);
 
 /**
  * @brief Read JSON document from string.
@@ -0,0 +1,190 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "dom_parser.hpp"
+
+#include <utki/string.hpp>
+
+using namespace jsondom;
+
+void dom_parser::on_object_start()
+{
+	ASSERT(!this->stack.empty())
+	auto back = this->stack.back();
+	switch (back->get_type()) {
+		case type::array:
+			back->array().emplace_back(type::object);
+			this->stack.push_back(&back->array().back());
+			break;
+		case type::object:
+			back->object()[this->key] = value(type::object);
+			this->stack.push_back(&back->object()[this->key]);
+			this->key.clear();
+			break;
+		default:
+			ASSERT(false)
+			break;
+	}
+}
+
+void dom_parser::on_object_end()
+{
+	this->stack.pop_back();
+}
+
+void dom_parser::on_array_start()
+{
+	ASSERT(!this->stack.empty())
+	auto back = this->stack.back();
+	switch (back->get_type()) {
+		case type::array:
+			back->array().emplace_back(type::array);
+			this->stack.push_back(&back->array().back());
+			break;
+		case type::object:
+			back->object()[this->key] = value(type::array);
+			this->stack.push_back(&back->object()[this->key]);
+			this->key.clear();
+			break;
+		default:
+			ASSERT(false)
+			break;
+	}
+}
+
+void dom_parser::on_array_end()
+{
+	this->stack.pop_back();
+}
+
+void dom_parser::on_key_parsed(utki::span<const char> str)
+{
+	this->key = utki::make_string(str);
+}
+
+void dom_parser::on_string_parsed(utki::span<const char> str)
+{
+	ASSERT(!this->stack.empty())
+	auto back = this->stack.back();
+	switch (back->get_type()) {
+		case type::array:
+			back->array().emplace_back(utki::make_string(str));
+			break;
+		case type::object:
+			back->object()[this->key] = value(utki::make_string(str));
+			this->key.clear();
+			break;
+		default:
+			ASSERT(false)
+			break;
+	}
+}
+
+void dom_parser::on_number_parsed(utki::span<const char> str)
+{
+	ASSERT(!this->stack.empty())
+	auto back = this->stack.back();
+	switch (back->get_type()) {
+		case type::array:
+			back->array().emplace_back(string_number(utki::make_string(str)));
+			break;
+		case type::object:
+			back->object()[this->key] = value(string_number(utki::make_string(str)));
+			this->key.clear();
+			break;
+		default:
+			ASSERT(false)
+			break;
+	}
+}
+
+void dom_parser::on_boolean_parsed(bool b)
+{
+	ASSERT(!this->stack.empty())
+	auto back = this->stack.back();
+	switch (back->get_type()) {
+		case type::array:
+			back->array().emplace_back(b);
+			break;
+		case type::object:
+			back->object()[this->key] = value(b);
+			this->key.clear();
+			break;
+		default:
+			ASSERT(false)
+			break;
+	}
+}
+
+void dom_parser::on_null_parsed()
+{
+	ASSERT(!this->stack.empty())
+	auto back = this->stack.back();
+	switch (back->get_type()) {
+		case type::array:
+			back->array().emplace_back();
+			break;
+		case type::object:
+			back->object()[this->key] = value();
+			this->key.clear();
+			break;
+		default:
+			ASSERT(false)
+			break;
+	}
+}
+
+value dom_parser::release_document()
+{
+	ASSERT(this->stack.size() == 1, [&](auto& o) {
+		o << "this->stack.size() = " << this->stack.size();
+	})
+	ASSERT(this->doc.is<type::array>())
+
+	value ret;
+	if (!this->doc.array().empty()) {
+		ret = std::move(this->doc.array().front());
+	}
+
+	this->reset_document();
+
+	return ret;
+}
+
+void dom_parser::reset_document()
+{
+	// keep allocated memory of the buffers for parsing next documents
+	this->doc.array().clear();
+	this->key.clear();
+	this->stack.clear();
+	this->stack.push_back(&this->doc);
+}
+
+void dom_parser::reset()
+{
+	this->parser::reset();
+	this->reset_document();
+}
@@ -0,0 +1,75 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "dom.hpp"
+#include "parser.hpp"
+
+namespace jsondom {
+
+/**
+ * @brief SAX parser which builds DOM.
+ * Builds the DOM from the parsing events. Besides feeding JSON text to it,
+ * its on_*() methods can be invoked directly by other sources of events,
+ * for example, decoders of binary formats.
+ */
+class dom_parser : public parser
+{
+	// the parsed values are added to this array, so that root value can be of any type
+	value doc{type::array};
+
+	std::string key;
+
+	std::vector<value*> stack = {&this->doc};
+
+	void reset_document();
+
+public:
+	void on_object_start() override;
+	void on_object_end() override;
+	void on_array_start() override;
+	void on_array_end() override;
+	void on_key_parsed(utki::span<const char> str) override;
+	void on_string_parsed(utki::span<const char> str) override;
+	void on_number_parsed(utki::span<const char> str) override;
+	void on_boolean_parsed(bool b) override;
+	void on_null_parsed() override;
+
+	void reset() override;
+
+	/**
+	 * @brief Get the parsed document.
+	 * Moves the parsed document out of the parser and resets the DOM building state.
+	 * @return the parsed document. Null value in case nothing has been parsed.
+	 */
+	value release_document();
+};
+
+} // namespace jsondom
@@ -64,6 +64,40 @@ public:
 	{}
 };
 
+/**
+ * @brief Limit exceeded error.
+ * This exception is thrown during JSON parsing in case
+ * the document exceeds one of the limits set with parser::set_limits().
+ */
+class limit_exceeded_error : public error
+{
+public:
+	/**
+	 * @brief Constructor.
+	 * @param message - human readable error message.
+	 */
+	limit_exceeded_error(std::string message) :
+		error(std::move(message))
+	{}
+};
+
+/**
+ * @brief Malformed binary data error.
+ * This exception is thrown during decoding of binary formats, like CBOR, MessagePack or snapshot,
+ * in case the data is malformed or has no JSON equivalent.
+ */
+class malformed_binary_data_error : public error
+{
+public:
+	/**
+	 * @brief Constructor.
+	 * @param message - human readable error message.
+	 */
+	malformed_binary_data_error(std::string message) :
+		error(std::move(message))
+	{}
+};
+
 /**
  * @brief Unexpected JSON value type error.
  * This error is thrown when a JSON value is accessed as if it was holding a type which it does not hold.
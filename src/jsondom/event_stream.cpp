@@ -0,0 +1,116 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "event_stream.hpp"
+
+using namespace jsondom;
+
+void event_stream::push(
+	event_type type, //
+	utki::span<const char> str,
+	bool boolean
+)
+{
+	if (this->next_event != 0 && this->next_event == this->events.size()) {
+		// all the events have been pulled, reuse the memory
+		this->events.clear();
+		this->text.clear();
+		this->next_event = 0;
+	}
+
+	this->events.push_back({type, boolean, this->text.size(), str.size()});
+	this->text.insert(this->text.end(), str.begin(), str.end());
+}
+
+std::optional<event> event_stream::next()
+{
+	if (this->next_event == this->events.size()) {
+		return std::nullopt;
+	}
+
+	const auto& e = this->events[this->next_event];
+	++this->next_event;
+
+	return event{
+		e.type, //
+		std::string_view(std::next(this->text.data(), ptrdiff_t(e.text_begin)), e.text_size),
+		e.boolean
+	};
+}
+
+void event_stream::reset()
+{
+	this->parser::reset();
+
+	this->events.clear();
+	this->text.clear();
+	this->next_event = 0;
+}
+
+void event_stream::on_object_start()
+{
+	this->push(event_type::object_start);
+}
+
+void event_stream::on_object_end()
+{
+	this->push(event_type::object_end);
+}
+
+void event_stream::on_array_start()
+{
+	this->push(event_type::array_start);
+}
+
+void event_stream::on_array_end()
+{
+	this->push(event_type::array_end);
+}
+
+void event_stream::on_key_parsed(utki::span<const char> str)
+{
+	this->push(event_type::key, str);
+}
+
+void event_stream::on_string_parsed(utki::span<const char> str)
+{
+	this->push(event_type::string, str);
+}
+
+void event_stream::on_number_parsed(utki::span<const char> str)
+{
+	this->push(event_type::number, str);
+}
+
+void event_stream::on_boolean_parsed(bool b)
+{
+	this->push(event_type::boolean, {}, b);
+}
+
+void event_stream::on_null_parsed()
+{
+	this->push(event_type::null);
+}
@@ -0,0 +1,146 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "parser.hpp"
+
+namespace jsondom {
+
+/**
+ * @brief Type of parsing event.
+ * Each event corresponds to one of the parser's on_*() methods.
+ */
+enum class event_type {
+	object_start,
+	object_end,
+	array_start,
+	array_end,
+	key,
+	string,
+	number,
+	boolean,
+	null
+};
+
+/**
+ * @brief Parsing event.
+ */
+struct event {
+	event_type type;
+
+	/**
+	 * @brief Text of key, string or number.
+	 * Empty for other event types.
+	 * Stays valid until next feeding of data to the event stream.
+	 */
+	std::string_view text;
+
+	/**
+	 * @brief Boolean value.
+	 * Only meaningful for event_type::boolean.
+	 */
+	bool boolean = false;
+};
+
+/**
+ * @brief Pull style JSON parser.
+ * Instead of invoking the on_*() methods, the parsing events are queued and can be pulled
+ * from the stream one by one with next(). When next() runs out of events, the next piece of data
+ * should be fed to the stream, for example, as soon as it arrives from a non-blocking socket.
+ * So, the data source does not need to be read from a dedicated thread and
+ * the events consumer does not need to keep its state between on_*() calls.
+ *
+ * Memory used for the queued events and their text is reused once all the queued events are pulled,
+ * so in order to keep the memory usage bounded, all the events should be pulled before feeding next piece of data.
+ *
+ * Typical use:
+ * @code{.cpp}
+ * jsondom::event_stream s;
+ * while (!s.is_complete()) {
+ *     s.feed(receive_some_data());
+ *     while (auto e = s.next()) {
+ *         handle(*e);
+ *     }
+ * }
+ * @endcode
+ */
+class event_stream : public parser
+{
+	struct queued_event {
+		event_type type;
+		bool boolean;
+
+		// position of the event text in the text buffer
+		size_t text_begin;
+		size_t text_size;
+	};
+
+	std::vector<queued_event> events;
+
+	// index of the next event to be pulled
+	size_t next_event = 0;
+
+	std::vector<char> text;
+
+	void push(
+		event_type type, //
+		utki::span<const char> str = {},
+		bool boolean = false
+	);
+
+public:
+	/**
+	 * @brief Pull next parsing event.
+	 * @return next event in case there is one.
+	 * @return std::nullopt in case all the events parsed so far have been pulled already.
+	 *         Use is_complete() to find out if the whole document has been parsed or
+	 *         more data has to be fed.
+	 */
+	std::optional<event> next();
+
+	/**
+	 * @brief Reset the event stream to initial state.
+	 * Drops the queued events as well.
+	 */
+	void reset() override;
+
+	void on_object_start() override;
+	void on_object_end() override;
+	void on_array_start() override;
+	void on_array_end() override;
+	void on_key_parsed(utki::span<const char> str) override;
+	void on_string_parsed(utki::span<const char> str) override;
+	void on_number_parsed(utki::span<const char> str) override;
+	void on_boolean_parsed(bool b) override;
+	void on_null_parsed() override;
+};
+
+} // namespace jsondom
@@ -0,0 +1,472 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "extractor.hpp"
+
+#include <optional>
+#include <stdexcept>
+
+#include <utki/string.hpp>
+
+using namespace std::string_view_literals;
+
+using namespace jsondom;
+
+namespace {
+// nullopt stands for wildcard
+using path_tokens = std::vector<std::optional<std::string>>;
+
+[[noreturn]] void throw_malformed_path(std::string_view path)
+{
+	throw std::invalid_argument(utki::cat(
+		"jsondom::extractor: malformed or unsupported path: "sv, //
+		path
+	));
+}
+
+size_t to_array_index(std::string_view key)
+{
+	// array index must not have leading zeros
+	if (key.empty() || (key.size() > 1 && key.front() == '0')) {
+		return std::string::npos;
+	}
+
+	size_t ret = 0;
+	for (auto c : key) {
+		if (c < '0' || '9' < c) {
+			return std::string::npos;
+		}
+		constexpr auto base = 10;
+		auto digit = size_t(c - '0');
+		if (ret > (std::string::npos - 1 - digit) / base) {
+			return std::string::npos;
+		}
+		ret = ret * base + digit;
+	}
+	return ret;
+}
+
+path_tokens parse_json_pointer(std::string_view path)
+{
+	path_tokens ret;
+
+	if (path.empty()) {
+		return ret;
+	}
+
+	if (path.front() != '/') {
+		throw_malformed_path(path);
+	}
+
+	for (auto i = path.begin(); i != path.end();) {
+		ASSERT(*i == '/')
+		++i;
+
+		std::string token;
+		for (; i != path.end() && *i != '/'; ++i) {
+			if (*i != '~') {
+				token.push_back(*i);
+				continue;
+			}
+			++i;
+			if (i == path.end()) {
+				throw_malformed_path(path);
+			}
+			switch (*i) {
+				case '0':
+					token.push_back('~');
+					break;
+				case '1':
+					token.push_back('/');
+					break;
+				default:
+					throw_malformed_path(path);
+			}
+		}
+
+		if (token == "*"sv) {
+			ret.emplace_back();
+		} else {
+			ret.emplace_back(std::move(token));
+		}
+	}
+
+	return ret;
+}
+
+path_tokens parse_json_path(std::string_view path)
+{
+	ASSERT(!path.empty() && path.front() == '$')
+
+	path_tokens ret;
+
+	for (auto i = std::next(path.begin()); i != path.end();) {
+		if (*i == '.') {
+			++i;
+			if (i != path.end() && *i == '*') {
+				ret.emplace_back();
+				++i;
+				continue;
+			}
+			std::string name;
+			for (; i != path.end() && *i != '.' && *i != '['; ++i) {
+				name.push_back(*i);
+			}
+			// empty name is also the case of unsupported recursive descent operator
+			if (name.empty()) {
+				throw_malformed_path(path);
+			}
+			ret.emplace_back(std::move(name));
+		} else if (*i == '[') {
+			++i;
+			if (i == path.end()) {
+				throw_malformed_path(path);
+			}
+
+			if (*i == '*') {
+				ret.emplace_back();
+				++i;
+			} else if (*i == '\'' || *i == '"') {
+				auto quote = *i;
+				++i;
+				std::string name;
+				for (; i != path.end() && *i != quote; ++i) {
+					if (*i == '\\') {
+						++i;
+						if (i == path.end()) {
+							throw_malformed_path(path);
+						}
+					}
+					name.push_back(*i);
+				}
+				if (i == path.end()) {
+					throw_malformed_path(path);
+				}
+				++i;
+				ret.emplace_back(std::move(name));
+			} else {
+				std::string index;
+				for (; i != path.end() && *i != ']'; ++i) {
+					index.push_back(*i);
+				}
+				if (to_array_index(index) == std::string::npos) {
+					throw_malformed_path(path);
+				}
+				ret.emplace_back(std::move(index));
+			}
+
+			if (i == path.end() || *i != ']') {
+				throw_malformed_path(path);
+			}
+			++i;
+		} else {
+			throw_malformed_path(path);
+		}
+	}
+
+	return ret;
+}
+} // namespace
+
+extractor::extractor(const std::vector<std::string>& paths) :
+	matches(paths.size())
+{
+	this->paths.reserve(paths.size());
+
+	for (const auto& p : paths) {
+		auto tokens = (!p.empty() && p.front() == '$') ? parse_json_path(p) : parse_json_pointer(p);
+
+		auto& segments = this->paths.emplace_back();
+		segments.reserve(tokens.size());
+		for (auto& t : tokens) {
+			auto& s = segments.emplace_back();
+			if (t.has_value()) {
+				s.index = to_array_index(t.value());
+				s.key = std::move(t.value());
+			} else {
+				s.wildcard = true;
+				s.index = std::string::npos;
+			}
+		}
+	}
+}
+
+void extractor::on_match(
+	size_t path_index, //
+	value v
+)
+{
+	ASSERT(path_index < this->matches.size())
+	this->matches[path_index].push_back(std::move(v));
+}
+
+std::vector<std::vector<value>> extractor::release_matches()
+{
+	auto ret = std::move(this->matches);
+	this->matches = decltype(this->matches)(this->paths.size());
+	return ret;
+}
+
+void extractor::reset()
+{
+	this->parser::reset();
+
+	this->frames.clear();
+	this->skip_depth = 0;
+	for (auto& c : this->captures) {
+		this->return_builder(std::move(c.builder));
+	}
+	this->captures.clear();
+	for (auto& m : this->matches) {
+		m.clear();
+	}
+}
+
+std::unique_ptr<dom_parser> extractor::take_builder()
+{
+	if (this->free_builders.empty()) {
+		return std::make_unique<dom_parser>();
+	}
+	auto ret = std::move(this->free_builders.back());
+	this->free_builders.pop_back();
+	return ret;
+}
+
+void extractor::return_builder(std::unique_ptr<dom_parser> builder)
+{
+	ASSERT(builder)
+	builder->reset();
+	this->free_builders.push_back(std::move(builder));
+}
+
+void extractor::on_value_start(
+	bool is_container, //
+	bool is_array
+)
+{
+	// paths which end at this value
+	std::vector<size_t> complete;
+
+	// paths which go deeper into this value
+	std::vector<size_t> continuing;
+
+	if (this->skip_depth == 0) {
+		if (this->frames.empty()) {
+			// root value
+			for (size_t p = 0; p != this->paths.size(); ++p) {
+				if (this->paths[p].empty()) {
+					complete.push_back(p);
+				} else if (is_container) {
+					continuing.push_back(p);
+				}
+			}
+		} else {
+			auto& parent = this->frames.back();
+			auto depth = this->frames.size() - 1;
+
+			for (auto p : parent.active_paths) {
+				const auto& path = this->paths[p];
+				ASSERT(path.size() > depth)
+				const auto& s = path[depth];
+
+				if (!s.wildcard && (parent.is_array ? s.index != parent.index : s.key != parent.key)) {
+					continue;
+				}
+
+				if (path.size() == depth + 1) {
+					complete.push_back(p);
+				} else if (is_container) {
+					continuing.push_back(p);
+				}
+			}
+
+			if (parent.is_array) {
+				++parent.index;
+			}
+		}
+	}
+
+	if (!complete.empty()) {
+		auto& c = this->captures.emplace_back();
+		c.path_indices = std::move(complete);
+		c.builder = this->take_builder();
+	}
+
+	if (!is_container) {
+		return;
+	}
+
+	if (continuing.empty()) {
+		++this->skip_depth;
+		return;
+	}
+
+	auto& f = this->frames.emplace_back();
+	f.is_array = is_array;
+	f.active_paths = std::move(continuing);
+}
+
+void extractor::finish_capture()
+{
+	ASSERT(!this->captures.empty())
+	ASSERT(this->captures.back().depth == 0)
+
+	auto c = std::move(this->captures.back());
+	this->captures.pop_back();
+
+	auto v = c.builder->release_document();
+	this->return_builder(std::move(c.builder));
+
+	for (auto i = c.path_indices.begin(); i != c.path_indices.end(); ++i) {
+		if (std::next(i) == c.path_indices.end()) {
+			this->on_match(*i, std::move(v));
+		} else {
+			this->on_match(*i, v);
+		}
+	}
+}
+
+void extractor::on_scalar_parsed()
+{
+	// only capture started at this scalar value can be complete
+	if (!this->captures.empty() && this->captures.back().depth == 0) {
+		this->finish_capture();
+	}
+}
+
+void extractor::on_container_end()
+{
+	for (auto& c : this->captures) {
+		ASSERT(c.depth != 0)
+		--c.depth;
+	}
+
+	// captures are nested in each other, so the innermost ones end first
+	while (!this->captures.empty() && this->captures.back().depth == 0) {
+		this->finish_capture();
+	}
+
+	if (this->skip_depth != 0) {
+		--this->skip_depth;
+	} else {
+		ASSERT(!this->frames.empty())
+		this->frames.pop_back();
+	}
+}
+
+void extractor::on_object_start()
+{
+	this->on_value_start(true, false);
+	this->forward([](parser& p) {
+		p.on_object_start();
+	});
+	for (auto& c : this->captures) {
+		++c.depth;
+	}
+}
+
+void extractor::on_object_end()
+{
+	this->forward([](parser& p) {
+		p.on_object_end();
+	});
+	this->on_container_end();
+}
+
+void extractor::on_array_start()
+{
+	this->on_value_start(true, true);
+	this->forward([](parser& p) {
+		p.on_array_start();
+	});
+	for (auto& c : this->captures) {
+		++c.depth;
+	}
+}
+
+void extractor::on_array_end()
+{
+	this->forward([](parser& p) {
+		p.on_array_end();
+	});
+	this->on_container_end();
+}
+
+void extractor::on_key_parsed(utki::span<const char> str)
+{
+	this->forward([&str](parser& p) {
+		p.on_key_parsed(str);
+	});
+	if (this->skip_depth == 0 && !this->frames.empty()) {
+		this->frames.back().key.assign(str.data(), str.size());
+	}
+}
+
+void extractor::on_string_parsed(utki::span<const char> str)
+{
+	this->on_value_start(false, false);
+	this->forward([&str](parser& p) {
+		p.on_string_parsed(str);
+	});
+	this->on_scalar_parsed();
+}
+
+void extractor::on_number_parsed(utki::span<const char> str)
+{
+	this->on_value_start(false, false);
+	this->forward([&str](parser& p) {
+		p.on_number_parsed(str);
+	});
+	this->on_scalar_parsed();
+}
+
+void extractor::on_boolean_parsed(bool b)
+{
+	this->on_value_start(false, false);
+	this->forward([b](parser& p) {
+		p.on_boolean_parsed(b);
+	});
+	this->on_scalar_parsed();
+}
+
+void extractor::on_null_parsed()
+{
+	this->on_value_start(false, false);
+	this->forward([](parser& p) {
+		p.on_null_parsed();
+	});
+	this->on_scalar_parsed();
+}
+
+std::vector<std::vector<value>> jsondom::extract(
+	utki::span<const char> data, //
+	const std::vector<std::string>& paths
+)
+{
+	extractor e(paths);
+	e.feed(data);
+	return e.release_matches();
+}
@@ -0,0 +1,168 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dom.hpp"
+#include "dom_parser.hpp"
+#include "parser.hpp"
+
+namespace jsondom {
+
+/**
+ * @brief SAX parser which extracts values at given paths.
+ * The paths are evaluated against the parsing events as the document is being parsed.
+ * Only the values at the given paths are materialized into value objects,
+ * the rest of the document is skipped without building any values.
+ *
+ * The paths can be given in JSON Pointer (RFC 6901) or in JSONPath notation:
+ * - JSON Pointer: "" (the whole document), "/quotes/quote/0/last", escape sequences "~0" and "~1" are supported.
+ *   As an extension, the "*" reference token matches any object member or array element.
+ * - JSONPath: "$" (the whole document), "$.quotes.quote[*].last", "$['quotes']["quote"][0].last".
+ *   Only child member (".name", ".*", "['name']") and array element ("[0]", "[*]") selectors are supported.
+ *
+ * Values matched by several paths, or nested in each other, are reported separately for each path.
+ * Since the parser events can also be generated by binary format decoders, the extractor
+ * can be fed with events from, for example, read_cbor().
+ */
+class extractor : public parser
+{
+	struct segment {
+		bool wildcard = false;
+		std::string key;
+
+		// the key as array index, npos if the key is not an array index
+		size_t index;
+	};
+
+	std::vector<std::vector<segment>> paths;
+
+	struct frame {
+		bool is_array;
+		size_t index = 0;
+		std::string key;
+
+		// indices of paths which match the path to the current container
+		std::vector<size_t> active_paths;
+	};
+
+	std::vector<frame> frames;
+
+	// number of nested containers being skipped
+	size_t skip_depth = 0;
+
+	struct capture {
+		std::vector<size_t> path_indices;
+		std::unique_ptr<dom_parser> builder;
+		size_t depth = 0;
+	};
+
+	std::vector<capture> captures;
+
+	// builders of finished captures, reused by next captures to avoid allocating a builder per match
+	std::vector<std::unique_ptr<dom_parser>> free_builders;
+
+	std::unique_ptr<dom_parser> take_builder();
+	void return_builder(std::unique_ptr<dom_parser> builder);
+
+	std::vector<std::vector<value>> matches;
+
+	void on_value_start(bool is_container, bool is_array);
+	void finish_capture();
+	void on_scalar_parsed();
+	void on_container_end();
+
+	template <typename callback_type>
+	void forward(const callback_type& callback)
+	{
+		for (auto& c : this->captures) {
+			callback(*c.builder);
+		}
+	}
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param paths - paths to extract values at, in JSON Pointer or JSONPath notation.
+	 * @throw std::invalid_argument in case some of the paths is malformed or unsupported.
+	 */
+	explicit extractor(const std::vector<std::string>& paths);
+
+	/**
+	 * @brief Invoked when a value matching one of the paths has been parsed.
+	 * Default implementation stores the value to be retrieved with release_matches().
+	 * @param path_index - index of the matched path in the list of paths given to constructor.
+	 * @param v - the matched value.
+	 */
+	virtual void on_match(
+		size_t path_index, //
+		value v
+	);
+
+	/**
+	 * @brief Get the values stored by default implementation of on_match().
+	 * Moves the stored values out of the extractor.
+	 * @return list of matched values, in document order, for each path.
+	 */
+	std::vector<std::vector<value>> release_matches();
+
+	/**
+	 * @brief Reset the extractor to initial state.
+	 * Drops the stored matched values as well.
+	 */
+	void reset() override;
+
+	void on_object_start() override;
+	void on_object_end() override;
+	void on_array_start() override;
+	void on_array_end() override;
+	void on_key_parsed(utki::span<const char> str) override;
+	void on_string_parsed(utki::span<const char> str) override;
+	void on_number_parsed(utki::span<const char> str) override;
+	void on_boolean_parsed(bool b) override;
+	void on_null_parsed() override;
+};
+
+/**
+ * @brief Extract values at given paths from JSON document.
+ * See extractor class for supported path notations.
+ * @param data - JSON document.
+ * @param paths - paths to extract values at, in JSON Pointer or JSONPath notation.
+ * @return list of matched values, in document order, for each path.
+ * @throw std::invalid_argument in case some of the paths is malformed or unsupported.
+ * @throw malformed_json_error in case the JSON document is malformed.
+ */
+std::vector<std::vector<value>> extract(
+	utki::span<const char> data, //
+	const std::vector<std::string>& paths
+);
+
+} // namespace jsondom
@@ -0,0 +1,389 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "lazy.hpp"
+
+#include <atomic>
+#include <mutex>
+
+#include <utki/string.hpp>
+
+#include "dom_parser.hpp"
+#include "parser.hpp"
+
+using namespace std::string_view_literals;
+
+using namespace jsondom;
+
+struct lazy_value::container {
+	// the whole document text
+	std::shared_ptr<const std::string> text;
+
+	// location of the object or array in the text, including the brackets
+	size_t begin;
+	size_t end;
+
+	bool is_object;
+
+	mutable std::atomic<bool> is_parsed = false;
+	mutable std::mutex parse_mutex;
+	mutable object_type object;
+	mutable array_type array;
+
+	container(
+		std::shared_ptr<const std::string> text, //
+		size_t begin,
+		size_t end,
+		bool is_object
+	) :
+		text(std::move(text)),
+		begin(begin),
+		end(end),
+		is_object(is_object)
+	{}
+
+	std::string_view view() const
+	{
+		return std::string_view(*this->text).substr(this->begin, this->end - this->begin);
+	}
+
+	void parse() const;
+};
+
+namespace {
+// Returns position of the closing quote.
+size_t skip_string(
+	std::string_view text, //
+	size_t quote_pos
+)
+{
+	ASSERT(text[quote_pos] == '"')
+	for (size_t i = quote_pos + 1; i < text.size(); ++i) {
+		switch (text[i]) {
+			case '\\':
+				++i;
+				break;
+			case '"':
+				return i;
+			default:
+				break;
+		}
+	}
+	throw malformed_json_error("jsondom: unterminated string");
+}
+
+// Returns position right after the bracket matching the opening one.
+size_t find_container_end(
+	std::string_view text, //
+	size_t begin
+)
+{
+	ASSERT(text[begin] == '{' || text[begin] == '[')
+
+	size_t depth = 0;
+	for (size_t i = begin; i != text.size(); ++i) {
+		switch (text[i]) {
+			case '"':
+				i = skip_string(text, i);
+				break;
+			case '{':
+			case '[':
+				++depth;
+				break;
+			case '}':
+			case ']':
+				--depth;
+				if (depth == 0) {
+					return i + 1;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	throw malformed_json_error("jsondom: unbalanced brackets");
+}
+
+// the parser can only parse objects at the root level, so the values are wrapped into an object
+constexpr auto wrapper_begin = R"({"":)"sv;
+constexpr auto wrapper_end = "}"sv;
+} // namespace
+
+namespace jsondom {
+// Parses immediate members or elements of a container.
+// The nested containers are replaced by empty ones in the fed text and their
+// actual locations are supplied via the list of nested containers.
+class lazy_parser : public parser
+{
+	const lazy_value::container& c;
+
+	// depth of the parsed container, the wrapper object is at depth 1
+	constexpr static unsigned container_depth = 2;
+
+	unsigned depth = 0;
+
+	std::string key;
+
+	void add(lazy_value v)
+	{
+		if (this->c.is_object) {
+			this->c.object.insert_or_assign(this->key, std::move(v));
+		} else {
+			this->c.array.push_back(std::move(v));
+		}
+	}
+
+	template <typename T>
+	void add_scalar(T&& v)
+	{
+		ASSERT(this->depth == container_depth)
+		lazy_value lv;
+		lv.var = std::forward<T>(v);
+		this->add(std::move(lv));
+	}
+
+	void on_container_start(bool is_object)
+	{
+		++this->depth;
+		if (this->depth != container_depth + 1) {
+			return;
+		}
+
+		ASSERT(this->next_nested < this->nested.size())
+		auto [begin, end] = this->nested[this->next_nested++];
+		this->add(lazy_value(std::make_shared<lazy_value::container>(this->c.text, begin, end, is_object)));
+	}
+
+public:
+	// locations of nested containers in the order of appearance
+	std::vector<std::pair<size_t, size_t>> nested;
+	size_t next_nested = 0;
+
+	lazy_parser(const lazy_value::container& c) :
+		c(c)
+	{}
+
+	void on_object_start() override
+	{
+		this->on_container_start(true);
+	}
+
+	void on_object_end() override
+	{
+		--this->depth;
+	}
+
+	void on_array_start() override
+	{
+		this->on_container_start(false);
+	}
+
+	void on_array_end() override
+	{
+		--this->depth;
+	}
+
+	void on_key_parsed(utki::span<const char> str) override
+	{
+		if (this->depth == container_depth) {
+			this->key.assign(str.data(), str.size());
+		}
+	}
+
+	void on_string_parsed(utki::span<const char> str) override
+	{
+		this->add_scalar(utki::make_string(str));
+	}
+
+	void on_number_parsed(utki::span<const char> str) override
+	{
+		this->add_scalar(string_number(utki::make_string(str)));
+	}
+
+	void on_boolean_parsed(bool b) override
+	{
+		this->add_scalar(b);
+	}
+
+	void on_null_parsed() override
+	{
+		this->add_scalar(nullptr);
+	}
+};
+} // namespace jsondom
+
+void lazy_value::container::parse() const
+{
+	// in case previous attempt has failed
+	this->object.clear();
+	this->array.clear();
+
+	lazy_parser p(*this);
+
+	p.feed(utki::make_span(wrapper_begin.data(), wrapper_begin.size()));
+
+	auto text = this->view();
+
+	// start of the text not yet fed to the parser
+	size_t fed_end = 0;
+
+	// skip own opening bracket
+	for (size_t i = 1; i < text.size(); ++i) {
+		switch (text[i]) {
+			case '"':
+				i = skip_string(text, i);
+				break;
+			case '{':
+			case '[':
+				{
+					auto end = find_container_end(text, i);
+
+					p.feed(utki::make_span(text.data() + fed_end, i - fed_end));
+
+					p.nested.emplace_back(this->begin + i, this->begin + end);
+					auto placeholder = text[i] == '{' ? "{}"sv : "[]"sv;
+					p.feed(utki::make_span(placeholder.data(), placeholder.size()));
+
+					fed_end = end;
+					i = end - 1;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	p.feed(utki::make_span(text.data() + fed_end, text.size() - fed_end));
+	p.feed(utki::make_span(wrapper_end.data(), wrapper_end.size()));
+}
+
+lazy_value::lazy_value(std::shared_ptr<const container> c) :
+	var(std::move(c))
+{}
+
+jsondom::type lazy_value::get_type() const noexcept
+{
+	if (auto c = std::get_if<std::shared_ptr<const container>>(&this->var)) {
+		return (*c)->is_object ? type::object : type::array;
+	}
+	return jsondom::type(this->var.index());
+}
+
+void lazy_value::throw_access_error(type tried_access) const
+{
+	throw unexpected_value_type(utki::cat(
+		"jsondom: could not access "sv, //
+		jsondom::to_string(tried_access),
+		" lazy value, stored value is of another type ("sv,
+		jsondom::to_string(this->get_type()),
+		")"sv
+	));
+}
+
+const lazy_value::container& lazy_value::get_container(jsondom::type json_type) const
+{
+	if (this->get_type() != json_type) {
+		this->throw_access_error(json_type);
+	}
+
+	const auto& c = *std::get<std::shared_ptr<const container>>(this->var);
+
+	// std::call_once() is not used because some implementations of it deadlock in case the callable throws
+	if (!c.is_parsed.load(std::memory_order_acquire)) {
+		std::lock_guard lock(c.parse_mutex);
+		if (!c.is_parsed.load(std::memory_order_relaxed)) {
+			c.parse();
+			c.is_parsed.store(true, std::memory_order_release);
+		}
+	}
+
+	return c;
+}
+
+const lazy_value::object_type& lazy_value::object() const
+{
+	return this->get_container(type::object).object;
+}
+
+const lazy_value::array_type& lazy_value::array() const
+{
+	return this->get_container(type::array).array;
+}
+
+value lazy_value::to_value() const
+{
+	switch (this->get_type()) {
+		default:
+		case type::null:
+			return {};
+		case type::boolean:
+			return {this->boolean()};
+		case type::number:
+			return {this->number()};
+		case type::string:
+			return {this->string()};
+		case type::object:
+		case type::array:
+			{
+				dom_parser p;
+				p.feed(utki::make_span(wrapper_begin.data(), wrapper_begin.size()));
+				auto text = std::get<std::shared_ptr<const container>>(this->var)->view();
+				p.feed(utki::make_span(text.data(), text.size()));
+				p.feed(utki::make_span(wrapper_end.data(), wrapper_end.size()));
+				return std::move(p.release_document().object().begin()->second);
+			}
+	}
+}
+
+lazy_value jsondom::read_lazy(std::string data)
+{
+	auto text = std::make_shared<const std::string>(std::move(data));
+
+	constexpr auto whitespace = " \t\n\r"sv;
+
+	auto begin = text->find_first_not_of(whitespace);
+	if (begin == std::string::npos || (*text)[begin] != '{') {
+		throw malformed_json_error("jsondom::read_lazy(): root value is not an object");
+	}
+
+	auto end = find_container_end(*text, begin);
+
+	if (text->find_first_not_of(whitespace, end) != std::string::npos) {
+		throw malformed_json_error("jsondom::read_lazy(): unexpected data after the root object");
+	}
+
+	return {std::make_shared<lazy_value::container>(std::move(text), begin, end, true)};
+}
+
+lazy_value jsondom::read_lazy(utki::span<const char> data)
+{
+	return read_lazy(utki::make_string(data));
+}
+
+lazy_value jsondom::read_lazy(const fsif::file& fi)
+{
+	return read_lazy(utki::to_char(utki::make_span(fi.load())));
+}
@@ -0,0 +1,234 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <fsif/file.hpp>
+#include <utki/span.hpp>
+
+#include "dom.hpp"
+
+namespace jsondom {
+
+/**
+ * @brief Lazily parsed JSON value.
+ * Read-only counterpart of jsondom::value which parses its contents on demand.
+ * When an object or an array is parsed, only its immediate members or elements are parsed,
+ * the nested objects and arrays are only skipped over by bracket matching, recording their location in the text.
+ * Those are parsed when their object() or array() is first called.
+ * Values of other types are parsed along with their parent.
+ *
+ * Copying the lazy value is cheap, the copies share the parsed contents along with the document text.
+ * Concurrent access to the lazy value and its copies from several threads is safe, since the value is not modifiable.
+ */
+class lazy_value
+{
+	friend class lazy_parser;
+	friend lazy_value read_lazy(std::string data);
+
+public:
+	using object_type = std::map<
+		std::string, //
+		lazy_value,
+		std::less<> //
+		>;
+
+	using array_type = std::vector<lazy_value>;
+
+private:
+	struct container;
+
+	std::variant<
+		std::nullptr_t, //
+		bool,
+		string_number,
+		std::string,
+		std::shared_ptr<const container> //
+		>
+		var;
+
+	const container& get_container(jsondom::type json_type) const;
+
+	void throw_access_error(jsondom::type tried_access) const;
+
+	template <jsondom::type json_type>
+	void throw_if_type_is_not() const
+	{
+		if (!this->is<json_type>()) {
+			this->throw_access_error(json_type);
+		}
+	}
+
+	lazy_value(std::shared_ptr<const container> c);
+
+public:
+	/**
+	 * @brief Construct null value.
+	 */
+	lazy_value() = default;
+
+	/**
+	 * @brief Get value type.
+	 * @return value type.
+	 */
+	jsondom::type get_type() const noexcept;
+
+	/**
+	 * @brief Check that the value is of the given type.
+	 * @return true if the value is of the given type.
+	 * @return false otherwise.
+	 */
+	template <jsondom::type json_type>
+	bool is() const noexcept
+	{
+		return this->get_type() == json_type;
+	}
+
+	bool is_null() const noexcept
+	{
+		return this->is<type::null>();
+	}
+
+	bool is_boolean() const noexcept
+	{
+		return this->is<type::boolean>();
+	}
+
+	bool is_number() const noexcept
+	{
+		return this->is<type::number>();
+	}
+
+	bool is_string() const noexcept
+	{
+		return this->is<type::string>();
+	}
+
+	bool is_array() const noexcept
+	{
+		return this->is<type::array>();
+	}
+
+	bool is_object() const noexcept
+	{
+		return this->is<type::object>();
+	}
+
+	/**
+	 * @brief Get boolean value.
+	 * @return the boolean value.
+	 * @throw unexpected_value_type in case the stored value is not a boolean.
+	 */
+	bool boolean() const
+	{
+		this->throw_if_type_is_not<type::boolean>();
+		return std::get<bool>(this->var);
+	}
+
+	/**
+	 * @brief Get number value.
+	 * @return constant reference to the number value.
+	 * @throw unexpected_value_type in case the stored value is not a number.
+	 */
+	const string_number& number() const
+	{
+		this->throw_if_type_is_not<type::number>();
+		return std::get<string_number>(this->var);
+	}
+
+	/**
+	 * @brief Get string value.
+	 * @return constant reference to the string value.
+	 * @throw unexpected_value_type in case the stored value is not a string.
+	 */
+	const std::string& string() const
+	{
+		this->throw_if_type_is_not<type::string>();
+		return std::get<std::string>(this->var);
+	}
+
+	/**
+	 * @brief Get object value.
+	 * Parses the object on first call.
+	 * @return constant reference to the object members.
+	 * @throw unexpected_value_type in case the stored value is not an object.
+	 * @throw malformed_json_error in case the object text is malformed.
+	 */
+	const object_type& object() const;
+
+	/**
+	 * @brief Get array value.
+	 * Parses the array on first call.
+	 * @return constant reference to the array elements.
+	 * @throw unexpected_value_type in case the stored value is not an array.
+	 * @throw malformed_json_error in case the array text is malformed.
+	 */
+	const array_type& array() const;
+
+	/**
+	 * @brief Convert to value.
+	 * Parses the whole value tree, regardless of which parts of it are already parsed lazily.
+	 * @return the value tree.
+	 * @throw malformed_json_error in case the value text is malformed.
+	 */
+	value to_value() const;
+};
+
+/**
+ * @brief Read JSON document lazily.
+ * Only checks that the brackets of the root object are balanced,
+ * the document is parsed on demand as it is accessed. Malformed contents of nested objects and arrays
+ * are only detected when those are accessed.
+ * @param data - JSON document. The lazy value tree keeps the document text.
+ * @return lazy root value.
+ * @throw malformed_json_error in case the root object brackets are unbalanced.
+ */
+lazy_value read_lazy(std::string data);
+
+/**
+ * @brief Read JSON document lazily.
+ * @param data - JSON document. The lazy value tree keeps a copy of the document text.
+ * @return lazy root value.
+ * @throw malformed_json_error in case the root object brackets are unbalanced.
+ */
+lazy_value read_lazy(utki::span<const char> data);
+
+/**
+ * @brief Read JSON document lazily from file.
+ * The whole file is loaded to memory.
+ * @param fi - file to read the JSON document from.
+ * @return lazy root value.
+ * @throw malformed_json_error in case the root object brackets are unbalanced.
+ */
+lazy_value read_lazy(const fsif::file& fi);
+
+} // namespace jsondom
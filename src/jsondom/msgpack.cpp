@@ -0,0 +1,598 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "msgpack.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <utki/string.hpp>
+
+#include "binary_number.hpp"
+#include "dom_parser.hpp"
+
+using namespace std::string_view_literals;
+
+using namespace jsondom;
+
+namespace {
+constexpr auto byte_bits = std::numeric_limits<uint8_t>::digits;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+constexpr uint8_t positive_fixint_max = 0x7f;
+constexpr uint8_t fixmap = 0x80;
+constexpr uint8_t fixmap_max = 0x8f;
+constexpr uint8_t fixarray = 0x90;
+constexpr uint8_t fixarray_max = 0x9f;
+constexpr uint8_t fixstr = 0xa0;
+constexpr uint8_t fixstr_max = 0xbf;
+constexpr uint8_t nil = 0xc0;
+constexpr uint8_t false_byte = 0xc2;
+constexpr uint8_t true_byte = 0xc3;
+constexpr uint8_t bin8 = 0xc4;
+constexpr uint8_t bin16 = 0xc5;
+constexpr uint8_t bin32 = 0xc6;
+constexpr uint8_t ext8 = 0xc7;
+constexpr uint8_t ext16 = 0xc8;
+constexpr uint8_t ext32 = 0xc9;
+constexpr uint8_t float32 = 0xca;
+constexpr uint8_t float64 = 0xcb;
+constexpr uint8_t uint8 = 0xcc;
+constexpr uint8_t uint16 = 0xcd;
+constexpr uint8_t uint32 = 0xce;
+constexpr uint8_t uint64 = 0xcf;
+constexpr uint8_t int8 = 0xd0;
+constexpr uint8_t int16 = 0xd1;
+constexpr uint8_t int32 = 0xd2;
+constexpr uint8_t int64 = 0xd3;
+constexpr uint8_t fixext1 = 0xd4;
+constexpr uint8_t fixext2 = 0xd5;
+constexpr uint8_t fixext4 = 0xd6;
+constexpr uint8_t fixext8 = 0xd7;
+constexpr uint8_t fixext16 = 0xd8;
+constexpr uint8_t str8 = 0xd9;
+constexpr uint8_t str16 = 0xda;
+constexpr uint8_t str32 = 0xdb;
+constexpr uint8_t array16 = 0xdc;
+constexpr uint8_t array32 = 0xdd;
+constexpr uint8_t map16 = 0xde;
+constexpr uint8_t map32 = 0xdf;
+constexpr uint8_t negative_fixint = 0xe0;
+
+constexpr uint8_t fixstr_max_length = 31;
+constexpr uint8_t fixcontainer_max_size = 15;
+constexpr int8_t negative_fixint_min = -32;
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+constexpr auto flush_threshold = size_t(utki::kilobyte) * 64;
+
+// protects decoder from stack overflow on malicious input
+constexpr auto max_nesting_depth = 1024;
+} // namespace
+
+namespace {
+class msgpack_encoder
+{
+	fsif::file* fi;
+
+public:
+	std::vector<uint8_t> buf;
+
+	msgpack_encoder(fsif::file* fi = nullptr) :
+		fi(fi)
+	{}
+
+	void flush()
+	{
+		if (!this->fi) {
+			return;
+		}
+		this->fi->write(utki::make_span(this->buf));
+		this->buf.clear();
+	}
+
+	void write_big_endian(uint64_t value, size_t num_bytes)
+	{
+		for (size_t i = num_bytes; i != 0; --i) {
+			this->buf.push_back(uint8_t(value >> ((i - 1) * byte_bits)));
+		}
+	}
+
+	// write the first byte and the size of str, bin, ext, array or map
+	void write_size(uint8_t byte8, uint8_t byte16, uint8_t byte32, uint64_t size)
+	{
+		if (size <= std::numeric_limits<uint8_t>::max() && byte8 != 0) {
+			this->buf.push_back(byte8);
+			this->write_big_endian(size, sizeof(uint8_t));
+		} else if (size <= std::numeric_limits<uint16_t>::max()) {
+			this->buf.push_back(byte16);
+			this->write_big_endian(size, sizeof(uint16_t));
+		} else if (size <= std::numeric_limits<uint32_t>::max()) {
+			this->buf.push_back(byte32);
+			this->write_big_endian(size, sizeof(uint32_t));
+		} else {
+			throw std::length_error("jsondom: too big value for MessagePack");
+		}
+	}
+
+	void write_string(std::string_view str)
+	{
+		if (str.size() <= fixstr_max_length) {
+			this->buf.push_back(uint8_t(fixstr | str.size()));
+		} else {
+			this->write_size(str8, str16, str32, str.size());
+		}
+		this->buf.insert(this->buf.end(), str.begin(), str.end());
+	}
+
+	void write_unsigned(uint64_t value)
+	{
+		if (value <= positive_fixint_max) {
+			this->buf.push_back(uint8_t(value));
+		} else if (value <= std::numeric_limits<uint8_t>::max()) {
+			this->buf.push_back(uint8);
+			this->write_big_endian(value, sizeof(uint8_t));
+		} else if (value <= std::numeric_limits<uint16_t>::max()) {
+			this->buf.push_back(uint16);
+			this->write_big_endian(value, sizeof(uint16_t));
+		} else if (value <= std::numeric_limits<uint32_t>::max()) {
+			this->buf.push_back(uint32);
+			this->write_big_endian(value, sizeof(uint32_t));
+		} else {
+			this->buf.push_back(uint64);
+			this->write_big_endian(value, sizeof(uint64_t));
+		}
+	}
+
+	void write_signed(int64_t value)
+	{
+		ASSERT(value < 0)
+		if (value >= negative_fixint_min) {
+			this->buf.push_back(uint8_t(value));
+		} else if (value >= std::numeric_limits<int8_t>::min()) {
+			this->buf.push_back(int8);
+			this->write_big_endian(uint64_t(value), sizeof(int8_t));
+		} else if (value >= std::numeric_limits<int16_t>::min()) {
+			this->buf.push_back(int16);
+			this->write_big_endian(uint64_t(value), sizeof(int16_t));
+		} else if (value >= std::numeric_limits<int32_t>::min()) {
+			this->buf.push_back(int32);
+			this->write_big_endian(uint64_t(value), sizeof(int32_t));
+		} else {
+			this->buf.push_back(int64);
+			this->write_big_endian(uint64_t(value), sizeof(int64_t));
+		}
+	}
+
+	void write_number(const string_number& num)
+	{
+		const auto& str = num.get_string();
+		auto bn = internal::to_binary_number(str);
+		switch (bn.kind) {
+			case internal::binary_number_kind::unsigned_integer:
+				this->write_unsigned(bn.uint);
+				return;
+			case internal::binary_number_kind::negative_integer:
+				// value is -1 - bn.uint
+				if (bn.uint <= uint64_t(std::numeric_limits<int64_t>::max())) {
+					this->write_signed(-1 - int64_t(bn.uint));
+					return;
+				}
+				break;
+			case internal::binary_number_kind::floating:
+				{
+					uint64_t bits = 0;
+					static_assert(sizeof(bits) == sizeof(bn.floating));
+					std::memcpy(&bits, &bn.floating, sizeof(bits));
+					this->buf.push_back(float64);
+					this->write_big_endian(bits, sizeof(bits));
+				}
+				return;
+			case internal::binary_number_kind::text:
+				break;
+		}
+
+		// number cannot be represented exactly, write it as text
+		this->write_size(ext8, ext16, ext32, str.size());
+		this->buf.push_back(uint8_t(msgpack_number_ext_type));
+		this->buf.insert(this->buf.end(), str.begin(), str.end());
+	}
+
+	void write(const value& v)
+	{
+		switch (v.get_type()) {
+			default:
+			case type::null:
+				this->buf.push_back(nil);
+				break;
+			case type::boolean:
+				this->buf.push_back(v.boolean() ? true_byte : false_byte);
+				break;
+			case type::number:
+				this->write_number(v.number());
+				break;
+			case type::string:
+				this->write_string(v.string());
+				break;
+			case type::array:
+				if (v.array().size() <= fixcontainer_max_size) {
+					this->buf.push_back(uint8_t(fixarray | v.array().size()));
+				} else {
+					this->write_size(0, array16, array32, v.array().size());
+				}
+				for (const auto& e : v.array()) {
+					this->write(e);
+					if (this->buf.size() >= flush_threshold) {
+						this->flush();
+					}
+				}
+				break;
+			case type::object:
+				if (v.object().size() <= fixcontainer_max_size) {
+					this->buf.push_back(uint8_t(fixmap | v.object().size()));
+				} else {
+					this->write_size(0, map16, map32, v.object().size());
+				}
+				for (const auto& kv : v.object()) {
+					this->write_string(kv.first);
+					this->write(kv.second);
+					if (this->buf.size() >= flush_threshold) {
+						this->flush();
+					}
+				}
+				break;
+		}
+	}
+};
+} // namespace
+
+void jsondom::write_msgpack(
+	fsif::file& fi, //
+	const value& v
+)
+{
+	fsif::file::guard file_guard(
+		fi, //
+		fsif::mode::create
+	);
+
+	msgpack_encoder e(&fi);
+	e.write(v);
+	e.flush();
+}
+
+std::vector<uint8_t> jsondom::to_msgpack(const value& v)
+{
+	msgpack_encoder e;
+	e.write(v);
+	return std::move(e.buf);
+}
+
+namespace {
+class msgpack_decoder
+{
+	utki::span<const uint8_t> data;
+	size_t pos = 0;
+
+	parser& p;
+
+	[[noreturn]] void throw_malformed(std::string_view message)
+	{
+		throw malformed_binary_data_error(utki::cat(
+			"jsondom: malformed MessagePack data at offset "sv, //
+			this->pos,
+			": "sv,
+			message
+		));
+	}
+
+	uint8_t read_byte()
+	{
+		if (this->pos == this->data.size()) {
+			this->throw_malformed("unexpected end of data"sv);
+		}
+		return this->data[this->pos++];
+	}
+
+	uint64_t read_big_endian(size_t num_bytes)
+	{
+		if (this->data.size() - this->pos < num_bytes) {
+			this->throw_malformed("unexpected end of data"sv);
+		}
+		uint64_t ret = 0;
+		for (size_t i = 0; i != num_bytes; ++i) {
+			ret = (ret << byte_bits) | this->data[this->pos++];
+		}
+		return ret;
+	}
+
+	int64_t read_signed(size_t num_bytes)
+	{
+		auto u = this->read_big_endian(num_bytes);
+		// sign extend
+		auto shift = (sizeof(uint64_t) - num_bytes) * byte_bits;
+		return int64_t(u << shift) >> shift;
+	}
+
+	utki::span<const char> read_bytes(uint64_t length)
+	{
+		if (this->data.size() - this->pos < length) {
+			this->throw_malformed("unexpected end of data"sv);
+		}
+		auto ret = utki::to_char(this->data.subspan(this->pos, size_t(length)));
+		this->pos += size_t(length);
+		return ret;
+	}
+
+	void notify_number(const std::string& str)
+	{
+		this->p.on_number_parsed(utki::make_span(str));
+	}
+
+	void notify_float(double d)
+	{
+		if (!std::isfinite(d)) {
+			this->throw_malformed("non-finite floating point number has no JSON equivalent"sv);
+		}
+		this->notify_number(internal::format_double(d));
+	}
+
+	void notify_signed(int64_t value)
+	{
+		if (value < 0) {
+			this->notify_number(internal::format_negative_integer(uint64_t(-1 - value)));
+		} else {
+			this->notify_number(std::to_string(value));
+		}
+	}
+
+	void notify_ext(uint64_t length)
+	{
+		auto type = int8_t(this->read_byte());
+		if (type != msgpack_number_ext_type) {
+			this->throw_malformed("extension type has no JSON equivalent"sv);
+		}
+		auto str = this->read_bytes(length);
+		if (!internal::is_valid_number(std::string_view(str.data(), str.size()))) {
+			this->throw_malformed("number extension content is not a valid number"sv);
+		}
+		this->p.on_number_parsed(str);
+	}
+
+	void decode_array(uint64_t size, unsigned depth)
+	{
+		this->p.on_array_start();
+		for (; size != 0; --size) {
+			this->decode_item(depth + 1);
+		}
+		this->p.on_array_end();
+	}
+
+	void decode_map(uint64_t size, unsigned depth)
+	{
+		this->p.on_object_start();
+		for (; size != 0; --size) {
+			this->decode_key();
+			this->decode_item(depth + 1);
+		}
+		this->p.on_object_end();
+	}
+
+	void decode_key()
+	{
+		auto b = this->read_byte();
+		if (fixstr <= b && b <= fixstr_max) {
+			this->p.on_key_parsed(this->read_bytes(b & fixstr_max_length));
+			return;
+		}
+		switch (b) {
+			case str8:
+				this->p.on_key_parsed(this->read_bytes(this->read_big_endian(sizeof(uint8_t))));
+				break;
+			case str16:
+				this->p.on_key_parsed(this->read_bytes(this->read_big_endian(sizeof(uint16_t))));
+				break;
+			case str32:
+				this->p.on_key_parsed(this->read_bytes(this->read_big_endian(sizeof(uint32_t))));
+				break;
+			default:
+				this->throw_malformed("map key is not a string"sv);
+		}
+	}
+
+	void decode_item(unsigned depth)
+	{
+		if (depth > max_nesting_depth) {
+			this->throw_malformed("nesting is too deep"sv);
+		}
+
+		auto b = this->read_byte();
+
+		if (b <= positive_fixint_max) {
+			this->notify_number(std::to_string(b));
+			return;
+		}
+		if (b >= negative_fixint) {
+			this->notify_signed(int8_t(b));
+			return;
+		}
+		if (b <= fixmap_max) {
+			this->decode_map(b & fixcontainer_max_size, depth);
+			return;
+		}
+		if (b <= fixarray_max) {
+			this->decode_array(b & fixcontainer_max_size, depth);
+			return;
+		}
+		if (b <= fixstr_max) {
+			this->p.on_string_parsed(this->read_bytes(b & fixstr_max_length));
+			return;
+		}
+
+		switch (b) {
+			case nil:
+				this->p.on_null_parsed();
+				break;
+			case false_byte:
+				this->p.on_boolean_parsed(false);
+				break;
+			case true_byte:
+				this->p.on_boolean_parsed(true);
+				break;
+			case bin8:
+			case bin16:
+			case bin32:
+				this->throw_malformed("binary has no JSON equivalent"sv);
+			case ext8:
+				this->notify_ext(this->read_big_endian(sizeof(uint8_t)));
+				break;
+			case ext16:
+				this->notify_ext(this->read_big_endian(sizeof(uint16_t)));
+				break;
+			case ext32:
+				this->notify_ext(this->read_big_endian(sizeof(uint32_t)));
+				break;
+			case float32:
+				{
+					auto bits = uint32_t(this->read_big_endian(sizeof(uint32_t)));
+					float f = 0;
+					std::memcpy(&f, &bits, sizeof(f));
+					this->notify_float(double(f));
+				}
+				break;
+			case float64:
+				{
+					auto bits = this->read_big_endian(sizeof(uint64_t));
+					double d = 0;
+					std::memcpy(&d, &bits, sizeof(d));
+					this->notify_float(d);
+				}
+				break;
+			case uint8:
+				this->notify_number(std::to_string(this->read_big_endian(sizeof(uint8_t))));
+				break;
+			case uint16:
+				this->notify_number(std::to_string(this->read_big_endian(sizeof(uint16_t))));
+				break;
+			case uint32:
+				this->notify_number(std::to_string(this->read_big_endian(sizeof(uint32_t))));
+				break;
+			case uint64:
+				this->notify_number(std::to_string(this->read_big_endian(sizeof(uint64_t))));
+				break;
+			case int8:
+				this->notify_signed(this->read_signed(sizeof(int8_t)));
+				break;
+			case int16:
+				this->notify_signed(this->read_signed(sizeof(int16_t)));
+				break;
+			case int32:
+				this->notify_signed(this->read_signed(sizeof(int32_t)));
+				break;
+			case int64:
+				this->notify_signed(this->read_signed(sizeof(int64_t)));
+				break;
+			case fixext1:
+				this->notify_ext(1);
+				break;
+			case fixext2:
+				this->notify_ext(2);
+				break;
+			case fixext4:
+				this->notify_ext(4);
+				break;
+			case fixext8:
+				this->notify_ext(8);
+				break;
+			case fixext16:
+				// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+				this->notify_ext(16);
+				break;
+			case str8:
+				this->p.on_string_parsed(this->read_bytes(this->read_big_endian(sizeof(uint8_t))));
+				break;
+			case str16:
+				this->p.on_string_parsed(this->read_bytes(this->read_big_endian(sizeof(uint16_t))));
+				break;
+			case str32:
+				this->p.on_string_parsed(this->read_bytes(this->read_big_endian(sizeof(uint32_t))));
+				break;
+			case array16:
+				this->decode_array(this->read_big_endian(sizeof(uint16_t)), depth);
+				break;
+			case array32:
+				this->decode_array(this->read_big_endian(sizeof(uint32_t)), depth);
+				break;
+			case map16:
+				this->decode_map(this->read_big_endian(sizeof(uint16_t)), depth);
+				break;
+			case map32:
+				this->decode_map(this->read_big_endian(sizeof(uint32_t)), depth);
+				break;
+			default:
+				this->throw_malformed("invalid byte"sv);
+		}
+	}
+
+public:
+	msgpack_decoder(
+		utki::span<const uint8_t> data, //
+		parser& p
+	) :
+		data(data),
+		p(p)
+	{}
+
+	void decode()
+	{
+		this->decode_item(0);
+		if (this->pos != this->data.size()) {
+			this->throw_malformed("extra data after the root object"sv);
+		}
+	}
+};
+} // namespace
+
+void jsondom::read_msgpack(
+	utki::span<const uint8_t> data, //
+	parser& p
+)
+{
+	msgpack_decoder(data, p).decode();
+}
+
+value jsondom::read_msgpack(utki::span<const uint8_t> data)
+{
+	dom_parser p;
+	read_msgpack(data, p);
+	return p.release_document();
+}
+
+value jsondom::read_msgpack(const fsif::file& fi)
+{
+	return read_msgpack(utki::make_span(fi.load()));
+}
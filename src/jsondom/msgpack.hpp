@@ -0,0 +1,96 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <fsif/file.hpp>
+#include <utki/span.hpp>
+
+#include "dom.hpp"
+#include "parser.hpp"
+
+namespace jsondom {
+
+/**
+ * @brief MessagePack extension type for numbers stored as text.
+ * JSON numbers are written to MessagePack as integers or as 64-bit floats when that
+ * represents the number string exactly, i.e. the number string is restored exactly when read back.
+ * Otherwise, the number text is written as extension data of this extension type.
+ */
+constexpr const int8_t msgpack_number_ext_type = 0x4e; // 'N'
+
+/**
+ * @brief Write JSON document to file in MessagePack format.
+ * @param fi - file to write the document to.
+ * @param v - root value of the document to write.
+ */
+void write_msgpack(
+	fsif::file& fi, //
+	const value& v
+);
+
+/**
+ * @brief Encode JSON document to MessagePack format.
+ * @param v - root value of the document to encode.
+ * @return MessagePack encoded document.
+ */
+std::vector<uint8_t> to_msgpack(const value& v);
+
+/**
+ * @brief Read JSON document from MessagePack data.
+ * MessagePack objects which have no JSON equivalent, like binaries, non-string map keys,
+ * non-finite floating point numbers or extensions of type other than msgpack_number_ext_type,
+ * are considered malformed data.
+ * @param data - MessagePack data to read.
+ * @return the read JSON document.
+ * @throw malformed_binary_data_error in case the data is malformed.
+ */
+value read_msgpack(utki::span<const uint8_t> data);
+
+/**
+ * @brief Read JSON document from MessagePack file.
+ * @param fi - file to read the MessagePack data from.
+ * @return the read JSON document.
+ * @throw malformed_binary_data_error in case the data is malformed.
+ */
+value read_msgpack(const fsif::file& fi);
+
+/**
+ * @brief Decode MessagePack data to parser events.
+ * Invokes parser's on_*() callbacks as if equivalent JSON text was fed to the parser.
+ * @param data - MessagePack data to decode.
+ * @param p - parser to invoke callbacks of.
+ * @throw malformed_binary_data_error in case the data is malformed.
+ */
+void read_msgpack(
+	utki::span<const uint8_t> data, //
+	parser& p
+);
+
+} // namespace jsondom
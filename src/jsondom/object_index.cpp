@@ -0,0 +1,51 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "object_index.hpp"
+
+using namespace jsondom;
+
+void object_index::rebuild(const value::object_type& obj)
+{
+	size_t size = 1;
+	while (size < obj.size() * 2) {
+		size <<= 1;
+	}
+
+	this->table.assign(size, entry{0, nullptr});
+
+	auto mask = size - 1;
+	for (const auto& m : obj) {
+		auto hash = internal::key_hash(m.first, 0);
+		for (auto i = size_t(hash) & mask;; i = (i + 1) & mask) {
+			auto& e = this->table[i];
+			if (!e.member) {
+				e = {hash, &m};
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,169 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "describe.hpp"
+#include "dom.hpp"
+
+namespace jsondom {
+
+/**
+ * @brief Object key with precomputed hash.
+ * Intended for looking up the same keys many times with object_index.
+ * When defined as constexpr, the hash is calculated at compile time:
+ * @code{.cpp}
+ * constexpr jsondom::key bid_key = "bid";
+ * @endcode
+ * The key does not own the string, so the string must stay alive while the key is used.
+ */
+class key
+{
+	std::string_view str;
+	uint32_t hash;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param str - key string.
+	 */
+	constexpr key(std::string_view str) :
+		str(str),
+		hash(internal::key_hash(str, 0))
+	{}
+
+	/**
+	 * @brief Constructor.
+	 * @param str - zero terminated key string.
+	 */
+	constexpr key(const char* str) :
+		key(std::string_view(str))
+	{}
+
+	/**
+	 * @brief Constructor.
+	 * @param str - key string.
+	 */
+	key(const std::string& str) :
+		key(std::string_view(str))
+	{}
+
+	/**
+	 * @brief Get key string.
+	 * @return key string.
+	 */
+	constexpr std::string_view get_string() const noexcept
+	{
+		return this->str;
+	}
+
+	/**
+	 * @brief Get key hash.
+	 * @return key hash.
+	 */
+	constexpr uint32_t get_hash() const noexcept
+	{
+		return this->hash;
+	}
+};
+
+/**
+ * @brief Hash index of object members.
+ * Allows looking up object members by precomputed hash keys, in most cases
+ * at the cost of one hash comparison and one string comparison, instead of
+ * several string comparisons of the std::map lookup.
+ * Building the index takes time proportional to the number of object members,
+ * so it pays off in case the same object is looked up several times.
+ *
+ * The index refers to the object's members, so the object must stay alive and must not be
+ * modified while the index is used. After the object is modified the index has to be rebuilt.
+ */
+class object_index
+{
+	struct entry {
+		uint32_t hash;
+		const value::object_type::value_type* member;
+	};
+
+	// open addressing hash table with linear probing, size is a power of two,
+	// load factor is at most 1/2, so there is always an empty entry terminating the probing
+	std::vector<entry> table = std::vector<entry>(1, entry{0, nullptr});
+
+public:
+	object_index() = default;
+
+	/**
+	 * @brief Construct index of the object.
+	 * @param obj - object to index.
+	 */
+	explicit object_index(const value::object_type& obj)
+	{
+		this->rebuild(obj);
+	}
+
+	/**
+	 * @brief Construct index of the object value.
+	 * @param obj - object value to index.
+	 * @throw unexpected_value_type in case the value is not an object.
+	 */
+	explicit object_index(const value& obj) :
+		object_index(obj.object())
+	{}
+
+	/**
+	 * @brief Rebuild the index for another object.
+	 * The memory allocated for the index is reused.
+	 * @param obj - object to index.
+	 */
+	void rebuild(const value::object_type& obj);
+
+	/**
+	 * @brief Find object member.
+	 * @param k - key of the member to find.
+	 * @return pointer to the member value.
+	 * @return nullptr in case there is no member with the given key.
+	 */
+	const value* find(const key& k) const noexcept
+	{
+		auto mask = this->table.size() - 1;
+		for (auto i = size_t(k.get_hash()) & mask;; i = (i + 1) & mask) {
+			const auto& e = this->table[i];
+			if (!e.member) {
+				return nullptr;
+			}
+			if (e.hash == k.get_hash() && e.member->first == k.get_string()) {
+				return &e.member->second;
+			}
+		}
+	}
+};
+
+} // namespace jsondom
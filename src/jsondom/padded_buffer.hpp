@@ -0,0 +1,131 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <utki/span.hpp>
+
+namespace jsondom {
+
+/**
+ * @brief Memory buffer with zeroed trailing padding.
+ * The buffer holds the data followed by padding_size bytes of zeros which are
+ * not part of the data. This allows the parser to read the input data by whole machine words
+ * without checking for the end of the data before each read, because reading past the end
+ * of the data never goes beyond the allocated memory.
+ */
+class padded_buffer
+{
+public:
+	/**
+	 * @brief Number of padding bytes after the end of the data.
+	 */
+	constexpr static const size_t padding_size = 64;
+
+private:
+	std::vector<char> buffer;
+
+public:
+	/**
+	 * @brief Construct buffer of given size.
+	 * The data bytes are initialized to zero.
+	 * @param size - size of the data.
+	 */
+	explicit padded_buffer(size_t size = 0) :
+		buffer(size + padding_size, 0)
+	{}
+
+	/**
+	 * @brief Construct buffer holding a copy of given data.
+	 * @param data - data to copy to the buffer.
+	 */
+	explicit padded_buffer(utki::span<const char> data) :
+		padded_buffer(data.size())
+	{
+		std::copy(data.begin(), data.end(), this->buffer.begin());
+	}
+
+	/**
+	 * @brief Construct buffer holding a copy of given data.
+	 * @param data - data to copy to the buffer.
+	 */
+	explicit padded_buffer(utki::span<const uint8_t> data) :
+		padded_buffer(utki::to_char(data))
+	{}
+
+	/**
+	 * @brief Get data size.
+	 * @return data size, not including padding.
+	 */
+	size_t size() const noexcept
+	{
+		return this->buffer.size() - padding_size;
+	}
+
+	/**
+	 * @brief Change data size.
+	 * Newly added data bytes are initialized to zero.
+	 * @param size - new data size.
+	 */
+	void resize(size_t size)
+	{
+		this->buffer.resize(size + padding_size, 0);
+		std::fill(std::next(this->buffer.begin(), ptrdiff_t(size)), this->buffer.end(), 0);
+	}
+
+	/**
+	 * @brief Get data pointer.
+	 * The data can be modified, for example, filled by receiving it from network.
+	 * @return pointer to the beginning of the data.
+	 */
+	char* data() noexcept
+	{
+		return this->buffer.data();
+	}
+
+	/**
+	 * @brief Get constant data pointer.
+	 * @return pointer to the beginning of the data.
+	 */
+	const char* data() const noexcept
+	{
+		return this->buffer.data();
+	}
+
+	/**
+	 * @brief Get data span.
+	 * @return span of the data, not including padding.
+	 */
+	utki::span<const char> span() const noexcept
+	{
+		return utki::make_span(this->data(), this->size());
+	}
+};
+
+} // namespace jsondom
@@ -26,12 +26,16 @@ SOFTWARE.
 
 #include "parser.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <sstream>
 
 #include <utki/string.hpp>
-#include <utki/unicode.hpp>
 
+#include "binary_number.hpp"
 #include "errors.hpp"
+#include "unicode_escape.hpp"
 
 using namespace jsondom;
 
@@ -73,7 +77,268 @@ void parser::throw_malformed_json_error(char unexpected_char, const std::string&
 	throw malformed_json_error(ss.str());
 }
 
-void parser::feed(utki::span<const char> data)
+namespace {
+template <char... chars>
+bool is_one_of(char c)
+{
+	return ((c == chars) || ...);
+}
+} // namespace
+
+namespace {
+// Check if any of the machine word's bytes is equal to any of the given characters.
+template <char... chars>
+bool word_has_one_of(uint64_t word)
+{
+	constexpr auto ones = ~uint64_t(0) / std::numeric_limits<uint8_t>::max();
+	constexpr auto high_bits = ones * 0x80;
+	constexpr auto low_bits = ~high_bits;
+
+	auto has_zero_byte = [](uint64_t w) {
+		// exact per byte zero test, no false positives caused by borrows
+		return ~(((w & low_bits) + low_bits) | w | low_bits);
+	};
+
+	return ((has_zero_byte(word ^ (ones * uint8_t(chars))) != 0) || ...);
+}
+} // namespace
+
+namespace {
+// Find first occurrence of any of the given characters within the [begin, end) range.
+// Returns end if no such character found.
+// In case the range is padded, the machine word reads are allowed to go past the end of the range.
+template <char... chars>
+const char* find_first_of(const char* begin, const char* end, bool padded)
+{
+	auto i = begin;
+
+	if (padded) {
+		for (; i < end; i += sizeof(uint64_t)) {
+			uint64_t word = 0;
+			std::memcpy(&word, i, sizeof(word));
+			if (word_has_one_of<chars...>(word)) {
+				break;
+			}
+		}
+		if (i >= end) {
+			return end;
+		}
+	} else {
+		for (; end - i >= ptrdiff_t(sizeof(uint64_t)); i += sizeof(uint64_t)) {
+			uint64_t word = 0;
+			std::memcpy(&word, i, sizeof(word));
+			if (word_has_one_of<chars...>(word)) {
+				break;
+			}
+		}
+	}
+
+	for (; i != end; ++i) {
+		if (is_one_of<chars...>(*i)) {
+			break;
+		}
+	}
+	return i;
+}
+} // namespace
+
+namespace {
+// Find first occurrence of any of the given characters within the [i, e) range,
+// append all preceding characters to the buffer at once and advance the iterator to the found character.
+// Returns false without appending anything in case the buffer would grow beyond max_size.
+template <char... chars>
+bool append_until_one_of(
+	std::vector<char>& buf,
+	utki::span<const char>::iterator& i,
+	utki::span<const char>::iterator& e,
+	bool padded,
+	size_t max_size
+)
+{
+	if (i == e) {
+		return buf.size() <= max_size;
+	}
+	const char* begin = &*i;
+	const char* end = std::next(begin, std::distance(i, e));
+
+	const char* found = find_first_of<chars...>(begin, end, padded);
+
+	auto size = size_t(std::distance(begin, found));
+	if (size > max_size || buf.size() > max_size - size) {
+		return false;
+	}
+
+	buf.insert(buf.end(), begin, found);
+	std::advance(i, size);
+	return true;
+}
+} // namespace
+
+template <typename callback_type>
+void parser::notify(const callback_type& callback)
+{
+	if (!this->stats || !this->measure_time) {
+		callback();
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	callback();
+	this->stats->callbacks_time += std::chrono::steady_clock::now() - start;
+}
+
+void parser::notify_value_start()
+{
+	++this->num_values;
+	if (this->num_values > this->limits.max_num_values) {
+		this->throw_limit_exceeded_error("number of values", this->limits.max_num_values);
+	}
+}
+
+void parser::notify_container_start()
+{
+	this->notify_value_start();
+	++this->depth;
+	if (this->depth > this->limits.max_depth) {
+		this->throw_limit_exceeded_error("nesting depth", this->limits.max_depth);
+	}
+	if (this->stats) {
+		this->stats->max_depth = std::max(this->stats->max_depth, this->depth);
+	}
+}
+
+void parser::notify_object_start()
+{
+	this->notify_container_start();
+	if (this->stats) {
+		++this->stats->num_objects;
+	}
+	this->notify([this]() {
+		this->on_object_start();
+	});
+}
+
+void parser::notify_object_end()
+{
+	ASSERT(this->depth != 0)
+	--this->depth;
+	this->notify([this]() {
+		this->on_object_end();
+	});
+}
+
+void parser::notify_array_start()
+{
+	this->notify_container_start();
+	if (this->stats) {
+		++this->stats->num_arrays;
+	}
+	this->notify([this]() {
+		this->on_array_start();
+	});
+}
+
+void parser::notify_array_end()
+{
+	ASSERT(this->depth != 0)
+	--this->depth;
+	this->notify([this]() {
+		this->on_array_end();
+	});
+}
+
+void parser::notify_key_parsed()
+{
+	if (this->stats) {
+		++this->stats->num_keys;
+		this->stats->max_string_length = std::max(this->stats->max_string_length, this->buf.size());
+		this->stats->num_bytes_copied += this->buf.size();
+	}
+	this->notify([this]() {
+		this->on_key_parsed(utki::make_span(this->buf));
+	});
+}
+
+void parser::notify_string_parsed()
+{
+	this->notify_value_start();
+	if (this->stats) {
+		++this->stats->num_strings;
+		this->stats->max_string_length = std::max(this->stats->max_string_length, this->buf.size());
+		this->stats->num_bytes_copied += this->buf.size();
+	}
+	this->notify([this]() {
+		this->on_string_parsed(utki::make_span(this->buf));
+	});
+}
+
+void parser::reset()
+{
+	this->line = 1;
+
+	this->state_stack.clear();
+	this->state_stack.push_back(state::idle);
+
+	this->buf.clear();
+
+	this->unicode_char = U'0';
+	this->unicode_char_digit_num = 0;
+	this->high_surrogate = 0;
+
+	this->depth = 0;
+	this->num_values = 0;
+	this->num_bytes_fed = 0;
+
+	if (this->stats) {
+		*this->stats = parser_stats();
+	}
+}
+
+void parser::enable_stats(bool measure_time)
+{
+	this->stats = std::make_unique<parser_stats>();
+	this->measure_time = measure_time;
+}
+
+void parser::throw_limit_exceeded_error(const char* limit_name, size_t limit)
+{
+	std::stringstream ss;
+	ss << "limit exceeded: " << limit_name << " is greater than " << limit << " at line " << this->line;
+	throw limit_exceeded_error(ss.str());
+}
+
+void parser::feed_internal(utki::span<const char> data, bool padded)
+{
+	this->input_padded = padded;
+
+	// check before parsing anything, so that the too big document is rejected right away
+	this->num_bytes_fed += data.size();
+	if (this->num_bytes_fed > this->limits.max_document_size) {
+		this->throw_limit_exceeded_error("document size", this->limits.max_document_size);
+	}
+
+	if (!this->stats) {
+		this->parse(data);
+		return;
+	}
+
+	this->stats->num_bytes += data.size();
+
+	if (!this->measure_time) {
+		this->parse(data);
+		return;
+	}
+
+	auto callbacks_time = this->stats->callbacks_time;
+	auto start = std::chrono::steady_clock::now();
+
+	this->parse(data);
+
+	auto time = std::chrono::steady_clock::now() - start;
+	this->stats->parsing_time += time - (this->stats->callbacks_time - callbacks_time);
+}
+
+void parser::parse(utki::span<const char> data)
 {
 	for (auto i = data.begin(), e = data.end(); i != e; ++i) {
 		ASSERT(!this->state_stack.empty())
@@ -108,6 +373,9 @@ void parser::feed(utki::span<const char> data)
 			case state::unicode_char:
 				this->parse_unicode_char(i, e);
 				break;
+			case state::low_surrogate_escape_sequence:
+				this->parse_low_surrogate_escape_sequence(i, e);
+				break;
 			case state::boolean_or_null_or_number:
 				this->parse_boolean_or_null_or_number(i, e);
 				break;
@@ -131,7 +399,7 @@ void parser::parse_idle(utki::span<const char>::iterator& i, utki::span<const ch
 				break;
 			case '{':
 				this->state_stack.push_back(state::object);
-				this->on_object_start();
+				this->notify_object_start();
 				return;
 			default:
 				this->throw_malformed_json_error(*i, "idle");
@@ -153,7 +421,7 @@ void parser::parse_object(utki::span<const char>::iterator& i, utki::span<const
 				break;
 			case '}':
 				this->state_stack.pop_back();
-				this->on_object_end();
+				this->notify_object_end();
 				return;
 			case '"':
 				this->state_stack.push_back(state::key);
@@ -168,6 +436,19 @@ void parser::parse_object(utki::span<const char>::iterator& i, utki::span<const
 void parser::parse_key(utki::span<const char>::iterator& i, utki::span<const char>::iterator& e)
 {
 	for (; i != e; ++i) {
+		if (!append_until_one_of<'"', '\\', '\n', ' ', '\r', '\t'>(
+				this->buf,
+				i,
+				e,
+				this->input_padded,
+				this->limits.max_string_length
+			))
+		{
+			this->throw_limit_exceeded_error("key length", this->limits.max_string_length);
+		}
+		if (i == e) {
+			return;
+		}
 		switch (*i) {
 			case '\n':
 				++this->line;
@@ -182,7 +463,7 @@ void parser::parse_key(utki::span<const char>::iterator& i, utki::span<const cha
 				break;
 			case '"':
 				this->state_stack.pop_back();
-				this->on_key_parsed(utki::make_span(this->buf));
+				this->notify_key_parsed();
 				this->buf.clear();
 				this->state_stack.push_back(state::colon);
 				return;
@@ -227,10 +508,10 @@ void parser::parse_value(utki::span<const char>::iterator& i, utki::span<const c
 				this->state_stack.pop_back();
 				this->state_stack.push_back(state::comma);
 				this->state_stack.push_back(state::object);
-				this->on_object_start();
+				this->notify_object_start();
 				return;
 			case '[':
-				this->on_array_start();
+				this->notify_array_start();
 				this->state_stack.pop_back();
 				this->state_stack.push_back(state::comma);
 				this->state_stack.push_back(state::array);
@@ -278,12 +559,12 @@ void parser::parse_array(utki::span<const char>::iterator& i, utki::span<const c
 			case '{':
 				this->state_stack.push_back(state::comma);
 				this->state_stack.push_back(state::object);
-				this->on_object_start();
+				this->notify_object_start();
 				return;
 			case '[':
 				this->state_stack.push_back(state::comma);
 				this->state_stack.push_back(state::array);
-				this->on_array_start();
+				this->notify_array_start();
 				return;
 			case '"':
 				this->state_stack.push_back(state::comma);
@@ -291,7 +572,7 @@ void parser::parse_array(utki::span<const char>::iterator& i, utki::span<const c
 				return;
 			case ']':
 				this->state_stack.pop_back();
-				this->on_array_end();
+				this->notify_array_end();
 				return;
 			case 't': // first letter of 'true' word
 			case 'f': // first letter of 'false' word
@@ -318,6 +599,20 @@ void parser::parse_array(utki::span<const char>::iterator& i, utki::span<const c
 void parser::parse_string(utki::span<const char>::iterator& i, utki::span<const char>::iterator& e)
 {
 	for (; i != e; ++i) {
+		// also catches the string grown too long by the escape sequences, as those return back to the string state
+		if (!append_until_one_of<'"', '\\', '\n'>(
+				this->buf,
+				i,
+				e,
+				this->input_padded,
+				this->limits.max_string_length
+			))
+		{
+			this->throw_limit_exceeded_error("string length", this->limits.max_string_length);
+		}
+		if (i == e) {
+			return;
+		}
 		switch (*i) {
 			case '\n':
 				++this->line;
@@ -329,7 +624,7 @@ void parser::parse_string(utki::span<const char>::iterator& i, utki::span<const
 				return;
 			case '"':
 				this->state_stack.pop_back();
-				this->on_string_parsed(utki::make_span(this->buf));
+				this->notify_string_parsed();
 				this->buf.clear();
 				return;
 		}
@@ -357,7 +652,7 @@ void parser::parse_comma(utki::span<const char>::iterator& i, utki::span<const c
 					this->throw_malformed_json_error(*i, "comma");
 				}
 				this->state_stack.pop_back();
-				this->on_object_end();
+				this->notify_object_end();
 				return;
 			case ']':
 				this->state_stack.pop_back();
@@ -366,7 +661,7 @@ void parser::parse_comma(utki::span<const char>::iterator& i, utki::span<const c
 					this->throw_malformed_json_error(*i, "comma");
 				}
 				this->state_stack.pop_back();
-				this->on_array_end();
+				this->notify_array_end();
 				return;
 			default:
 				this->throw_malformed_json_error(*i, "comma");
@@ -378,6 +673,19 @@ void parser::parse_comma(utki::span<const char>::iterator& i, utki::span<const c
 void parser::parse_boolean_or_null_or_number(utki::span<const char>::iterator& i, utki::span<const char>::iterator& e)
 {
 	for (; i != e; ++i) {
+		if (!append_until_one_of<'\n', '\r', '\t', ' ', ',', ']', '}'>(
+				this->buf,
+				i,
+				e,
+				this->input_padded,
+				this->limits.max_number_length
+			))
+		{
+			this->throw_limit_exceeded_error("number length", this->limits.max_number_length);
+		}
+		if (i == e) {
+			return;
+		}
 		switch (*i) {
 			case '\n':
 				++this->line;
@@ -397,7 +705,7 @@ void parser::parse_boolean_or_null_or_number(utki::span<const char>::iterator& i
 				return;
 			case ']':
 				this->notify_boolean_or_null_or_number_parsed();
-				this->on_array_end();
+				this->notify_array_end();
 				this->state_stack.pop_back();
 				ASSERT(!this->state_stack.empty())
 				ASSERT(this->state_stack.back() == state::comma)
@@ -411,7 +719,7 @@ void parser::parse_boolean_or_null_or_number(utki::span<const char>::iterator& i
 				return;
 			case '}':
 				this->notify_boolean_or_null_or_number_parsed();
-				this->on_object_end();
+				this->notify_object_end();
 				this->state_stack.pop_back();
 				ASSERT(!this->state_stack.empty())
 				ASSERT(this->state_stack.back() == state::comma)
@@ -430,118 +738,50 @@ void parser::parse_boolean_or_null_or_number(utki::span<const char>::iterator& i
 	}
 }
 
-namespace {
-bool is_valid_number_string(const std::string& s)
-{
-	enum class state {
-		idle,
-		sign,
-		integer,
-		dot,
-		fraction,
-		exponent,
-		exponent_sign,
-		exponent_integer
-	} cur_state = state::idle;
-
-	for (auto c : s) {
-		switch (cur_state) {
-			case state::idle:
-				if (c == '-') {
-					cur_state = state::sign; // sign parsed
-					break;
-				} else if (is_dec_digit(c)) {
-					cur_state = state::integer;
-					break;
-				}
-				return false;
-			case state::sign:
-				if (is_dec_digit(c)) {
-					cur_state = state::integer;
-					break;
-				}
-				return false;
-			case state::integer:
-				if (is_dec_digit(c)) {
-					break;
-				} else if (c == '.') {
-					cur_state = state::dot; // dot parsed
-					break;
-				} else if (c == 'e' || c == 'E') {
-					cur_state = state::exponent; // exponent parsed
-					break;
-				}
-				return false;
-			case state::dot:
-				if (is_dec_digit(c)) {
-					cur_state = state::fraction;
-					break;
-				}
-				return false;
-			case state::fraction:
-				if (is_dec_digit(c)) {
-					break;
-				} else if (c == 'e' || c == 'E') {
-					cur_state = state::exponent; // exponent parsed
-					break;
-				}
-				return false;
-			case state::exponent:
-				if (c == '-' || c == '+') {
-					cur_state = state::exponent_sign; // exponent sign parsed
-					break;
-				} else if (is_dec_digit(c)) {
-					cur_state = state::exponent_integer;
-					break;
-				}
-				return false;
-			case state::exponent_sign:
-				if (is_dec_digit(c)) {
-					cur_state = state::exponent_integer;
-					break;
-				}
-				return false;
-			case state::exponent_integer:
-				if (is_dec_digit(c)) {
-					break;
-				}
-				return false;
-		}
-	}
-
-	if (cur_state == state::sign || cur_state == state::dot || cur_state == state::exponent ||
-		cur_state == state::exponent_sign)
-	{
-		return false;
-	}
-
-	return true;
-}
-} // namespace
-
 void parser::notify_boolean_or_null_or_number_parsed()
 {
+	this->notify_value_start();
+
 	auto s = utki::make_string(this->buf);
-	if (s == "true") {
-		this->on_boolean_parsed(true);
-	} else if (s == "false") {
-		this->on_boolean_parsed(false);
+	if (s == "true" || s == "false") {
+		if (this->stats) {
+			++this->stats->num_booleans;
+		}
+		this->notify([this, b = s == "true"]() {
+			this->on_boolean_parsed(b);
+		});
 	} else if (s == "null") {
-		this->on_null_parsed();
-	} else if (is_valid_number_string(s)) {
-		this->on_number_parsed(utki::make_span(this->buf));
+		if (this->stats) {
+			++this->stats->num_nulls;
+		}
+		this->notify([this]() {
+			this->on_null_parsed();
+		});
+	} else if (internal::is_valid_number(s)) {
+		if (this->stats) {
+			++this->stats->num_numbers;
+		}
+		this->notify([this]() {
+			this->on_number_parsed(utki::make_span(this->buf));
+		});
 	} else {
 		std::stringstream ss;
 		ss << "unexpected string (" << s << ") encountered while parsing boolean or null or number at line "
 		   << this->line;
 		throw malformed_json_error(ss.str());
 	}
+	if (this->stats) {
+		this->stats->num_bytes_copied += this->buf.size();
+	}
 	this->buf.clear();
 }
 
 void parser::parse_string_escape_sequence(utki::span<const char>::iterator& i, utki::span<const char>::iterator& e)
 {
 	for (; i != e; ++i) {
+		if (this->high_surrogate != 0 && *i != 'u') {
+			this->throw_malformed_json_error(*i, "low surrogate escape sequence");
+		}
 		switch (*i) {
 			case 'n':
 				this->buf.push_back('\n');
@@ -601,18 +841,50 @@ void parser::parse_unicode_char(utki::span<const char>::iterator& i, utki::span<
 		++this->unicode_char_digit_num;
 
 		if (this->unicode_char_digit_num == 4) {
-			auto bytes = utki::to_utf8(this->unicode_char);
-
-			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-			for (auto c : bytes) {
-				if (c == 0) {
-					break;
-				}
-				this->buf.push_back(c);
-			}
-
 			this->state_stack.pop_back();
+			this->notify_unicode_char_parsed();
 			return;
 		}
 	}
 }
+
+void parser::notify_unicode_char_parsed()
+{
+	if (this->high_surrogate != 0) {
+		if (!internal::is_low_surrogate(this->unicode_char)) {
+			std::stringstream ss;
+			ss << "high surrogate \\u" << std::hex << uint32_t(this->high_surrogate)
+			   << " is not followed by low surrogate, line = " << std::dec << this->line;
+			throw malformed_json_error(ss.str());
+		}
+	} else if (internal::is_high_surrogate(this->unicode_char)) {
+		// character outside of the Basic Multilingual Plane, the low surrogate escape sequence must follow
+		this->high_surrogate = this->unicode_char;
+		this->state_stack.push_back(state::low_surrogate_escape_sequence);
+		return;
+	} else if (internal::is_low_surrogate(this->unicode_char)) {
+		std::stringstream ss;
+		ss << "low surrogate \\u" << std::hex << uint32_t(this->unicode_char)
+		   << " is not preceded by high surrogate, line = " << std::dec << this->line;
+		throw malformed_json_error(ss.str());
+	}
+
+	auto c = this->high_surrogate == 0
+		? internal::unicode_escape_to_utf8(this->unicode_char)
+		: internal::unicode_escape_to_utf8(this->high_surrogate, this->unicode_char);
+	this->high_surrogate = 0;
+
+	this->buf.insert(this->buf.end(), c.bytes.begin(), std::next(c.bytes.begin(), ptrdiff_t(c.size)));
+}
+
+void parser::parse_low_surrogate_escape_sequence(
+	utki::span<const char>::iterator& i, //
+	utki::span<const char>::iterator& e
+)
+{
+	ASSERT(i != e)
+	if (*i != '\\') {
+		this->throw_malformed_json_error(*i, "low surrogate escape sequence");
+	}
+	this->state_stack.back() = state::string_escape_sequence;
+}
@@ -26,12 +26,133 @@ SOFTWARE.
 
 #pragma once
 
+#include <chrono>
+#include <limits>
+#include <memory>
 #include <vector>
 
 #include <utki/span.hpp>
 
+#include "padded_buffer.hpp"
+
 namespace jsondom {
 
+/**
+ * @brief Parsing statistics.
+ * Allows finding out which documents are expensive to parse and why.
+ */
+struct parser_stats {
+	/**
+	 * @brief Number of bytes fed to the parser.
+	 */
+	size_t num_bytes = 0;
+
+	/**
+	 * @brief Number of parsed objects.
+	 */
+	size_t num_objects = 0;
+
+	/**
+	 * @brief Number of parsed arrays.
+	 */
+	size_t num_arrays = 0;
+
+	/**
+	 * @brief Number of parsed keys.
+	 */
+	size_t num_keys = 0;
+
+	/**
+	 * @brief Number of parsed string values.
+	 */
+	size_t num_strings = 0;
+
+	/**
+	 * @brief Number of parsed number values.
+	 */
+	size_t num_numbers = 0;
+
+	/**
+	 * @brief Number of parsed boolean values.
+	 */
+	size_t num_booleans = 0;
+
+	/**
+	 * @brief Number of parsed null values.
+	 */
+	size_t num_nulls = 0;
+
+	/**
+	 * @brief Maximum nesting depth of objects and arrays.
+	 * Root object has depth of 1.
+	 */
+	size_t max_depth = 0;
+
+	/**
+	 * @brief Length of the longest key or string value.
+	 * The length is in bytes, after unescaping.
+	 */
+	size_t max_string_length = 0;
+
+	/**
+	 * @brief Number of bytes copied to the internal buffer.
+	 * Keys, strings, numbers, booleans and nulls are copied to the internal buffer
+	 * before passing them to the on_*() methods.
+	 */
+	size_t num_bytes_copied = 0;
+
+	/**
+	 * @brief Time spent in parsing, not including the time spent in the on_*() methods.
+	 * Only measured if requested, see parser::enable_stats().
+	 */
+	std::chrono::nanoseconds parsing_time{0};
+
+	/**
+	 * @brief Time spent in the on_*() methods.
+	 * Only measured if requested, see parser::enable_stats().
+	 */
+	std::chrono::nanoseconds callbacks_time{0};
+};
+
+/**
+ * @brief Parsing limits.
+ * Allow bounding memory and time spent on parsing untrusted input.
+ * In case any of the limits is exceeded, the parser throws limit_exceeded_error
+ * as soon as it is detected, without reading the rest of the document.
+ * By default, there are no limits.
+ */
+struct parser_limits {
+	/**
+	 * @brief Maximum nesting depth of objects and arrays.
+	 * Root object has depth of 1.
+	 */
+	size_t max_depth = std::numeric_limits<size_t>::max();
+
+	/**
+	 * @brief Maximum length of a key or string value.
+	 * The length is in bytes, after unescaping.
+	 */
+	size_t max_string_length = std::numeric_limits<size_t>::max();
+
+	/**
+	 * @brief Maximum length of a number value.
+	 * The length is in characters. The limit also applies to the true, false and null words,
+	 * so it should not be less than 5.
+	 */
+	size_t max_number_length = std::numeric_limits<size_t>::max();
+
+	/**
+	 * @brief Maximum number of bytes fed to the parser.
+	 */
+	size_t max_document_size = std::numeric_limits<size_t>::max();
+
+	/**
+	 * @brief Maximum number of values in the document.
+	 * Objects, arrays, strings, numbers, booleans and nulls are counted, keys are not.
+	 */
+	size_t max_num_values = std::numeric_limits<size_t>::max();
+};
+
 /**
  * @brief SAX style JSON parser.
  * One has to subclass this class and override on_*() methods, then call feed() method to
@@ -52,6 +173,7 @@ class parser
 		string,
 		string_escape_sequence,
 		unicode_char,
+		low_surrogate_escape_sequence,
 		boolean_or_null_or_number
 	};
 
@@ -67,15 +189,52 @@ class parser
 	void parse_string(utki::span<const char>::iterator& i, utki::span<const char>::iterator& e);
 	void parse_string_escape_sequence(utki::span<const char>::iterator& i, utki::span<const char>::iterator& e);
 	void parse_unicode_char(utki::span<const char>::iterator& i, utki::span<const char>::iterator& e);
+	void parse_low_surrogate_escape_sequence(
+		utki::span<const char>::iterator& i, //
+		utki::span<const char>::iterator& e
+	);
 	void parse_boolean_or_null_or_number(utki::span<const char>::iterator& i, utki::span<const char>::iterator& e);
 
 	void notify_boolean_or_null_or_number_parsed();
+	void notify_unicode_char_parsed();
+
+	template <typename callback_type>
+	void notify(const callback_type& callback);
+
+	void notify_value_start();
+	void notify_container_start();
+	void notify_object_start();
+	void notify_object_end();
+	void notify_array_start();
+	void notify_array_end();
+	void notify_key_parsed();
+	void notify_string_parsed();
+
+	// statistics are only collected when enabled, so that it costs nothing otherwise
+	std::unique_ptr<parser_stats> stats;
+	bool measure_time = false;
+
+	parser_limits limits;
+	size_t depth = 0;
+	size_t num_values = 0;
+	size_t num_bytes_fed = 0;
+
+	void throw_limit_exceeded_error(const char* limit_name, size_t limit);
 
 	std::vector<char> buf;
 
+	// whether the data being fed is followed by at least padded_buffer::padding_size readable bytes
+	bool input_padded = false;
+
+	void feed_internal(utki::span<const char> data, bool padded);
+	void parse(utki::span<const char> data);
+
 	char32_t unicode_char = U'0';
 	unsigned unicode_char_digit_num = 0;
 
+	// high surrogate of the UTF-16 surrogate pair waiting for its low surrogate escape sequence, 0 if none
+	char32_t high_surrogate = 0;
+
 	void throw_malformed_json_error(char unexpected_char, const std::string& state_name);
 
 public:
@@ -89,6 +248,68 @@ public:
 
 	virtual ~parser() noexcept = default;
 
+	/**
+	 * @brief Reset the parser to initial state.
+	 * Allows parsing another document with the same parser instance, also after a parsing error.
+	 * The internal buffers keep their allocated memory, so that parsing
+	 * of subsequent documents does not allocate it again.
+	 * Limits and enabled statistics are kept, the collected statistics are reset.
+	 * Subclasses overriding this method must call the base class implementation.
+	 */
+	virtual void reset();
+
+	/**
+	 * @brief Enable collecting parsing statistics.
+	 * Should be called before feeding any data to the parser.
+	 * Calling it again resets the collected statistics.
+	 * When statistics are not enabled, the parser only spends a check per parsed token for them.
+	 * @param measure_time - whether to measure time spent in parsing and in the on_*() methods.
+	 *                       The time is measured around each on_*() method call, which makes parsing
+	 *                       noticeably slower, so it is optional.
+	 */
+	void enable_stats(bool measure_time = false);
+
+	/**
+	 * @brief Get parsing statistics.
+	 * @return pointer to the statistics collected so far.
+	 * @return nullptr in case collecting of the statistics is not enabled.
+	 */
+	const parser_stats* get_stats() const noexcept
+	{
+		return this->stats.get();
+	}
+
+	/**
+	 * @brief Set parsing limits.
+	 * Should be called before feeding any data to the parser.
+	 * @param limits - parsing limits.
+	 */
+	void set_limits(const parser_limits& limits)
+	{
+		this->limits = limits;
+	}
+
+	/**
+	 * @brief Get parsing limits.
+	 * @return current parsing limits.
+	 */
+	const parser_limits& get_limits() const noexcept
+	{
+		return this->limits;
+	}
+
+	/**
+	 * @brief Check if a complete document has been parsed.
+	 * Allows finding out when to stop feeding data to the parser,
+	 * e.g. when the document is received in pieces from network.
+	 * @return true if the root value has been parsed completely and no other document has been started after it.
+	 * @return false otherwise.
+	 */
+	bool is_complete() const noexcept
+	{
+		return this->num_values != 0 && this->state_stack.size() == 1 && this->state_stack.back() == state::idle;
+	}
+
 	/**
 	 * @brief Invoked on JSON object start.
 	 * This method is invoked when JSON object start (i.e. '{' symbol)
@@ -160,7 +381,21 @@ public:
 	 * @brief feed UTF-8 data to parser.
 	 * @param data - data to be fed to parser.
 	 */
-	void feed(utki::span<const char> data);
+	void feed(utki::span<const char> data)
+	{
+		this->feed_internal(data, false);
+	}
+
+	/**
+	 * @brief feed UTF-8 data to parser.
+	 * Since the data is padded, the parser is allowed to read the data
+	 * by whole machine words without checking for the end of the data at every step.
+	 * @param data - data to be fed to parser.
+	 */
+	void feed(const padded_buffer& data)
+	{
+		this->feed_internal(data.span(), true);
+	}
 
 	/**
 	 * @brief feed UTF-8 data to parser.
@@ -0,0 +1,55 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "reader.hpp"
+
+using namespace jsondom;
+
+reader::reader(const read_options& options) :
+	options(options)
+{
+	internal::apply_read_options(this->doc_parser, options);
+
+	// limits are already set to the parser, do not keep the pointer
+	this->options.limits = nullptr;
+}
+
+value reader::read(utki::span<const char> data)
+{
+	// the parser could be left in the middle of a document by a previous failed reading
+	this->doc_parser.reset();
+	this->doc_parser.feed(data);
+	internal::store_read_stats(this->doc_parser, this->options);
+	return this->doc_parser.release_document();
+}
+
+value reader::read(const padded_buffer& data)
+{
+	this->doc_parser.reset();
+	this->doc_parser.feed(data);
+	internal::store_read_stats(this->doc_parser, this->options);
+	return this->doc_parser.release_document();
+}
@@ -0,0 +1,115 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <string>
+
+#include <utki/span.hpp>
+
+#include "dom.hpp"
+#include "dom_parser.hpp"
+#include "padded_buffer.hpp"
+#include "parser.hpp"
+
+namespace jsondom {
+
+/**
+ * @brief Reusable JSON document reader.
+ * Reads JSON documents from memory, same as jsondom::read() does, but keeps the parser
+ * and its internal buffers between the documents. So, after reading first few documents the buffers have
+ * grown enough and reading of subsequent documents of similar structure only allocates memory for the
+ * read values themselves.
+ * This is beneficial when reading lots of small documents, e.g. messages.
+ *
+ * The reader is not thread safe, the intended use is one reader per thread.
+ * In case reading of a document fails with an exception, the reader remains usable for reading next documents.
+ */
+class reader
+{
+	dom_parser doc_parser;
+
+	read_options options;
+
+public:
+	reader() = default;
+
+	/**
+	 * @brief Constructor.
+	 * @param limits - parsing limits to apply to each read document.
+	 */
+	explicit reader(const parser_limits& limits)
+	{
+		this->doc_parser.set_limits(limits);
+	}
+
+	/**
+	 * @brief Constructor.
+	 * The chunk_size and num_background_buffers options are ignored.
+	 * In case options.stats is set, then statistics of each read document are stored there
+	 * after the document has been read, the pointed object must remain alive while the reader is used.
+	 * The limits are copied, so the pointed limits object does not need to outlive the constructor call.
+	 * @param options - reading options to apply to each read document.
+	 */
+	explicit reader(const read_options& options);
+
+	/**
+	 * @brief Read JSON document from memory.
+	 * @param data - memory span to read the JSON document from.
+	 * @return the read JSON document.
+	 */
+	value read(utki::span<const char> data);
+
+	/**
+	 * @brief Read JSON document from memory.
+	 * @param data - memory span to read the JSON document from.
+	 * @return the read JSON document.
+	 */
+	value read(utki::span<const uint8_t> data)
+	{
+		return this->read(utki::to_char(data));
+	}
+
+	/**
+	 * @brief Read JSON document from padded memory buffer.
+	 * See jsondom::read(const padded_buffer&) for details.
+	 * @param data - memory buffer to read the JSON document from.
+	 * @return the read JSON document.
+	 */
+	value read(const padded_buffer& data);
+
+	/**
+	 * @brief Read JSON document from string.
+	 * @param str - string to read the JSON document from.
+	 * @return the read JSON document.
+	 */
+	value read(const std::string& str)
+	{
+		return this->read(utki::make_span(str.c_str(), str.size()));
+	}
+};
+
+} // namespace jsondom
@@ -0,0 +1,580 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+#include <utki/string.hpp>
+#include <utki/util.hpp>
+
+#if CFG_OS == CFG_OS_WINDOWS
+#	include <fsif/native_file.hpp>
+#else
+#	include <cerrno>
+#	include <system_error>
+
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+using namespace std::string_view_literals;
+
+using namespace jsondom;
+
+namespace {
+constexpr std::string_view snapshot_magic = "jsds"sv;
+
+constexpr size_t version_offset = 4;
+constexpr size_t root_offset_offset = 8;
+constexpr size_t checksum_offset = 12;
+constexpr size_t header_size = 16;
+
+constexpr size_t node_header_size = 8;
+
+constexpr auto byte_bits = std::numeric_limits<uint8_t>::digits;
+
+uint32_t read_uint32(const uint8_t* p)
+{
+	uint32_t ret = 0;
+	for (size_t i = 0; i != sizeof(uint32_t); ++i) {
+		ret |= uint32_t(p[i]) << (i * byte_bits);
+	}
+	return ret;
+}
+
+void write_uint32(uint8_t* p, uint32_t value)
+{
+	for (size_t i = 0; i != sizeof(uint32_t); ++i) {
+		p[i] = uint8_t(value >> (i * byte_bits));
+	}
+}
+
+// FNV-1a
+uint32_t checksum(utki::span<const uint8_t> data)
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+	uint32_t hash = 2166136261;
+	for (auto b : data) {
+		hash ^= b;
+		// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+[[noreturn]] void throw_malformed(std::string_view message)
+{
+	throw malformed_binary_data_error(utki::cat(
+		"jsondom: malformed snapshot: "sv, //
+		message
+	));
+}
+} // namespace
+
+namespace {
+class snapshot_encoder
+{
+	// offsets of already written keys, to store each distinct key only once
+	std::unordered_map<std::string_view, uint32_t> keys;
+
+	uint32_t offset() const
+	{
+		if (this->buf.size() > std::numeric_limits<uint32_t>::max()) {
+			throw std::length_error("jsondom: too big value for snapshot");
+		}
+		return uint32_t(this->buf.size());
+	}
+
+	void write_uint32(uint32_t value)
+	{
+		this->buf.resize(this->buf.size() + sizeof(value));
+		::write_uint32(&*(this->buf.end() - sizeof(value)), value);
+	}
+
+	uint32_t write_node_header(
+		type t, //
+		size_t size
+	)
+	{
+		if (size > std::numeric_limits<uint32_t>::max()) {
+			throw std::length_error("jsondom: too big value for snapshot");
+		}
+		auto ret = this->offset();
+		this->write_uint32(uint32_t(t));
+		this->write_uint32(uint32_t(size));
+		return ret;
+	}
+
+	uint32_t write_text(
+		type t, //
+		std::string_view text
+	)
+	{
+		auto ret = this->write_node_header(t, text.size());
+		this->buf.insert(this->buf.end(), text.begin(), text.end());
+		return ret;
+	}
+
+	uint32_t write_key(std::string_view key)
+	{
+		auto i = this->keys.find(key);
+		if (i != this->keys.end()) {
+			return i->second;
+		}
+		auto ret = this->write_text(type::string, key);
+		this->keys.insert(std::make_pair(key, ret));
+		return ret;
+	}
+
+public:
+	std::vector<uint8_t> buf;
+
+	snapshot_encoder() :
+		buf(header_size)
+	{}
+
+	// children are written before their parent, returns offset of the written node
+	uint32_t write(const value& v)
+	{
+		switch (v.get_type()) {
+			default:
+			case type::null:
+				return this->write_node_header(type::null, 0);
+			case type::boolean:
+				return this->write_node_header(type::boolean, v.boolean() ? 1 : 0);
+			case type::number:
+				return this->write_text(type::number, v.number().get_string());
+			case type::string:
+				return this->write_text(type::string, v.string());
+			case type::array:
+				{
+					std::vector<uint32_t> offsets;
+					offsets.reserve(v.array().size());
+					for (const auto& e : v.array()) {
+						offsets.push_back(this->write(e));
+					}
+					auto ret = this->write_node_header(type::array, offsets.size());
+					for (auto o : offsets) {
+						this->write_uint32(o);
+					}
+					return ret;
+				}
+			case type::object:
+				{
+					std::vector<std::pair<uint32_t, uint32_t>> offsets;
+					offsets.reserve(v.object().size());
+					for (const auto& kv : v.object()) {
+						auto key_offset = this->write_key(kv.first);
+						offsets.emplace_back(key_offset, this->write(kv.second));
+					}
+					auto ret = this->write_node_header(type::object, offsets.size());
+					for (const auto& o : offsets) {
+						this->write_uint32(o.first);
+						this->write_uint32(o.second);
+					}
+					return ret;
+				}
+		}
+	}
+
+	void finish(uint32_t root_offset)
+	{
+		// check that the whole snapshot is addressable by offsets
+		this->offset();
+
+		std::copy(snapshot_magic.begin(), snapshot_magic.end(), this->buf.begin());
+		::write_uint32(&this->buf[version_offset], snapshot_version);
+		::write_uint32(&this->buf[root_offset_offset], root_offset);
+		::write_uint32(
+			&this->buf[checksum_offset], //
+			checksum(utki::make_span(this->buf).subspan(header_size))
+		);
+	}
+};
+} // namespace
+
+std::vector<uint8_t> jsondom::to_snapshot(const value& v)
+{
+	snapshot_encoder e;
+	e.finish(e.write(v));
+	return std::move(e.buf);
+}
+
+void jsondom::write_snapshot(
+	fsif::file& fi, //
+	const value& v
+)
+{
+	auto data = to_snapshot(v);
+
+	fsif::file::guard file_guard(
+		fi, //
+		fsif::mode::create
+	);
+
+	fi.write(utki::make_span(data));
+}
+
+snapshot_value::snapshot_value(
+	utki::span<const uint8_t> data, //
+	uint32_t offset
+) :
+	data(data),
+	offset(offset)
+{
+	if (offset < header_size || offset > data.size() || data.size() - offset < node_header_size) {
+		throw_malformed("node offset is out of range"sv);
+	}
+
+	auto t = read_uint32(&data[offset]);
+	if (t >= uint32_t(type::enum_size)) {
+		throw_malformed("invalid node type"sv);
+	}
+	this->value_type = type(t);
+	this->size_field = read_uint32(&data[offset + sizeof(uint32_t)]);
+
+	auto payload_size = data.size() - offset - node_header_size;
+
+	switch (this->value_type) {
+		case type::null:
+			break;
+		case type::boolean:
+			if (this->size_field > 1) {
+				throw_malformed("invalid boolean value"sv);
+			}
+			break;
+		case type::number:
+		case type::string:
+			if (this->size_field > payload_size) {
+				throw_malformed("text is out of range"sv);
+			}
+			break;
+		case type::array:
+			if (this->size_field > payload_size / sizeof(uint32_t)) {
+				throw_malformed("array is out of range"sv);
+			}
+			break;
+		case type::object:
+			if (this->size_field > payload_size / (2 * sizeof(uint32_t))) {
+				throw_malformed("object is out of range"sv);
+			}
+			break;
+		case type::enum_size:
+			ASSERT(false)
+			break;
+	}
+}
+
+const uint8_t* snapshot_value::payload() const noexcept
+{
+	return &this->data[this->offset + node_header_size];
+}
+
+std::string_view snapshot_value::text() const noexcept
+{
+	auto t = utki::to_char(this->data.subspan(this->offset + node_header_size, this->size_field));
+	return {t.data(), t.size()};
+}
+
+snapshot_value snapshot_value::child(uint32_t child_offset) const
+{
+	// nodes only refer to preceding nodes, so there can be no reference cycles
+	if (child_offset >= this->offset) {
+		throw_malformed("node refers to non-preceding node"sv);
+	}
+	return snapshot_value(this->data, child_offset);
+}
+
+void snapshot_value::throw_access_error(type tried_access) const
+{
+	throw unexpected_value_type(utki::cat(
+		"jsondom: could not access "sv, //
+		jsondom::to_string(tried_access),
+		" snapshot value, stored value is of another type ("sv,
+		jsondom::to_string(this->value_type),
+		")"sv
+	));
+}
+
+bool snapshot_value::boolean() const
+{
+	this->throw_if_type_is_not<type::boolean>();
+	return this->size_field != 0;
+}
+
+std::string_view snapshot_value::number() const
+{
+	this->throw_if_type_is_not<type::number>();
+	return this->text();
+}
+
+std::string_view snapshot_value::string() const
+{
+	this->throw_if_type_is_not<type::string>();
+	return this->text();
+}
+
+size_t snapshot_value::size() const
+{
+	if (!this->is_array() && !this->is_object()) {
+		this->throw_access_error(type::array);
+	}
+	return this->size_field;
+}
+
+snapshot_value snapshot_value::at(size_t index) const
+{
+	if (index >= this->size()) {
+		throw std::out_of_range("jsondom: snapshot_value::at(): index is out of range");
+	}
+
+	if (this->is_array()) {
+		return this->child(read_uint32(this->payload() + index * sizeof(uint32_t)));
+	}
+
+	return this->child(read_uint32(this->payload() + (index * 2 + 1) * sizeof(uint32_t)));
+}
+
+std::string_view snapshot_value::key(size_t index) const
+{
+	this->throw_if_type_is_not<type::object>();
+
+	if (index >= this->size_field) {
+		throw std::out_of_range("jsondom: snapshot_value::key(): index is out of range");
+	}
+
+	auto k = this->child(read_uint32(this->payload() + index * 2 * sizeof(uint32_t)));
+	if (!k.is_string()) {
+		throw_malformed("object key is not a string"sv);
+	}
+	return k.string();
+}
+
+std::optional<snapshot_value> snapshot_value::find(std::string_view key) const
+{
+	this->throw_if_type_is_not<type::object>();
+
+	// members are sorted by key
+	size_t begin = 0;
+	size_t end = this->size_field;
+	while (begin != end) {
+		auto middle = begin + (end - begin) / 2;
+		auto k = this->key(middle);
+		if (k < key) {
+			begin = middle + 1;
+		} else if (key < k) {
+			end = middle;
+		} else {
+			return this->at(middle);
+		}
+	}
+	return std::nullopt;
+}
+
+snapshot_value snapshot_value::at(std::string_view key) const
+{
+	auto v = this->find(key);
+	if (!v) {
+		throw std::out_of_range(utki::cat(
+			"jsondom: snapshot_value::at(): object has no member with key: "sv, //
+			key
+		));
+	}
+	return v.value();
+}
+
+value snapshot_value::to_value() const
+{
+	switch (this->value_type) {
+		default:
+		case type::null:
+			return {};
+		case type::boolean:
+			return {this->boolean()};
+		case type::number:
+			return {string_number(std::string(this->number()))};
+		case type::string:
+			return {std::string(this->string())};
+		case type::array:
+			{
+				value ret(type::array);
+				auto& arr = ret.array();
+				arr.reserve(this->size_field);
+				for (size_t i = 0; i != this->size_field; ++i) {
+					arr.push_back(this->at(i).to_value());
+				}
+				return ret;
+			}
+		case type::object:
+			{
+				value ret(type::object);
+				auto& obj = ret.object();
+				for (size_t i = 0; i != this->size_field; ++i) {
+					obj.insert(
+						obj.end(), //
+						std::make_pair(std::string(this->key(i)), this->at(i).to_value())
+					);
+				}
+				return ret;
+			}
+	}
+}
+
+#if CFG_OS == CFG_OS_WINDOWS
+class snapshot::mapping
+{};
+#else
+class snapshot::mapping
+{
+public:
+	void* address = nullptr;
+	size_t size = 0;
+
+	mapping(const std::string& file_name)
+	{
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+		int fd = ::open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			throw std::system_error(
+				errno,
+				std::generic_category(),
+				utki::cat("jsondom::snapshot: could not open file: "sv, file_name)
+			);
+		}
+		utki::scope_exit close_scope_exit([fd]() {
+			::close(fd);
+		});
+
+		struct stat st {};
+		if (::fstat(fd, &st) != 0) {
+			throw std::system_error(errno, std::generic_category(), "jsondom::snapshot: fstat() failed");
+		}
+		this->size = size_t(st.st_size);
+
+		if (this->size == 0) {
+			// empty file cannot be mapped, it will be refused as a snapshot with invalid header
+			return;
+		}
+
+		this->address = ::mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast, performance-no-int-to-ptr)
+		if (this->address == MAP_FAILED) {
+			this->address = nullptr;
+			throw std::system_error(errno, std::generic_category(), "jsondom::snapshot: mmap() failed");
+		}
+	}
+
+	mapping(const mapping&) = delete;
+	mapping& operator=(const mapping&) = delete;
+
+	mapping(mapping&&) = delete;
+	mapping& operator=(mapping&&) = delete;
+
+	~mapping()
+	{
+		if (this->address) {
+			::munmap(this->address, this->size);
+		}
+	}
+};
+#endif
+
+snapshot::snapshot(
+	utki::span<const uint8_t> data, //
+	bool verify_checksum
+) :
+	data(data)
+{
+	this->init(verify_checksum);
+}
+
+snapshot::snapshot(
+	std::vector<uint8_t> data, //
+	bool verify_checksum
+) :
+	buffer(std::move(data)),
+	data(utki::make_span(this->buffer))
+{
+	this->init(verify_checksum);
+}
+
+snapshot::snapshot(
+	const fsif::file& fi, //
+	bool verify_checksum
+) :
+	snapshot(fi.load(), verify_checksum)
+{}
+
+#if CFG_OS == CFG_OS_WINDOWS
+snapshot::snapshot(
+	const std::string& file_name, //
+	bool verify_checksum
+) :
+	snapshot(fsif::native_file(file_name).load(), verify_checksum)
+{}
+#else
+snapshot::snapshot(
+	const std::string& file_name, //
+	bool verify_checksum
+) :
+	mapped(std::make_unique<mapping>(file_name))
+{
+	this->data = utki::make_span(static_cast<const uint8_t*>(this->mapped->address), this->mapped->size);
+	this->init(verify_checksum);
+}
+#endif
+
+snapshot::snapshot(snapshot&&) noexcept = default;
+snapshot& snapshot::operator=(snapshot&&) noexcept = default;
+
+snapshot::~snapshot() = default;
+
+void snapshot::init(bool verify_checksum)
+{
+	if (this->data.size() < header_size ||
+		!std::equal(snapshot_magic.begin(), snapshot_magic.end(), this->data.begin()))
+	{
+		throw_malformed("invalid header"sv);
+	}
+
+	if (read_uint32(&this->data[version_offset]) != snapshot_version) {
+		throw_malformed("unsupported version"sv);
+	}
+
+	if (verify_checksum && read_uint32(&this->data[checksum_offset]) != checksum(this->data.subspan(header_size))) {
+		throw_malformed("checksum mismatch"sv);
+	}
+}
+
+snapshot_value snapshot::root() const
+{
+	return {this->data, read_uint32(&this->data[root_offset_offset])};
+}
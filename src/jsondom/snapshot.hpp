@@ -0,0 +1,333 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fsif/file.hpp>
+#include <utki/span.hpp>
+
+#include "dom.hpp"
+
+namespace jsondom {
+
+/**
+ * @brief Version of the snapshot format.
+ * Snapshots of other versions are refused to be opened.
+ */
+constexpr const uint32_t snapshot_version = 1;
+
+/**
+ * @brief Write JSON document to file as a snapshot.
+ * Snapshot is a relocatable binary representation of the value tree, it refers to the nodes
+ * by offsets instead of pointers, so it can be memory-mapped and navigated without parsing.
+ * See snapshot class.
+ * @param fi - file to write the snapshot to.
+ * @param v - root value of the document to write.
+ * @throw std::length_error in case the snapshot would exceed 4 GB.
+ */
+void write_snapshot(
+	fsif::file& fi, //
+	const value& v
+);
+
+/**
+ * @brief Make snapshot of JSON document.
+ * @param v - root value of the document.
+ * @return the snapshot data.
+ * @throw std::length_error in case the snapshot would exceed 4 GB.
+ */
+std::vector<uint8_t> to_snapshot(const value& v);
+
+/**
+ * @brief Read-only view of a value stored in a snapshot.
+ * The view is only valid while the snapshot it was obtained from is alive.
+ * All accesses are bounds checked, so navigating corrupt snapshot data throws
+ * malformed_binary_data_error instead of reading outside of the snapshot.
+ */
+class snapshot_value
+{
+	friend class snapshot;
+
+	utki::span<const uint8_t> data;
+	uint32_t offset;
+
+	jsondom::type value_type;
+	uint32_t size_field;
+
+	snapshot_value(
+		utki::span<const uint8_t> data, //
+		uint32_t offset
+	);
+
+	const uint8_t* payload() const noexcept;
+	std::string_view text() const noexcept;
+
+	snapshot_value child(uint32_t child_offset) const;
+
+	void throw_access_error(jsondom::type tried_access) const;
+
+	template <jsondom::type json_type>
+	void throw_if_type_is_not() const
+	{
+		if (!this->is<json_type>()) {
+			this->throw_access_error(json_type);
+		}
+	}
+
+public:
+	/**
+	 * @brief Get value type.
+	 * @return value type.
+	 */
+	jsondom::type get_type() const noexcept
+	{
+		return this->value_type;
+	}
+
+	/**
+	 * @brief Check that the value is of the given type.
+	 * @return true if the value is of the given type.
+	 * @return false otherwise.
+	 */
+	template <jsondom::type json_type>
+	bool is() const noexcept
+	{
+		return this->value_type == json_type;
+	}
+
+	bool is_null() const noexcept
+	{
+		return this->is<type::null>();
+	}
+
+	bool is_boolean() const noexcept
+	{
+		return this->is<type::boolean>();
+	}
+
+	bool is_number() const noexcept
+	{
+		return this->is<type::number>();
+	}
+
+	bool is_string() const noexcept
+	{
+		return this->is<type::string>();
+	}
+
+	bool is_array() const noexcept
+	{
+		return this->is<type::array>();
+	}
+
+	bool is_object() const noexcept
+	{
+		return this->is<type::object>();
+	}
+
+	/**
+	 * @brief Get boolean value.
+	 * @return the boolean value.
+	 * @throw unexpected_value_type in case the stored value is not a boolean.
+	 */
+	bool boolean() const;
+
+	/**
+	 * @brief Get number value.
+	 * @return the number as it is stored in JSON document, i.e. in text form.
+	 * @throw unexpected_value_type in case the stored value is not a number.
+	 */
+	std::string_view number() const;
+
+	/**
+	 * @brief Get string value.
+	 * @return the string value.
+	 * @throw unexpected_value_type in case the stored value is not a string.
+	 */
+	std::string_view string() const;
+
+	/**
+	 * @brief Get number of array elements or object members.
+	 * @return number of array elements or object members.
+	 * @throw unexpected_value_type in case the stored value is neither an array nor an object.
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief Get array element or object member value by index.
+	 * Object members are ordered by key, same way as in value::object_type.
+	 * @param index - index of the array element or object member.
+	 * @return the array element or object member value.
+	 * @throw unexpected_value_type in case the stored value is neither an array nor an object.
+	 * @throw std::out_of_range in case the index is out of range.
+	 */
+	snapshot_value at(size_t index) const;
+
+	/**
+	 * @brief Get object member key by index.
+	 * @param index - index of the object member.
+	 * @return the object member key.
+	 * @throw unexpected_value_type in case the stored value is not an object.
+	 * @throw std::out_of_range in case the index is out of range.
+	 */
+	std::string_view key(size_t index) const;
+
+	/**
+	 * @brief Find object member by key.
+	 * Performs binary search over the object members.
+	 * @param key - key of the object member.
+	 * @return the object member value, if found.
+	 * @return std::nullopt otherwise.
+	 * @throw unexpected_value_type in case the stored value is not an object.
+	 */
+	std::optional<snapshot_value> find(std::string_view key) const;
+
+	/**
+	 * @brief Get object member by key.
+	 * @param key - key of the object member.
+	 * @return the object member value.
+	 * @throw unexpected_value_type in case the stored value is not an object.
+	 * @throw std::out_of_range in case the object has no member with the given key.
+	 */
+	snapshot_value at(std::string_view key) const;
+
+	/**
+	 * @brief Convert to value.
+	 * Makes a copy of the value tree stored in the snapshot.
+	 * @return copy of the value tree.
+	 */
+	value to_value() const;
+};
+
+/**
+ * @brief Snapshot of JSON document.
+ * Gives read-only access to the snapshot data written by write_snapshot() or to_snapshot().
+ * Opening a snapshot only checks its header and, optionally, its checksum,
+ * the nodes are decoded lazily as they are navigated to.
+ *
+ * The snapshot data consists of the header followed by the nodes, all integers are little-endian:
+ * - 4 bytes: "jsds" magic;
+ * - uint32: format version, see snapshot_version;
+ * - uint32: offset of the root node;
+ * - uint32: FNV-1a checksum of the data following the header.
+ *
+ * Each node starts with uint32 type (see jsondom::type) and uint32 size, followed by:
+ * - null: nothing;
+ * - boolean: nothing, the size is the boolean value;
+ * - number and string: the text of size bytes;
+ * - array: size uint32 offsets of elements;
+ * - object: size pairs of uint32 key offset and uint32 value offset, sorted by key.
+ *   Keys are stored as string nodes.
+ *
+ * Child nodes are always stored before their parents, which allows rejecting reference cycles.
+ */
+class snapshot
+{
+	std::vector<uint8_t> buffer;
+
+	class mapping;
+	std::unique_ptr<mapping> mapped;
+
+	utki::span<const uint8_t> data;
+
+	void init(bool verify_checksum);
+
+public:
+	/**
+	 * @brief Open snapshot from memory.
+	 * The snapshot does not copy the data, so the data must stay alive while the snapshot is in use.
+	 * @param data - the snapshot data.
+	 * @param verify_checksum - whether to verify the checksum. Verifying the checksum requires
+	 *        reading all of the data, so for trusted snapshots it can be skipped to make opening instant.
+	 * @throw malformed_binary_data_error in case the snapshot header or checksum is invalid.
+	 */
+	explicit snapshot(
+		utki::span<const uint8_t> data, //
+		bool verify_checksum = true
+	);
+
+	/**
+	 * @brief Open snapshot from memory buffer.
+	 * The snapshot takes ownership of the buffer.
+	 * @param data - the snapshot data.
+	 * @param verify_checksum - whether to verify the checksum.
+	 * @throw malformed_binary_data_error in case the snapshot header or checksum is invalid.
+	 */
+	explicit snapshot(
+		std::vector<uint8_t> data, //
+		bool verify_checksum = true
+	);
+
+	/**
+	 * @brief Open snapshot file.
+	 * The file is loaded to memory.
+	 * @param fi - the snapshot file.
+	 * @param verify_checksum - whether to verify the checksum.
+	 * @throw malformed_binary_data_error in case the snapshot header or checksum is invalid.
+	 */
+	explicit snapshot(
+		const fsif::file& fi, //
+		bool verify_checksum = true
+	);
+
+	/**
+	 * @brief Memory-map snapshot file.
+	 * The file is memory-mapped read-only, so its pages are only read from disk as they are accessed.
+	 * On platforms without memory mapping support the file is loaded to memory.
+	 * @param file_name - name of the snapshot file.
+	 * @param verify_checksum - whether to verify the checksum.
+	 * @throw malformed_binary_data_error in case the snapshot header or checksum is invalid.
+	 * @throw std::system_error in case the file could not be mapped.
+	 */
+	explicit snapshot(
+		const std::string& file_name, //
+		bool verify_checksum = true
+	);
+
+	snapshot(const snapshot&) = delete;
+	snapshot& operator=(const snapshot&) = delete;
+
+	snapshot(snapshot&&) noexcept;
+	snapshot& operator=(snapshot&&) noexcept;
+
+	~snapshot();
+
+	/**
+	 * @brief Get root value.
+	 * @return the root value of the document.
+	 * @throw malformed_binary_data_error in case the root node is malformed.
+	 */
+	snapshot_value root() const;
+};
+
+} // namespace jsondom
@@ -0,0 +1,99 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "static_document.hpp"
+
+#include <utki/string.hpp>
+
+using namespace std::string_view_literals;
+
+using namespace jsondom;
+
+void internal::malformed_json_literal(
+	const char* message, //
+	size_t position
+)
+{
+	throw malformed_json_error(utki::cat(
+		"jsondom: malformed JSON literal: "sv, //
+		message,
+		" at position "sv,
+		position
+	));
+}
+
+void internal::static_value_access_error(
+	jsondom::type tried_access, //
+	jsondom::type stored
+)
+{
+	throw unexpected_value_type(utki::cat(
+		"jsondom: could not access "sv, //
+		jsondom::to_string(tried_access),
+		" value, stored value is of another type ("sv,
+		jsondom::to_string(stored),
+		")"sv
+	));
+}
+
+void internal::static_object_key_not_found(std::string_view key)
+{
+	throw std::out_of_range(utki::cat("jsondom::static_object::at(): key not found: "sv, key));
+}
+
+value static_value::to_value() const
+{
+	switch (this->get_type()) {
+		default:
+		case type::null:
+			return {};
+		case type::boolean:
+			return {this->boolean()};
+		case type::number:
+			return {string_number(std::string(this->number()))};
+		case type::string:
+			return {std::string(this->string())};
+		case type::object:
+			{
+				value ret(type::object);
+				auto& obj = ret.object();
+				for (const auto& m : this->object()) {
+					obj.emplace(m.first, m.second.to_value());
+				}
+				return ret;
+			}
+		case type::array:
+			{
+				value ret(type::array);
+				auto& arr = ret.array();
+				arr.reserve(this->array().size());
+				for (const auto& e : this->array()) {
+					arr.push_back(e.to_value());
+				}
+				return ret;
+			}
+	}
+}
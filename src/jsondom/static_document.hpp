@@ -0,0 +1,932 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "dom.hpp"
+#include "unicode_escape.hpp"
+
+namespace jsondom::internal {
+
+// Node of the JSON document parsed at compile time.
+// Nodes are stored in a flat array in document order, so the first child of a container
+// immediately follows the container node and the next sibling of a node follows its subtree.
+struct static_node {
+	jsondom::type type = jsondom::type::null;
+	bool boolean = false;
+
+	// text of string or number, position in the text buffer
+	size_t text_begin = 0;
+	size_t text_size = 0;
+
+	// key of object member, position in the text buffer
+	size_t key_begin = 0;
+	size_t key_size = 0;
+
+	// number of array elements or object members
+	size_t size = 0;
+
+	// index of the node following the subtree of this node
+	size_t end = 0;
+};
+
+// Invoked in case the JSON text is malformed. Since the function is not constexpr, during compile time parsing
+// calling it results in compilation error which shows the error message and the position in the text.
+[[noreturn]] void malformed_json_literal(
+	const char* message, //
+	size_t position
+);
+
+[[noreturn]] void static_value_access_error(
+	jsondom::type tried_access, //
+	jsondom::type stored
+);
+
+[[noreturn]] void static_object_key_not_found(std::string_view key);
+
+// Parses JSON text into the array of nodes and the text buffer.
+// In case the nodes pointer is null, only counts the number of nodes and the text buffer size.
+class static_parser
+{
+	std::string_view json;
+	size_t pos = 0;
+
+	static_node* nodes;
+	char* text;
+
+public:
+	size_t num_nodes = 0;
+	size_t text_size = 0;
+
+	constexpr static_parser(
+		std::string_view json, //
+		static_node* nodes,
+		char* text
+	) :
+		json(json),
+		nodes(nodes),
+		text(text)
+	{
+		this->skip_whitespace();
+		this->parse_value(0, 0);
+		this->skip_whitespace();
+		if (this->pos != this->json.size()) {
+			malformed_json_literal("unexpected characters after JSON value", this->pos);
+		}
+	}
+
+private:
+	constexpr char peek() const
+	{
+		if (this->pos == this->json.size()) {
+			malformed_json_literal("unexpected end of JSON", this->pos);
+		}
+		return this->json[this->pos];
+	}
+
+	constexpr char get()
+	{
+		auto c = this->peek();
+		++this->pos;
+		return c;
+	}
+
+	constexpr bool next_is(char c) const
+	{
+		return this->pos != this->json.size() && this->json[this->pos] == c;
+	}
+
+	constexpr void skip_whitespace()
+	{
+		for (; this->pos != this->json.size(); ++this->pos) {
+			switch (this->json[this->pos]) {
+				case ' ':
+				case '\t':
+				case '\n':
+				case '\r':
+					break;
+				default:
+					return;
+			}
+		}
+	}
+
+	constexpr void put(char c)
+	{
+		if (this->text) {
+			this->text[this->text_size] = c;
+		}
+		++this->text_size;
+	}
+
+	constexpr void parse_value(
+		size_t key_begin, //
+		size_t key_size
+	)
+	{
+		auto index = this->num_nodes;
+		++this->num_nodes;
+
+		static_node n;
+		n.key_begin = key_begin;
+		n.key_size = key_size;
+
+		switch (this->peek()) {
+			case '{':
+				n.type = jsondom::type::object;
+				n.size = this->parse_object(index);
+				break;
+			case '[':
+				n.type = jsondom::type::array;
+				n.size = this->parse_array();
+				break;
+			case '"':
+				n.type = jsondom::type::string;
+				n.text_begin = this->text_size;
+				this->parse_string();
+				n.text_size = this->text_size - n.text_begin;
+				break;
+			case 't':
+				n.type = jsondom::type::boolean;
+				n.boolean = true;
+				this->parse_word("true");
+				break;
+			case 'f':
+				n.type = jsondom::type::boolean;
+				this->parse_word("false");
+				break;
+			case 'n':
+				n.type = jsondom::type::null;
+				this->parse_word("null");
+				break;
+			default:
+				n.type = jsondom::type::number;
+				n.text_begin = this->text_size;
+				this->parse_number();
+				n.text_size = this->text_size - n.text_begin;
+				break;
+		}
+
+		n.end = this->num_nodes;
+		if (this->nodes) {
+			this->nodes[index] = n;
+		}
+	}
+
+	constexpr size_t parse_object(size_t index)
+	{
+		++this->pos; // skip '{'
+		this->skip_whitespace();
+
+		size_t size = 0;
+		if (this->next_is('}')) {
+			++this->pos;
+			return size;
+		}
+
+		for (;;) {
+			this->skip_whitespace();
+
+			auto key_begin = this->text_size;
+			this->parse_string();
+			auto key_size = this->text_size - key_begin;
+
+			this->check_unique_key(index, size, key_begin, key_size);
+
+			this->skip_whitespace();
+			if (this->get() != ':') {
+				malformed_json_literal("':' expected after object key", this->pos - 1);
+			}
+			this->skip_whitespace();
+
+			this->parse_value(key_begin, key_size);
+			++size;
+
+			this->skip_whitespace();
+			switch (this->get()) {
+				case '}':
+					return size;
+				case ',':
+					break;
+				default:
+					malformed_json_literal("',' or '}' expected", this->pos - 1);
+			}
+		}
+	}
+
+	constexpr void check_unique_key(
+		size_t index, //
+		size_t num_members,
+		size_t key_begin,
+		size_t key_size
+	) const
+	{
+		// the nodes are not filled during counting pass, it is enough to check the keys once
+		if (!this->nodes) {
+			return;
+		}
+
+		std::string_view key(std::next(this->text, ptrdiff_t(key_begin)), key_size);
+		for (size_t i = 0, child = index + 1; i != num_members; ++i, child = this->nodes[child].end) {
+			const auto& m = this->nodes[child];
+			if (std::string_view(std::next(this->text, ptrdiff_t(m.key_begin)), m.key_size) == key) {
+				malformed_json_literal("duplicate object key", this->pos);
+			}
+		}
+	}
+
+	constexpr size_t parse_array()
+	{
+		++this->pos; // skip '['
+		this->skip_whitespace();
+
+		size_t size = 0;
+		if (this->next_is(']')) {
+			++this->pos;
+			return size;
+		}
+
+		for (;;) {
+			this->skip_whitespace();
+
+			this->parse_value(0, 0);
+			++size;
+
+			this->skip_whitespace();
+			switch (this->get()) {
+				case ']':
+					return size;
+				case ',':
+					break;
+				default:
+					malformed_json_literal("',' or ']' expected", this->pos - 1);
+			}
+		}
+	}
+
+	constexpr void parse_word(std::string_view word)
+	{
+		if (this->json.substr(this->pos, word.size()) != word) {
+			malformed_json_literal("unexpected word, true, false or null expected", this->pos);
+		}
+		this->pos += word.size();
+	}
+
+	constexpr void parse_digits()
+	{
+		auto is_dec_digit = [](char c) {
+			return '0' <= c && c <= '9';
+		};
+
+		if (this->pos == this->json.size() || !is_dec_digit(this->json[this->pos])) {
+			malformed_json_literal("digit expected", this->pos);
+		}
+		while (this->pos != this->json.size() && is_dec_digit(this->json[this->pos])) {
+			this->put(this->json[this->pos]);
+			++this->pos;
+		}
+	}
+
+	// the same number format as accepted by jsondom::read()
+	constexpr void parse_number()
+	{
+		if (this->next_is('-')) {
+			this->put(this->get());
+		}
+		this->parse_digits();
+		if (this->next_is('.')) {
+			this->put(this->get());
+			this->parse_digits();
+		}
+		if (this->next_is('e') || this->next_is('E')) {
+			this->put(this->get());
+			if (this->next_is('-') || this->next_is('+')) {
+				this->put(this->get());
+			}
+			this->parse_digits();
+		}
+	}
+
+	constexpr char32_t parse_unicode_escape_code()
+	{
+		char32_t ch = 0;
+		for (unsigned i = 0; i != 4; ++i) {
+			auto c = this->get();
+			ch <<= 4; // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+			if ('0' <= c && c <= '9') {
+				ch |= char32_t(c - '0');
+			} else if ('a' <= c && c <= 'f') {
+				ch |= char32_t(c - 'a' + 10); // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+			} else if ('A' <= c && c <= 'F') {
+				ch |= char32_t(c - 'A' + 10); // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+			} else {
+				malformed_json_literal("hexadecimal digit expected in unicode escape sequence", this->pos - 1);
+			}
+		}
+		return ch;
+	}
+
+	// escaped character is encoded to UTF-8 by the same function as jsondom::read() uses
+	constexpr void parse_unicode_char()
+	{
+		auto ch = this->parse_unicode_escape_code();
+
+		char32_t low = 0;
+		if (is_high_surrogate(ch)) {
+			if (this->get() != '\\' || this->get() != 'u') {
+				malformed_json_literal("low surrogate escape sequence expected after high surrogate", this->pos - 1);
+			}
+			low = this->parse_unicode_escape_code();
+			if (!is_low_surrogate(low)) {
+				malformed_json_literal("low surrogate expected after high surrogate", this->pos - 1);
+			}
+		} else if (is_low_surrogate(ch)) {
+			malformed_json_literal("low surrogate is not preceded by high surrogate", this->pos - 1);
+		}
+
+		auto c = unicode_escape_to_utf8(ch, low);
+		for (size_t i = 0; i != c.size; ++i) {
+			this->put(c.bytes[i]);
+		}
+	}
+
+	constexpr void parse_string()
+	{
+		if (this->get() != '"') {
+			malformed_json_literal("'\"' expected", this->pos - 1);
+		}
+		for (;;) {
+			auto c = this->get();
+			switch (c) {
+				case '"':
+					return;
+				case '\\':
+					this->parse_escape_sequence();
+					break;
+				default:
+					this->put(c);
+					break;
+			}
+		}
+	}
+
+	constexpr void parse_escape_sequence()
+	{
+		switch (this->get()) {
+			case 'n':
+				this->put('\n');
+				break;
+			case 'r':
+				this->put('\r');
+				break;
+			case '\\':
+				this->put('\\');
+				break;
+			case '/':
+				this->put('/');
+				break;
+			case 't':
+				this->put('\t');
+				break;
+			case 'f':
+				this->put('\f');
+				break;
+			case 'b':
+				this->put('\b');
+				break;
+			case '"':
+				this->put('"');
+				break;
+			case 'u':
+				this->parse_unicode_char();
+				break;
+			default:
+				malformed_json_literal("unknown escape sequence", this->pos - 1);
+		}
+	}
+};
+
+template <bool is_object>
+class static_iterator;
+
+} // namespace jsondom::internal
+
+namespace jsondom {
+
+class static_array;
+class static_object;
+
+template <size_t num_nodes, size_t text_size>
+class static_document;
+
+/**
+ * @brief JSON value of a document parsed at compile time.
+ * Read-only view of a value stored in static_document.
+ * Provides the same accessors as jsondom::value does, except that number() gives the number text
+ * instead of string_number, because string_number cannot be created at compile time.
+ * All the accessors are constexpr, so the document can also be inspected at compile time.
+ */
+class static_value
+{
+	friend class static_array;
+	friend class static_object;
+	friend class internal::static_iterator<false>;
+	friend class internal::static_iterator<true>;
+
+	template <size_t num_nodes, size_t text_size>
+	friend class static_document;
+
+	const internal::static_node* nodes;
+	const char* text;
+
+	size_t index;
+
+	constexpr static_value(
+		const internal::static_node* nodes, //
+		const char* text,
+		size_t index
+	) :
+		nodes(nodes),
+		text(text),
+		index(index)
+	{}
+
+	constexpr const internal::static_node& node() const
+	{
+		return this->nodes[this->index];
+	}
+
+	constexpr std::string_view text_at(
+		size_t begin, //
+		size_t size
+	) const
+	{
+		return {std::next(this->text, ptrdiff_t(begin)), size};
+	}
+
+	template <jsondom::type json_type>
+	constexpr void throw_if_type_is_not() const
+	{
+		if (!this->is<json_type>()) {
+			internal::static_value_access_error(json_type, this->get_type());
+		}
+	}
+
+public:
+	/**
+	 * @brief Get value type.
+	 * @return value type.
+	 */
+	constexpr jsondom::type get_type() const noexcept
+	{
+		return this->node().type;
+	}
+
+	/**
+	 * @brief Check that the value is of the given type.
+	 * @return true if the value is of the given type.
+	 * @return false otherwise.
+	 */
+	template <jsondom::type json_type>
+	constexpr bool is() const noexcept
+	{
+		return this->get_type() == json_type;
+	}
+
+	/**
+	 * @brief Check if the value is of the null type.
+	 * @return true if the value is of the null type.
+	 * @return false otherwise.
+	 */
+	constexpr bool is_null() const noexcept
+	{
+		return this->is<type::null>();
+	}
+
+	/**
+	 * @brief Check if the value is of the boolean type.
+	 * @return true if the value is of the boolean type.
+	 * @return false otherwise.
+	 */
+	constexpr bool is_boolean() const noexcept
+	{
+		return this->is<type::boolean>();
+	}
+
+	/**
+	 * @brief Check if the value is of the number type.
+	 * @return true if the value is of the number type.
+	 * @return false otherwise.
+	 */
+	constexpr bool is_number() const noexcept
+	{
+		return this->is<type::number>();
+	}
+
+	/**
+	 * @brief Check if the value is of the string type.
+	 * @return true if the value is of the string type.
+	 * @return false otherwise.
+	 */
+	constexpr bool is_string() const noexcept
+	{
+		return this->is<type::string>();
+	}
+
+	/**
+	 * @brief Check if the value is of the array type.
+	 * @return true if the value is of the array type.
+	 * @return false otherwise.
+	 */
+	constexpr bool is_array() const noexcept
+	{
+		return this->is<type::array>();
+	}
+
+	/**
+	 * @brief Check if the value is of the object type.
+	 * @return true if the value is of the object type.
+	 * @return false otherwise.
+	 */
+	constexpr bool is_object() const noexcept
+	{
+		return this->is<type::object>();
+	}
+
+	/**
+	 * @brief Get boolean value.
+	 * @return the boolean value.
+	 * @throw unexpected_value_type in case the stored value is not a boolean.
+	 */
+	constexpr bool boolean() const
+	{
+		this->throw_if_type_is_not<type::boolean>();
+		return this->node().boolean;
+	}
+
+	/**
+	 * @brief Get number value.
+	 * @return text of the number, as it is written in the JSON text.
+	 * @throw unexpected_value_type in case the stored value is not a number.
+	 */
+	constexpr std::string_view number() const
+	{
+		this->throw_if_type_is_not<type::number>();
+		return this->text_at(this->node().text_begin, this->node().text_size);
+	}
+
+	/**
+	 * @brief Get string value.
+	 * @return the string, with escape sequences resolved.
+	 * @throw unexpected_value_type in case the stored value is not a string.
+	 */
+	constexpr std::string_view string() const
+	{
+		this->throw_if_type_is_not<type::string>();
+		return this->text_at(this->node().text_begin, this->node().text_size);
+	}
+
+	/**
+	 * @brief Get array value.
+	 * @return the array.
+	 * @throw unexpected_value_type in case the stored value is not an array.
+	 */
+	constexpr static_array array() const;
+
+	/**
+	 * @brief Get object value.
+	 * @return the object.
+	 * @throw unexpected_value_type in case the stored value is not an object.
+	 */
+	constexpr static_object object() const;
+
+	/**
+	 * @brief Convert to DOM value.
+	 * Allows using the compile time document, e.g. default configuration, as a base for modifications.
+	 * @return DOM value equal to this value.
+	 */
+	value to_value() const;
+};
+
+namespace internal {
+// Iterates over elements of static array or members of static object.
+template <bool is_object>
+class static_iterator
+{
+	static_value v;
+
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using difference_type = std::ptrdiff_t;
+	using value_type = std::conditional_t<is_object, std::pair<std::string_view, static_value>, static_value>;
+	using pointer = void;
+	using reference = value_type;
+
+	constexpr static_iterator(const static_value& v) :
+		v(v)
+	{}
+
+	constexpr value_type operator*() const
+	{
+		if constexpr (is_object) {
+			return {this->v.text_at(this->v.node().key_begin, this->v.node().key_size), this->v};
+		} else {
+			return this->v;
+		}
+	}
+
+	constexpr static_iterator& operator++()
+	{
+		this->v.index = this->v.node().end;
+		return *this;
+	}
+
+	constexpr static_iterator operator++(int)
+	{
+		auto ret = *this;
+		++(*this);
+		return ret;
+	}
+
+	constexpr bool operator==(const static_iterator& i) const noexcept
+	{
+		return this->v.index == i.v.index;
+	}
+
+	constexpr bool operator!=(const static_iterator& i) const noexcept
+	{
+		return !this->operator==(i);
+	}
+};
+} // namespace internal
+
+/**
+ * @brief JSON array of a document parsed at compile time.
+ * Accessing an element by index takes time proportional to the index,
+ * iterating over the elements takes constant time per element.
+ */
+class static_array
+{
+	friend class static_value;
+
+	static_value v;
+
+	constexpr static_array(const static_value& v) :
+		v(v)
+	{}
+
+public:
+	/**
+	 * @brief Array iterator.
+	 * Dereferences to static_value.
+	 */
+	using iterator = internal::static_iterator<false>;
+
+	/**
+	 * @brief Get number of array elements.
+	 * @return number of array elements.
+	 */
+	constexpr size_t size() const noexcept
+	{
+		return this->v.node().size;
+	}
+
+	/**
+	 * @brief Check if the array is empty.
+	 * @return true if the array has no elements.
+	 * @return false otherwise.
+	 */
+	constexpr bool empty() const noexcept
+	{
+		return this->size() == 0;
+	}
+
+	constexpr iterator begin() const noexcept
+	{
+		return {static_value(this->v.nodes, this->v.text, this->v.index + 1)};
+	}
+
+	constexpr iterator end() const noexcept
+	{
+		return {static_value(this->v.nodes, this->v.text, this->v.node().end)};
+	}
+
+	/**
+	 * @brief Get array element.
+	 * @param i - index of the element.
+	 * @return the element.
+	 * @throw std::out_of_range in case the index is out of range.
+	 */
+	constexpr static_value at(size_t i) const
+	{
+		if (i >= this->size()) {
+			throw std::out_of_range("jsondom::static_array::at(): index is out of range");
+		}
+		return *std::next(this->begin(), ptrdiff_t(i));
+	}
+
+	/**
+	 * @brief Get array element.
+	 * @param i - index of the element, must be less than size().
+	 * @return the element.
+	 */
+	constexpr static_value operator[](size_t i) const
+	{
+		return *std::next(this->begin(), ptrdiff_t(i));
+	}
+};
+
+/**
+ * @brief JSON object of a document parsed at compile time.
+ * The members are stored in the order they appear in the JSON text.
+ * Looking up a member by key takes time proportional to number of members.
+ */
+class static_object
+{
+	friend class static_value;
+
+	static_value v;
+
+	constexpr static_object(const static_value& v) :
+		v(v)
+	{}
+
+public:
+	/**
+	 * @brief Object iterator.
+	 * Dereferences to std::pair of member key and member value.
+	 */
+	using iterator = internal::static_iterator<true>;
+
+	/**
+	 * @brief Get number of object members.
+	 * @return number of object members.
+	 */
+	constexpr size_t size() const noexcept
+	{
+		return this->v.node().size;
+	}
+
+	/**
+	 * @brief Check if the object is empty.
+	 * @return true if the object has no members.
+	 * @return false otherwise.
+	 */
+	constexpr bool empty() const noexcept
+	{
+		return this->size() == 0;
+	}
+
+	constexpr iterator begin() const noexcept
+	{
+		return {static_value(this->v.nodes, this->v.text, this->v.index + 1)};
+	}
+
+	constexpr iterator end() const noexcept
+	{
+		return {static_value(this->v.nodes, this->v.text, this->v.node().end)};
+	}
+
+	/**
+	 * @brief Find object member.
+	 * @param key - key of the member to find.
+	 * @return iterator pointing to the found member.
+	 * @return end() in case there is no member with the given key.
+	 */
+	constexpr iterator find(std::string_view key) const noexcept
+	{
+		auto i = this->begin();
+		for (; i != this->end(); ++i) {
+			if ((*i).first == key) {
+				break;
+			}
+		}
+		return i;
+	}
+
+	/**
+	 * @brief Check if object has a member.
+	 * @param key - key of the member to check.
+	 * @return true if the object has a member with the given key.
+	 * @return false otherwise.
+	 */
+	constexpr bool contains(std::string_view key) const noexcept
+	{
+		return this->find(key) != this->end();
+	}
+
+	/**
+	 * @brief Get object member value.
+	 * @param key - key of the member.
+	 * @return the member value.
+	 * @throw std::out_of_range in case there is no member with the given key.
+	 */
+	constexpr static_value at(std::string_view key) const
+	{
+		auto i = this->find(key);
+		if (i == this->end()) {
+			internal::static_object_key_not_found(key);
+		}
+		return (*i).second;
+	}
+};
+
+constexpr static_array static_value::array() const
+{
+	this->throw_if_type_is_not<type::array>();
+	return {*this};
+}
+
+constexpr static_object static_value::object() const
+{
+	this->throw_if_type_is_not<type::object>();
+	return {*this};
+}
+
+/**
+ * @brief JSON document parsed at compile time.
+ * Holds all the values of the document, the values are accessed via root().
+ * Use static_read() to create the document.
+ * @tparam num_nodes - number of values in the document.
+ * @tparam text_size - total size of keys, strings and numbers of the document.
+ */
+template <size_t num_nodes, size_t text_size>
+class static_document
+{
+	template <const char* json>
+	friend constexpr auto static_read();
+
+	std::array<internal::static_node, num_nodes> nodes{};
+	std::array<char, text_size> text{};
+
+	constexpr static_document(std::string_view json)
+	{
+		internal::static_parser(json, this->nodes.data(), this->text.data());
+	}
+
+public:
+	/**
+	 * @brief Get root value of the document.
+	 * @return root value.
+	 */
+	constexpr static_value root() const noexcept
+	{
+		return {this->nodes.data(), this->text.data(), 0};
+	}
+};
+
+/**
+ * @brief Parse JSON text at compile time.
+ * The JSON text has to be given as a constexpr character array with static storage duration,
+ * because string literals cannot be template arguments:
+ * @code{.cpp}
+ * constexpr char defaults_json[] = R"({"timeout": 30, "features": {"fast_path": true}})";
+ * constexpr auto defaults = jsondom::static_read<defaults_json>();
+ *
+ * static_assert(defaults.root().object().at("features").object().at("fast_path").boolean());
+ * @endcode
+ * In case the JSON text is malformed, compilation fails with the error pointing to
+ * internal::malformed_json_literal() call, which shows the error message and position.
+ * Unlike jsondom::read(), the root value can be of any type and duplicate object keys are not allowed.
+ * @tparam json - JSON text.
+ * @return the parsed document.
+ */
+template <const char* json>
+constexpr auto static_read()
+{
+	constexpr internal::static_parser counter(json, nullptr, nullptr);
+	return static_document<counter.num_nodes, counter.text_size>(json);
+}
+
+} // namespace jsondom
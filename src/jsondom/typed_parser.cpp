@@ -0,0 +1,206 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "typed_parser.hpp"
+
+#include <cstdlib>
+
+#include <utki/string.hpp>
+
+using namespace std::string_view_literals;
+
+using namespace jsondom;
+
+void internal::throw_unexpected_value(jsondom::type type)
+{
+	throw unexpected_value_type(utki::cat(
+		"jsondom::typed_parser: unexpected "sv, //
+		jsondom::to_string(type),
+		" value"sv
+	));
+}
+
+void internal::throw_number_conversion_error(std::string_view str)
+{
+	throw unexpected_value_type(utki::cat(
+		"jsondom::typed_parser: number "sv, //
+		str,
+		" cannot be converted to the type of the value being filled"sv
+	));
+}
+
+double internal::to_floating(std::string_view str)
+{
+	double ret = 0;
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+	auto end = std::next(str.data(), ptrdiff_t(str.size()));
+	auto res = std::from_chars(str.data(), end, ret);
+	if (res.ec != std::errc() || res.ptr != end) {
+		throw_number_conversion_error(str);
+	}
+#else
+	// strtod() needs null-terminated string
+	std::string s(str);
+	char* end = nullptr;
+	ret = std::strtod(s.c_str(), &end);
+	if (end != s.c_str() + s.size()) {
+		throw_number_conversion_error(str);
+	}
+#endif
+
+	return ret;
+}
+
+void typed_parser::reset()
+{
+	this->parser::reset();
+
+	this->stack.clear();
+	this->member = {nullptr, nullptr};
+	this->skip_depth = 0;
+}
+
+internal::bound_value typed_parser::next_value()
+{
+	if (this->stack.empty()) {
+		return this->root;
+	}
+
+	const auto& container = this->stack.back();
+	if (container.binder->on_element) {
+		return container.binder->on_element(container.target);
+	}
+	return this->member;
+}
+
+void typed_parser::on_object_start()
+{
+	if (this->skip_depth != 0) {
+		++this->skip_depth;
+		return;
+	}
+
+	auto v = this->next_value();
+	if (!v.binder) {
+		++this->skip_depth;
+		return;
+	}
+
+	this->stack.push_back(v.binder->on_object_start(v.target));
+}
+
+void typed_parser::on_object_end()
+{
+	if (this->skip_depth != 0) {
+		--this->skip_depth;
+		return;
+	}
+
+	ASSERT(!this->stack.empty())
+	this->stack.pop_back();
+}
+
+void typed_parser::on_array_start()
+{
+	if (this->skip_depth != 0) {
+		++this->skip_depth;
+		return;
+	}
+
+	auto v = this->next_value();
+	if (!v.binder) {
+		++this->skip_depth;
+		return;
+	}
+
+	this->stack.push_back(v.binder->on_array_start(v.target));
+}
+
+void typed_parser::on_array_end()
+{
+	this->on_object_end();
+}
+
+void typed_parser::on_key_parsed(utki::span<const char> str)
+{
+	if (this->skip_depth != 0) {
+		return;
+	}
+
+	ASSERT(!this->stack.empty())
+	const auto& container = this->stack.back();
+	ASSERT(container.binder->on_key)
+	this->member = container.binder->on_key(container.target, std::string_view(str.data(), str.size()));
+}
+
+void typed_parser::on_string_parsed(utki::span<const char> str)
+{
+	if (this->skip_depth != 0) {
+		return;
+	}
+
+	auto v = this->next_value();
+	if (v.binder) {
+		v.binder->on_string(v.target, std::string_view(str.data(), str.size()));
+	}
+}
+
+void typed_parser::on_number_parsed(utki::span<const char> str)
+{
+	if (this->skip_depth != 0) {
+		return;
+	}
+
+	auto v = this->next_value();
+	if (v.binder) {
+		v.binder->on_number(v.target, std::string_view(str.data(), str.size()));
+	}
+}
+
+void typed_parser::on_boolean_parsed(bool b)
+{
+	if (this->skip_depth != 0) {
+		return;
+	}
+
+	auto v = this->next_value();
+	if (v.binder) {
+		v.binder->on_boolean(v.target, b);
+	}
+}
+
+void typed_parser::on_null_parsed()
+{
+	if (this->skip_depth != 0) {
+		return;
+	}
+
+	auto v = this->next_value();
+	if (v.binder) {
+		v.binder->on_null(v.target);
+	}
+}
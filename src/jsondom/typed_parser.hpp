@@ -0,0 +1,409 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <charconv>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <fsif/file.hpp>
+#include <utki/span.hpp>
+
+#include "describe.hpp"
+#include "dom.hpp"
+#include "parser.hpp"
+
+namespace jsondom::internal {
+
+struct value_binder;
+struct container_binder;
+
+// value to be filled, null binder means that the value is to be skipped
+struct bound_value {
+	void* target;
+	const value_binder* binder;
+};
+
+struct bound_container {
+	void* target;
+	const container_binder* binder;
+};
+
+// type erased operations for filling a value of certain type from parser events
+struct value_binder {
+	void (*on_null)(void* target);
+	void (*on_boolean)(void* target, bool b);
+	void (*on_number)(void* target, std::string_view str);
+	void (*on_string)(void* target, std::string_view str);
+	bound_container (*on_object_start)(void* target);
+	bound_container (*on_array_start)(void* target);
+};
+
+// type erased operations for filling a container of certain type from parser events
+struct container_binder {
+	// for objects, null for arrays
+	bound_value (*on_key)(void* target, std::string_view key);
+
+	// for arrays, null for objects
+	bound_value (*on_element)(void* target);
+};
+
+[[noreturn]] void throw_unexpected_value(jsondom::type type);
+[[noreturn]] void throw_number_conversion_error(std::string_view str);
+
+double to_floating(std::string_view str);
+
+// default operations, which throw
+struct binder_base {
+	static void on_null(void* /* target */)
+	{
+		throw_unexpected_value(type::null);
+	}
+
+	static void on_boolean(void* /* target */, bool /* b */)
+	{
+		throw_unexpected_value(type::boolean);
+	}
+
+	static void on_number(void* /* target */, std::string_view /* str */)
+	{
+		throw_unexpected_value(type::number);
+	}
+
+	static void on_string(void* /* target */, std::string_view /* str */)
+	{
+		throw_unexpected_value(type::string);
+	}
+
+	static bound_container on_object_start(void* /* target */)
+	{
+		throw_unexpected_value(type::object);
+	}
+
+	static bound_container on_array_start(void* /* target */)
+	{
+		throw_unexpected_value(type::array);
+	}
+};
+
+template <typename T, typename = void>
+struct binder;
+
+template <typename T>
+constexpr value_binder value_binder_v = {
+	&binder<T>::on_null,
+	&binder<T>::on_boolean,
+	&binder<T>::on_number,
+	&binder<T>::on_string,
+	&binder<T>::on_object_start,
+	&binder<T>::on_array_start,
+};
+
+template <typename T>
+bound_value bind(T& target)
+{
+	return {&target, &value_binder_v<T>};
+}
+
+template <>
+struct binder<bool> : public binder_base {
+	static void on_boolean(void* target, bool b)
+	{
+		*static_cast<bool*>(target) = b;
+	}
+};
+
+template <typename T>
+struct binder<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> : public binder_base {
+	static void on_number(void* target, std::string_view str)
+	{
+		auto end = std::next(str.data(), ptrdiff_t(str.size()));
+		auto res = std::from_chars(str.data(), end, *static_cast<T*>(target));
+		if (res.ec != std::errc() || res.ptr != end) {
+			throw_number_conversion_error(str);
+		}
+	}
+};
+
+template <typename T>
+struct binder<T, std::enable_if_t<std::is_floating_point_v<T>>> : public binder_base {
+	static void on_number(void* target, std::string_view str)
+	{
+		*static_cast<T*>(target) = T(to_floating(str));
+	}
+};
+
+template <>
+struct binder<std::string> : public binder_base {
+	static void on_string(void* target, std::string_view str)
+	{
+		static_cast<std::string*>(target)->assign(str);
+	}
+};
+
+template <>
+struct binder<string_number> : public binder_base {
+	static void on_number(void* target, std::string_view str)
+	{
+		*static_cast<string_number*>(target) = string_number(std::string(str));
+	}
+};
+
+template <typename T>
+struct binder<std::optional<T>> {
+	static T& emplace(void* target)
+	{
+		return static_cast<std::optional<T>*>(target)->emplace();
+	}
+
+	static void on_null(void* target)
+	{
+		static_cast<std::optional<T>*>(target)->reset();
+	}
+
+	static void on_boolean(void* target, bool b)
+	{
+		binder<T>::on_boolean(&emplace(target), b);
+	}
+
+	static void on_number(void* target, std::string_view str)
+	{
+		binder<T>::on_number(&emplace(target), str);
+	}
+
+	static void on_string(void* target, std::string_view str)
+	{
+		binder<T>::on_string(&emplace(target), str);
+	}
+
+	static bound_container on_object_start(void* target)
+	{
+		return binder<T>::on_object_start(&emplace(target));
+	}
+
+	static bound_container on_array_start(void* target)
+	{
+		return binder<T>::on_array_start(&emplace(target));
+	}
+};
+
+template <typename T, typename allocator_type>
+struct binder<std::vector<T, allocator_type>> : public binder_base {
+	using vector_type = std::vector<T, allocator_type>;
+
+	static bound_value on_element(void* target)
+	{
+		return bind(static_cast<vector_type*>(target)->emplace_back());
+	}
+
+	static constexpr container_binder container = {nullptr, &on_element};
+
+	static bound_container on_array_start(void* target)
+	{
+		static_cast<vector_type*>(target)->clear();
+		return {target, &container};
+	}
+};
+
+template <typename T, typename comparator_type, typename allocator_type>
+struct binder<std::map<std::string, T, comparator_type, allocator_type>> : public binder_base {
+	using map_type = std::map<std::string, T, comparator_type, allocator_type>;
+
+	static bound_value on_key(void* target, std::string_view key)
+	{
+		auto& v = (*static_cast<map_type*>(target))[std::string(key)];
+		// in case of duplicate keys the last one wins
+		v = T();
+		return bind(v);
+	}
+
+	static constexpr container_binder container = {&on_key, nullptr};
+
+	static bound_container on_object_start(void* target)
+	{
+		static_cast<map_type*>(target)->clear();
+		return {target, &container};
+	}
+};
+
+template <typename T>
+struct binder<T, std::enable_if_t<is_described_v<T>>> : public binder_base {
+	template <size_t index>
+	static bound_value bind_field(void* target)
+	{
+		return bind(static_cast<T*>(target)->*(std::get<index>(describe<T>::fields).pointer));
+	}
+
+	template <size_t... index>
+	static constexpr std::array<bound_value (*)(void*), sizeof...(index)> make_field_binders(
+		std::index_sequence<index...>
+	)
+	{
+		return {&bind_field<index>...};
+	}
+
+	static constexpr auto field_binders = make_field_binders(std::make_index_sequence<num_fields_v<T>>());
+
+	static bound_value on_key(void* target, std::string_view key)
+	{
+		auto index = field_table_v<T>.find(key, field_keys_v<T>);
+		if (index == num_fields_v<T>) {
+			// unknown key, skip the value
+			return {nullptr, nullptr};
+		}
+		return field_binders[index](target);
+	}
+
+	static constexpr container_binder container = {&on_key, nullptr};
+
+	static bound_container on_object_start(void* target)
+	{
+		// fields missing in JSON keep their values
+		return {target, &container};
+	}
+};
+
+} // namespace jsondom::internal
+
+namespace jsondom {
+
+/**
+ * @brief SAX parser which fills typed value.
+ * Fills the given value directly from the parsing events, without building intermediate DOM.
+ * Supported value types are:
+ * - bool;
+ * - integral and floating point types, filled from JSON numbers;
+ * - std::string;
+ * - string_number;
+ * - std::optional<T>, filled from JSON null or from whatever T is filled from;
+ * - std::vector<T>, filled from JSON arrays;
+ * - std::map<std::string, T>, filled from JSON objects;
+ * - structs described with jsondom::describe, filled from JSON objects.
+ *   Object keys are looked up in a perfect hash table generated at compile time.
+ *   Members with unknown keys are skipped, struct fields missing in the JSON object keep their values.
+ *
+ * In case JSON value type does not correspond to the type of the value being filled,
+ * unexpected_value_type exception is thrown.
+ */
+class typed_parser : public parser
+{
+	internal::bound_value root;
+
+	std::vector<internal::bound_container> stack;
+
+	// value for the next object member
+	internal::bound_value member{nullptr, nullptr};
+
+	// number of nested containers being skipped
+	size_t skip_depth = 0;
+
+	internal::bound_value next_value();
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param target - value to fill, must stay alive while the parser is used.
+	 */
+	template <typename T>
+	explicit typed_parser(T& target) :
+		root(internal::bind(target))
+	{}
+
+	/**
+	 * @brief Reset the parser to initial state.
+	 * The target value keeps whatever has been filled in it so far.
+	 */
+	void reset() override;
+
+	void on_object_start() override;
+	void on_object_end() override;
+	void on_array_start() override;
+	void on_array_end() override;
+	void on_key_parsed(utki::span<const char> str) override;
+	void on_string_parsed(utki::span<const char> str) override;
+	void on_number_parsed(utki::span<const char> str) override;
+	void on_boolean_parsed(bool b) override;
+	void on_null_parsed() override;
+};
+
+/**
+ * @brief Read JSON document from memory into typed value.
+ * See typed_parser for supported types.
+ * @param data - memory span to read the JSON document from.
+ * @param target - value to fill.
+ * @throw unexpected_value_type in case JSON value type does not correspond to the type of the value being filled.
+ */
+template <typename T>
+void read_typed(
+	utki::span<const char> data, //
+	T& target
+)
+{
+	typed_parser p(target);
+	p.feed(data);
+}
+
+/**
+ * @brief Read JSON document from memory into typed value.
+ * See typed_parser for supported types.
+ * @param data - memory span to read the JSON document from.
+ * @return the read value.
+ * @throw unexpected_value_type in case JSON value type does not correspond to the type of the value being filled.
+ */
+template <typename T>
+T read_typed(utki::span<const char> data)
+{
+	T ret{};
+	read_typed(data, ret);
+	return ret;
+}
+
+/**
+ * @brief Read JSON document from file into typed value.
+ * See typed_parser for supported types.
+ * @param fi - file to read the JSON document from.
+ * @param options - reading options.
+ * @return the read value.
+ * @throw unexpected_value_type in case JSON value type does not correspond to the type of the value being filled.
+ */
+template <typename T>
+T read_typed(
+	const fsif::file& fi, //
+	const read_options& options = {}
+)
+{
+	T ret{};
+	typed_parser p(ret);
+	read(fi, p, options);
+	return ret;
+}
+
+} // namespace jsondom
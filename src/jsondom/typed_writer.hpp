@@ -0,0 +1,386 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <fsif/file.hpp>
+
+#include "describe.hpp"
+#include "dom.hpp"
+#include "writer.hpp"
+
+namespace jsondom::internal {
+
+struct writer_access {
+	static std::string& buffer(writer& w)
+	{
+		return w.buffer;
+	}
+
+	static bool ensure_ascii(const writer& w)
+	{
+		return w.options.ensure_ascii;
+	}
+
+	static void before_value(writer& w)
+	{
+		w.before_value();
+	}
+
+	static void after_value(writer& w)
+	{
+		w.after_value();
+	}
+
+	static void flush_if_needed(writer& w)
+	{
+		w.flush_if_needed();
+	}
+
+	// writes quoted string
+	static void write_escaped_string(writer& w, std::string_view str)
+	{
+		w.write_escaped_string(str);
+	}
+
+	static void write_value(writer& w, const jsondom::value& v)
+	{
+		w.write_value(v);
+	}
+};
+
+template <typename T, typename = void>
+struct serializer;
+
+template <typename T>
+void serialize(writer& w, const T& v)
+{
+	serializer<T>::write(w, v);
+}
+
+template <>
+struct serializer<bool> {
+	static void write(writer& w, bool v)
+	{
+		using namespace std::string_view_literals;
+		writer_access::buffer(w).append(v ? "true"sv : "false"sv);
+	}
+};
+
+template <typename T>
+struct serializer<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+	static void write(writer& w, T v)
+	{
+		// enough for 64-bit integers with sign
+		constexpr auto max_chars = 24;
+		std::array<char, max_chars> buf{};
+		auto res = std::to_chars(buf.data(), std::next(buf.data(), buf.size()), v);
+		writer_access::buffer(w).append(buf.data(), res.ptr);
+	}
+};
+
+template <typename T>
+struct serializer<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+	static void write(writer& w, T v)
+	{
+		auto& out = writer_access::buffer(w);
+
+		// JSON has no representation for infinities and NaNs
+		if (!std::isfinite(v)) {
+			using namespace std::string_view_literals;
+			out.append("null"sv);
+			return;
+		}
+
+		constexpr auto max_chars = 32;
+		std::array<char, max_chars> buf{};
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+		// format with the value's own type, so that shortest form of e.g. float 0.1f is "0.1"
+		auto res = std::to_chars(buf.data(), std::next(buf.data(), buf.size()), v);
+		out.append(buf.data(), res.ptr);
+#else
+		// max_digits10 is enough for the value to parse back exactly, e.g. 9 for float and 17 for double
+		int res = 0;
+		if constexpr (std::is_same_v<T, long double>) {
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+			res = snprintf(buf.data(), buf.size(), "%.*Lg", std::numeric_limits<T>::max_digits10, v);
+		} else {
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+			res = snprintf(buf.data(), buf.size(), "%.*g", std::numeric_limits<T>::max_digits10, double(v));
+		}
+		out.append(buf.data(), size_t(res));
+#endif
+	}
+};
+
+template <>
+struct serializer<std::string> {
+	static void write(writer& w, const std::string& v)
+	{
+		writer_access::write_escaped_string(w, v);
+	}
+};
+
+template <>
+struct serializer<std::string_view> {
+	static void write(writer& w, std::string_view v)
+	{
+		writer_access::write_escaped_string(w, v);
+	}
+};
+
+template <>
+struct serializer<string_number> {
+	static void write(writer& w, const string_number& v)
+	{
+		writer_access::buffer(w).append(v.get_string());
+	}
+};
+
+template <>
+struct serializer<jsondom::value> {
+	static void write(writer& w, const jsondom::value& v)
+	{
+		writer_access::write_value(w, v);
+	}
+};
+
+template <typename T>
+struct serializer<std::optional<T>> {
+	static void write(writer& w, const std::optional<T>& v)
+	{
+		if (!v.has_value()) {
+			using namespace std::string_view_literals;
+			writer_access::buffer(w).append("null"sv);
+			return;
+		}
+		serialize(w, v.value());
+	}
+};
+
+template <typename T, typename allocator_type>
+struct serializer<std::vector<T, allocator_type>> {
+	static void write(writer& w, const std::vector<T, allocator_type>& v)
+	{
+		writer_access::buffer(w).push_back('[');
+		for (auto i = v.begin(); i != v.end(); ++i) {
+			if (i != v.begin()) {
+				writer_access::buffer(w).push_back(',');
+			}
+			serialize(w, *i);
+			writer_access::flush_if_needed(w);
+		}
+		writer_access::buffer(w).push_back(']');
+	}
+};
+
+template <typename T, typename comparator_type, typename allocator_type>
+struct serializer<std::map<std::string, T, comparator_type, allocator_type>> {
+	static void write(writer& w, const std::map<std::string, T, comparator_type, allocator_type>& v)
+	{
+		writer_access::buffer(w).push_back('{');
+		for (auto i = v.begin(); i != v.end(); ++i) {
+			if (i != v.begin()) {
+				writer_access::buffer(w).push_back(',');
+			}
+			writer_access::write_escaped_string(w, i->first);
+			writer_access::buffer(w).push_back(':');
+			serialize(w, i->second);
+			writer_access::flush_if_needed(w);
+		}
+		writer_access::buffer(w).push_back('}');
+	}
+};
+
+constexpr bool key_needs_escaping(std::string_view key)
+{
+	constexpr auto first_non_control_char = 0x20;
+	constexpr auto first_non_ascii_char = 0x80;
+	for (auto c : key) {
+		auto b = uint8_t(c);
+		if (b < first_non_control_char || b >= first_non_ascii_char || c == '"' || c == '\\' || c == '/') {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Precomputed text written before the value of described struct field.
+ * It is '{' for the first field or ',' for the rest of the fields, followed by the quoted key and ':'.
+ */
+template <typename T, size_t index>
+struct field_prefix {
+	static constexpr std::string_view key = field_keys_v<T>[index];
+
+	// keys which need escaping are written with runtime escaping
+	static constexpr bool is_precomputed = !key_needs_escaping(key);
+
+	static constexpr size_t size = key.size() + 4;
+
+	static constexpr std::array<char, size> chars = [] {
+		std::array<char, size> ret{};
+		size_t pos = 0;
+		ret[pos++] = index == 0 ? '{' : ',';
+		ret[pos++] = '"';
+		for (auto c : key) {
+			ret[pos++] = c;
+		}
+		ret[pos++] = '"';
+		ret[pos++] = ':';
+		return ret;
+	}();
+
+	static void write(writer& w)
+	{
+		if constexpr (is_precomputed) {
+			writer_access::buffer(w).append(chars.data(), chars.size());
+		} else {
+			writer_access::buffer(w).push_back(index == 0 ? '{' : ',');
+			writer_access::write_escaped_string(w, key);
+			writer_access::buffer(w).push_back(':');
+		}
+	}
+};
+
+template <typename T>
+struct serializer<T, std::enable_if_t<is_described_v<T>>> {
+	template <size_t index>
+	static void write_field(writer& w, const T& v)
+	{
+		field_prefix<T, index>::write(w);
+		serialize(w, v.*(std::get<index>(describe<T>::fields).pointer));
+	}
+
+	template <size_t... index>
+	static void write_fields(writer& w, const T& v, std::index_sequence<index...>)
+	{
+		(write_field<index>(w, v), ...);
+	}
+
+	static void write(writer& w, const T& v)
+	{
+		if constexpr (num_fields_v<T> == 0) {
+			writer_access::buffer(w).push_back('{');
+		} else {
+			write_fields(w, v, std::make_index_sequence<num_fields_v<T>>());
+		}
+		writer_access::buffer(w).push_back('}');
+	}
+};
+
+} // namespace jsondom::internal
+
+namespace jsondom {
+
+/**
+ * @brief Write typed value.
+ * Serializes the value directly to the writer's output, without building a DOM for it first.
+ * Supported value types are:
+ * - bool;
+ * - integral types;
+ * - floating point types, non-finite values are written as null;
+ * - std::string and std::string_view;
+ * - string_number;
+ * - jsondom::value;
+ * - std::optional<T>, empty optional is written as null;
+ * - std::vector<T>, written as JSON array;
+ * - std::map<std::string, T>, written as JSON object;
+ * - structs described with jsondom::describe, written as JSON objects with fields in the order of description.
+ *   The quoted keys along with the separating punctuation are precomputed at compile time.
+ *
+ * Numbers are formatted with std::to_chars() in their own type, floating point numbers are formatted in shortest form
+ * which parses back to the same value.
+ * @param w - writer to write the value to.
+ * @param v - value to write.
+ */
+template <typename T>
+void write_typed(
+	writer& w, //
+	const T& v
+)
+{
+	internal::writer_access::before_value(w);
+	internal::serialize(w, v);
+	internal::writer_access::after_value(w);
+}
+
+/**
+ * @brief Write typed value to file as JSON document.
+ * See write_typed(writer&, const T&) for supported types.
+ * @param fi - file to write the JSON document to.
+ * @param v - root value of the document to write.
+ * @param options - writing options. The num_threads option is ignored.
+ */
+template <typename T>
+void write_typed(
+	fsif::file& fi, //
+	const T& v,
+	const write_options& options = {}
+)
+{
+	fsif::file::guard file_guard(
+		fi, //
+		fsif::mode::create
+	);
+
+	writer w(fi, options);
+	write_typed(w, v);
+}
+
+/**
+ * @brief Serialize typed value to JSON string.
+ * See write_typed(writer&, const T&) for supported types.
+ * @param v - value to serialize.
+ * @param options - writing options. The num_threads option is ignored.
+ * @return JSON string.
+ */
+template <typename T>
+std::string to_string_typed(
+	const T& v, //
+	const write_options& options = {}
+)
+{
+	writer w(options);
+	write_typed(w, v);
+	return w.reset_data();
+}
+
+} // namespace jsondom
@@ -0,0 +1,104 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+// Unicode escape sequence helpers shared by the runtime and compile time parsers, not part of the public API.
+
+namespace jsondom::internal {
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+constexpr bool is_high_surrogate(char32_t c)
+{
+	return 0xd800 <= c && c <= 0xdbff;
+}
+
+constexpr bool is_low_surrogate(char32_t c)
+{
+	return 0xdc00 <= c && c <= 0xdfff;
+}
+
+/**
+ * @brief UTF-8 encoding of a single character.
+ */
+struct utf8_char {
+	std::array<char, 4> bytes{};
+	size_t size = 0;
+};
+
+/**
+ * @brief Convert character given by \uXXXX escape sequence(s) to UTF-8.
+ * Characters outside of the Basic Multilingual Plane are escaped as UTF-16 surrogate pair,
+ * i.e. as two escape sequences, the high surrogate followed by the low surrogate.
+ * Checking that the surrogates come in pairs is up to the caller.
+ * U+0000 is encoded as a zero byte, the same way as jsondom::writer escapes zero bytes.
+ * @param code_unit - code of the escape sequence, or the high surrogate of the pair.
+ * @param low_surrogate - low surrogate of the pair, 0 if the code_unit is not a high surrogate.
+ * @return UTF-8 encoding of the character.
+ */
+constexpr utf8_char unicode_escape_to_utf8(
+	char32_t code_unit, //
+	char32_t low_surrogate = 0
+)
+{
+	utf8_char ret;
+
+	char32_t c = code_unit;
+	if (is_high_surrogate(code_unit)) {
+		c = 0x10000 + ((code_unit - 0xd800) << 10) + (low_surrogate - 0xdc00);
+	}
+
+	if (c < 0x80) {
+		ret.bytes[0] = char(c);
+		ret.size = 1;
+	} else if (c < 0x800) {
+		ret.bytes[0] = char(0xc0 | (c >> 6));
+		ret.bytes[1] = char(0x80 | (c & 0x3f));
+		ret.size = 2;
+	} else if (c < 0x10000) {
+		ret.bytes[0] = char(0xe0 | (c >> 12));
+		ret.bytes[1] = char(0x80 | ((c >> 6) & 0x3f));
+		ret.bytes[2] = char(0x80 | (c & 0x3f));
+		ret.size = 3;
+	} else {
+		ret.bytes[0] = char(0xf0 | (c >> 18));
+		ret.bytes[1] = char(0x80 | ((c >> 12) & 0x3f));
+		ret.bytes[2] = char(0x80 | ((c >> 6) & 0x3f));
+		ret.bytes[3] = char(0x80 | (c & 0x3f));
+		ret.size = 4;
+	}
+
+	return ret;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+} // namespace jsondom::internal
@@ -0,0 +1,1219 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "writer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <utki/util.hpp>
+
+#if CFG_OS != CFG_OS_WINDOWS
+#	include <cerrno>
+#	include <climits>
+#	include <deque>
+#	include <system_error>
+
+#	include <sys/uio.h>
+#	include <unistd.h>
+#endif
+
+using namespace std::string_view_literals;
+
+using namespace jsondom;
+
+namespace {
+constexpr auto word_ones = ~uint64_t(0) / std::numeric_limits<uint8_t>::max();
+constexpr auto word_high_bits = word_ones * 0x80;
+constexpr auto word_low_bits = ~word_high_bits;
+constexpr auto first_non_control_char = 0x20;
+constexpr auto first_non_ascii_char = 0x80;
+} // namespace
+
+namespace {
+// Check if any byte of the machine word needs escaping.
+bool word_needs_escaping(uint64_t word, bool ensure_ascii)
+{
+	auto has_byte = [word](char c) {
+		auto w = word ^ (word_ones * uint8_t(c));
+		// exact per byte zero test
+		return ~(((w & word_low_bits) + word_low_bits) | w | word_low_bits);
+	};
+
+	// bytes less than 0x20, i.e. control characters
+	auto control_chars = (word - word_ones * first_non_control_char) & ~word & word_high_bits;
+
+	auto non_ascii_chars = ensure_ascii ? (word & word_high_bits) : 0;
+
+	return (control_chars | non_ascii_chars | has_byte('"') | has_byte('\\') | has_byte('/')) != 0;
+}
+} // namespace
+
+namespace {
+bool needs_escaping(char c, bool ensure_ascii)
+{
+	auto b = uint8_t(c);
+	return b < first_non_control_char || c == '"' || c == '\\' || c == '/' ||
+		(ensure_ascii && b >= first_non_ascii_char);
+}
+} // namespace
+
+namespace {
+void write_unicode_escape(std::string& out, uint32_t code_unit)
+{
+	constexpr auto hex_digits = "0123456789abcdef"sv;
+	constexpr auto num_digits = 4;
+	constexpr auto bits_per_digit = 4;
+	constexpr auto digit_mask = 0xf;
+
+	out.append("\\u"sv);
+	for (int i = num_digits - 1; i >= 0; --i) {
+		out.push_back(hex_digits[(code_unit >> (i * bits_per_digit)) & digit_mask]);
+	}
+}
+} // namespace
+
+namespace {
+// Decode UTF-8 character starting at the given position.
+// Returns the decoded character and number of bytes it occupies.
+// Invalid sequence is decoded as one byte U+FFFD replacement character.
+std::pair<char32_t, size_t> decode_utf8(const char* p, const char* end)
+{
+	constexpr auto replacement_char = U'\xfffd';
+
+	auto lead = uint8_t(*p);
+
+	size_t len = 0;
+	char32_t c = 0;
+	char32_t min = 0;
+	// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+	if ((lead & 0xe0) == 0xc0) {
+		len = 2;
+		c = lead & 0x1f;
+		min = 0x80;
+	} else if ((lead & 0xf0) == 0xe0) {
+		len = 3;
+		c = lead & 0x0f;
+		min = 0x800;
+	} else if ((lead & 0xf8) == 0xf0) {
+		len = 4;
+		c = lead & 0x07;
+		min = 0x10000;
+	} else {
+		return {replacement_char, 1};
+	}
+
+	if (end - p < ptrdiff_t(len)) {
+		return {replacement_char, 1};
+	}
+
+	for (size_t i = 1; i != len; ++i) {
+		auto b = uint8_t(p[i]);
+		if ((b & 0xc0) != 0x80) {
+			return {replacement_char, 1};
+		}
+		c = (c << 6) | (b & 0x3f);
+	}
+
+	// reject overlong encodings, surrogates and out of range values
+	if (c < min || (0xd800 <= c && c <= 0xdfff) || c > 0x10ffff) {
+		return {replacement_char, 1};
+	}
+	// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+	return {c, len};
+}
+} // namespace
+
+namespace {
+// Write escape sequence for the character at the given position.
+// Returns position right after the escaped character.
+const char* write_escape_sequence(std::string& out, const char* p, const char* end)
+{
+	char escape = 0;
+	switch (*p) {
+		case '"':
+			escape = '"';
+			break;
+		case '\\':
+			escape = '\\';
+			break;
+		case '/':
+			escape = '/';
+			break;
+		case '\b':
+			escape = 'b';
+			break;
+		case '\f':
+			escape = 'f';
+			break;
+		case '\n':
+			escape = 'n';
+			break;
+		case '\r':
+			escape = 'r';
+			break;
+		case '\t':
+			escape = 't';
+			break;
+		default:
+			break;
+	}
+
+	if (escape != 0) {
+		out.push_back('\\');
+		out.push_back(escape);
+		return std::next(p);
+	}
+
+	if (uint8_t(*p) < first_non_control_char) {
+		write_unicode_escape(out, uint8_t(*p));
+		return std::next(p);
+	}
+
+	// non-ASCII character
+	auto [c, len] = decode_utf8(p, end);
+
+	// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+	if (c < 0x10000) {
+		write_unicode_escape(out, c);
+	} else {
+		// encode as UTF-16 surrogate pair
+		c -= 0x10000;
+		write_unicode_escape(out, 0xd800 + (c >> 10));
+		write_unicode_escape(out, 0xdc00 + (c & 0x3ff));
+	}
+	// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+	return std::next(p, ptrdiff_t(len));
+}
+} // namespace
+
+namespace {
+void write_escaped_string(std::string& out, std::string_view str, bool ensure_ascii)
+{
+	const char* p = str.data();
+	const char* end = std::next(p, ptrdiff_t(str.size()));
+
+	while (true) {
+		// find next character which needs escaping, a machine word at a time
+		const char* i = p;
+		for (; end - i >= ptrdiff_t(sizeof(uint64_t)); i += sizeof(uint64_t)) {
+			uint64_t word = 0;
+			std::memcpy(&word, i, sizeof(word));
+			if (word_needs_escaping(word, ensure_ascii)) {
+				break;
+			}
+		}
+		for (; i != end; ++i) {
+			if (needs_escaping(*i, ensure_ascii)) {
+				break;
+			}
+		}
+
+		// copy the run of characters which do not need escaping at once
+		out.append(p, std::distance(p, i));
+
+		if (i == end) {
+			return;
+		}
+
+		p = write_escape_sequence(out, i, end);
+	}
+}
+} // namespace
+
+namespace {
+constexpr auto word_true = "true"sv;
+constexpr auto word_false = "false"sv;
+constexpr auto word_null = "null"sv;
+
+constexpr const size_t flush_threshold = size_t(utki::kilobyte) * 64;
+
+// capacity of the file output buffer, the threshold plus some extra space for the last written element
+constexpr const size_t max_buffer_capacity = flush_threshold + size_t(utki::kilobyte) * 4;
+
+// values of smaller estimated size are not worth serializing in parallel
+constexpr const size_t parallel_threshold = size_t(utki::megabyte);
+} // namespace
+
+namespace {
+// Estimate size of the serialized value, not taking into account string escaping.
+size_t estimate_size(const jsondom::value& v)
+{
+	switch (v.get_type()) {
+		default:
+		case type::null:
+			return word_null.size();
+		case type::boolean:
+			return v.boolean() ? word_true.size() : word_false.size();
+		case type::number:
+			return v.number().get_string().size();
+		case type::string:
+			// string plus quotes
+			return v.string().size() + 2;
+		case type::array:
+			{
+				// brackets and commas
+				size_t size = 1 + std::max(v.array().size(), size_t(1));
+				for (const auto& e : v.array()) {
+					size += estimate_size(e);
+				}
+				return size;
+			}
+		case type::object:
+			{
+				// braces and commas
+				size_t size = 1 + std::max(v.object().size(), size_t(1));
+				for (const auto& kv : v.object()) {
+					// key, quotes and colon
+					size += kv.first.size() + 3;
+					size += estimate_size(kv.second);
+				}
+				return size;
+			}
+	}
+}
+} // namespace
+
+writer::writer(
+	fsif::file& fi, //
+	const write_options& options
+) :
+	fi(&fi),
+	options(options)
+{
+	// the buffer is not reserved upfront, it grows on demand,
+	// so that small documents do not cost the whole flush threshold of memory
+}
+
+void writer::flush()
+{
+	if (!this->fi || this->buffer.empty()) {
+		return;
+	}
+	this->fi->write(utki::make_span(this->buffer));
+	this->buffer.clear();
+}
+
+void writer::before_value()
+{
+	if (this->stack.empty()) {
+		ASSERT(!this->root_written, [](auto& o) {
+			o << "jsondom::writer: JSON document can have only one root value";
+		})
+		return;
+	}
+
+	auto& top = this->stack.back();
+	if (top.is_object) {
+		ASSERT(this->key_written, [](auto& o) {
+			o << "jsondom::writer: no key written for the object's value";
+		})
+		this->key_written = false;
+		return;
+	}
+
+	if (top.is_first) {
+		top.is_first = false;
+	} else {
+		this->buffer.push_back(',');
+	}
+}
+
+void writer::after_value()
+{
+	if (this->stack.empty()) {
+		this->root_written = true;
+		this->flush();
+		return;
+	}
+
+	this->flush_if_needed();
+}
+
+void writer::flush_if_needed()
+{
+	if (!this->fi) {
+		return;
+	}
+
+	if (this->buffer.size() >= flush_threshold) {
+		this->flush();
+		return;
+	}
+
+	// in case the next growth of the buffer, which usually doubles the capacity, would go beyond
+	// the maximal capacity, then grow it right to the maximal capacity.
+	// Reserving on the buffer itself may also double its capacity, so move the contents to a new buffer.
+	auto capacity = this->buffer.capacity();
+	if (capacity < max_buffer_capacity && capacity * 2 > max_buffer_capacity) {
+		std::string grown;
+		grown.reserve(max_buffer_capacity);
+		grown.append(this->buffer);
+		this->buffer = std::move(grown);
+	}
+}
+
+void writer::write_escaped_string(std::string_view str)
+{
+	this->buffer.push_back('"');
+	::write_escaped_string(this->buffer, str, this->options.ensure_ascii);
+	this->buffer.push_back('"');
+}
+
+void writer::begin_object()
+{
+	this->before_value();
+	this->buffer.push_back('{');
+	this->stack.push_back({true});
+}
+
+void writer::end_object()
+{
+	ASSERT(!this->stack.empty() && this->stack.back().is_object, [](auto& o) {
+		o << "jsondom::writer::end_object(): no object to end";
+	})
+	ASSERT(!this->key_written, [](auto& o) {
+		o << "jsondom::writer::end_object(): no value written for the last key";
+	})
+	this->stack.pop_back();
+	this->buffer.push_back('}');
+	this->after_value();
+}
+
+void writer::begin_array()
+{
+	this->before_value();
+	this->buffer.push_back('[');
+	this->stack.push_back({false});
+}
+
+void writer::end_array()
+{
+	ASSERT(!this->stack.empty() && !this->stack.back().is_object, [](auto& o) {
+		o << "jsondom::writer::end_array(): no array to end";
+	})
+	this->stack.pop_back();
+	this->buffer.push_back(']');
+	this->after_value();
+}
+
+void writer::key(std::string_view key)
+{
+	ASSERT(!this->stack.empty() && this->stack.back().is_object, [](auto& o) {
+		o << "jsondom::writer::key(): key is written outside of object";
+	})
+	ASSERT(!this->key_written, [](auto& o) {
+		o << "jsondom::writer::key(): no value written for the previous key";
+	})
+
+	auto& top = this->stack.back();
+	if (top.is_first) {
+		top.is_first = false;
+	} else {
+		this->buffer.push_back(',');
+	}
+
+	this->write_escaped_string(key);
+	this->buffer.push_back(':');
+	this->key_written = true;
+}
+
+void writer::value(std::string_view str)
+{
+	this->before_value();
+	this->write_escaped_string(str);
+	this->after_value();
+}
+
+void writer::value(const string_number& num)
+{
+	this->before_value();
+	this->buffer.append(num.get_string());
+	this->after_value();
+}
+
+void writer::value(bool b)
+{
+	this->before_value();
+	this->buffer.append(b ? word_true : word_false);
+	this->after_value();
+}
+
+void writer::value(std::nullptr_t)
+{
+	this->before_value();
+	this->buffer.append(word_null);
+	this->after_value();
+}
+
+void writer::value(const jsondom::value& v)
+{
+	this->before_value();
+
+	if (this->options.cache_subtrees && (v.is_object() || v.is_array())) {
+		this->write_value_cached(v);
+	} else if (this->options.num_threads == 1 && this->fi) {
+		this->write_value(v);
+	} else {
+		auto size = estimate_size(v);
+
+		if (!this->fi && this->buffer.empty()) {
+			this->buffer.reserve(size);
+		}
+
+		if (this->options.num_threads != 1 && size >= parallel_threshold) {
+			this->write_value_parallel(v, size);
+		} else {
+			this->write_value(v);
+		}
+	}
+
+	this->after_value();
+}
+
+namespace {
+// Serialize value to string.
+// The after_element callback is invoked after writing each element of arrays and objects.
+template <typename after_element_type>
+void write_value(
+	std::string& out, //
+	const jsondom::value& v,
+	bool ensure_ascii,
+	const after_element_type& after_element
+)
+{
+	switch (v.get_type()) {
+		default:
+		case type::null:
+			out.append(word_null);
+			break;
+		case type::boolean:
+			out.append(v.boolean() ? word_true : word_false);
+			break;
+		case type::number:
+			out.append(v.number().get_string());
+			break;
+		case type::string:
+			out.push_back('"');
+			write_escaped_string(out, v.string(), ensure_ascii);
+			out.push_back('"');
+			break;
+		case type::array:
+			out.push_back('[');
+			for (auto i = v.array().begin(); i != v.array().end(); ++i) {
+				if (i != v.array().begin()) {
+					out.push_back(',');
+				}
+				write_value(out, *i, ensure_ascii, after_element);
+				after_element();
+			}
+			out.push_back(']');
+			break;
+		case type::object:
+			out.push_back('{');
+			for (auto i = v.object().begin(); i != v.object().end(); ++i) {
+				if (i != v.object().begin()) {
+					out.push_back(',');
+				}
+				out.push_back('"');
+				write_escaped_string(out, i->first, ensure_ascii);
+				out.push_back('"');
+				out.push_back(':');
+				write_value(out, i->second, ensure_ascii, after_element);
+				after_element();
+			}
+			out.push_back('}');
+			break;
+	}
+}
+} // namespace
+
+namespace {
+void write_value(
+	std::string& out, //
+	const jsondom::value& v,
+	bool ensure_ascii
+)
+{
+	write_value(out, v, ensure_ascii, []() {});
+}
+} // namespace
+
+void writer::write_value(const jsondom::value& v)
+{
+	::write_value(this->buffer, v, this->options.ensure_ascii, [this]() {
+		this->flush_if_needed();
+	});
+}
+
+namespace jsondom::internal {
+// Serialized text of an object or array.
+// Text of nested objects and arrays is not included, it is stored in their own caches.
+struct serialized_cache {
+	bool ensure_ascii;
+
+	std::string text;
+
+	// nested objects and arrays along with positions in the text where their serialized text goes
+	std::vector<std::pair<size_t, const jsondom::value*>> nested;
+};
+} // namespace jsondom::internal
+
+namespace {
+// Get serialized text cache of the object or array value, serialize the value in case there is no cache.
+std::shared_ptr<const internal::serialized_cache> get_serialized_cache(
+	std::shared_ptr<const internal::serialized_cache>& cache, //
+	const jsondom::value& v,
+	bool ensure_ascii
+)
+{
+	// the same value can be written from several threads, so access the cache atomically
+	if (auto c = std::atomic_load(&cache); c && c->ensure_ascii == ensure_ascii) {
+		return c;
+	}
+
+	auto c = std::make_shared<internal::serialized_cache>();
+	c->ensure_ascii = ensure_ascii;
+
+	auto write_child = [&c, ensure_ascii](const jsondom::value& child) {
+		if (child.is_object() || child.is_array()) {
+			c->nested.emplace_back(c->text.size(), &child);
+		} else {
+			write_value(c->text, child, ensure_ascii);
+		}
+	};
+
+	if (v.is_object()) {
+		c->text.push_back('{');
+		for (auto i = v.object().begin(); i != v.object().end(); ++i) {
+			if (i != v.object().begin()) {
+				c->text.push_back(',');
+			}
+			c->text.push_back('"');
+			write_escaped_string(c->text, i->first, ensure_ascii);
+			c->text.push_back('"');
+			c->text.push_back(':');
+			write_child(i->second);
+		}
+		c->text.push_back('}');
+	} else {
+		ASSERT(v.is_array())
+		c->text.push_back('[');
+		for (auto i = v.array().begin(); i != v.array().end(); ++i) {
+			if (i != v.array().begin()) {
+				c->text.push_back(',');
+			}
+			write_child(*i);
+		}
+		c->text.push_back(']');
+	}
+
+	std::atomic_store(&cache, std::shared_ptr<const internal::serialized_cache>(c));
+	return c;
+}
+} // namespace
+
+void writer::write_value_cached(const jsondom::value& v)
+{
+	auto c = get_serialized_cache(v.serialized_cache(), v, this->options.ensure_ascii);
+
+	size_t pos = 0;
+	for (const auto& [offset, child] : c->nested) {
+		this->buffer.append(c->text, pos, offset - pos);
+		pos = offset;
+		this->write_value_cached(*child);
+		this->flush_if_needed();
+	}
+	this->buffer.append(c->text, pos);
+}
+
+namespace {
+// Part of the output of parallel serialization.
+// Either a ready text, or a task producing the text.
+struct piece {
+	std::string text;
+	std::function<std::string()> task;
+
+	bool ready = false;
+	std::exception_ptr exception;
+};
+} // namespace
+
+namespace {
+// Splits serialization of a container value into pieces of about target_size bytes.
+class splitter
+{
+	bool ensure_ascii;
+	size_t target_size;
+
+	std::vector<piece>& pieces;
+
+	std::string& text()
+	{
+		if (this->pieces.empty() || this->pieces.back().task) {
+			this->pieces.emplace_back();
+		}
+		return this->pieces.back().text;
+	}
+
+	template <typename iterator_type, typename get_value_type, typename write_prefix_type>
+	void split_children(
+		iterator_type begin, //
+		iterator_type end,
+		get_value_type get_value,
+		write_prefix_type write_prefix
+	)
+	{
+		auto group_begin = begin;
+		size_t group_size = 0;
+
+		auto add_group = [&](iterator_type group_end) {
+			if (group_begin == group_end) {
+				return;
+			}
+			this->pieces.push_back({
+				{},
+				[ensure_ascii = this->ensure_ascii,
+				 is_first = (group_begin == begin),
+				 group_begin,
+				 group_end,
+				 get_value,
+				 write_prefix]() {
+					std::string out;
+					for (auto i = group_begin; i != group_end; ++i) {
+						if (i != group_begin || !is_first) {
+							out.push_back(',');
+						}
+						write_prefix(out, *i, ensure_ascii);
+						write_value(out, get_value(*i), ensure_ascii);
+					}
+					return out;
+				}
+			});
+		};
+
+		for (auto i = begin; i != end; ++i) {
+			const auto& child = get_value(*i);
+			auto size = estimate_size(child);
+
+			if (size > this->target_size && (child.is_array() || child.is_object())) {
+				// child is too big, split it into pieces as well
+				add_group(i);
+				auto& str = this->text();
+				if (i != begin) {
+					str.push_back(',');
+				}
+				write_prefix(str, *i, this->ensure_ascii);
+				this->split(child);
+				group_begin = std::next(i);
+				group_size = 0;
+				continue;
+			}
+
+			group_size += size;
+			if (group_size >= this->target_size) {
+				add_group(std::next(i));
+				group_begin = std::next(i);
+				group_size = 0;
+			}
+		}
+		add_group(end);
+	}
+
+public:
+	splitter(
+		bool ensure_ascii, //
+		size_t target_size,
+		std::vector<piece>& pieces
+	) :
+		ensure_ascii(ensure_ascii),
+		target_size(target_size),
+		pieces(pieces)
+	{}
+
+	void split(const jsondom::value& v)
+	{
+		switch (v.get_type()) {
+			case type::array:
+				this->text().push_back('[');
+				this->split_children(
+					v.array().begin(),
+					v.array().end(),
+					[](const jsondom::value& e) -> const jsondom::value& {
+						return e;
+					},
+					[](std::string&, const jsondom::value&, bool) {}
+				);
+				this->text().push_back(']');
+				break;
+			case type::object:
+				this->text().push_back('{');
+				this->split_children(
+					v.object().begin(),
+					v.object().end(),
+					[](const auto& kv) -> const jsondom::value& {
+						return kv.second;
+					},
+					[](std::string& out, const auto& kv, bool ensure_ascii) {
+						out.push_back('"');
+						write_escaped_string(out, kv.first, ensure_ascii);
+						out.push_back('"');
+						out.push_back(':');
+					}
+				);
+				this->text().push_back('}');
+				break;
+			default:
+				write_value(this->text(), v, this->ensure_ascii);
+				break;
+		}
+	}
+};
+} // namespace
+
+void writer::write_value_parallel(const jsondom::value& v, size_t estimated_size)
+{
+	auto num_threads = this->options.num_threads;
+	if (num_threads == 0) {
+		num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	// several pieces per thread for better load balancing
+	constexpr auto pieces_per_thread = 4;
+
+	std::vector<piece> pieces;
+	splitter(
+		this->options.ensure_ascii, //
+		std::max(estimated_size / (num_threads * pieces_per_thread), flush_threshold),
+		pieces
+	)
+		.split(v);
+
+	std::mutex mutex;
+	std::condition_variable cv;
+
+	std::atomic<size_t> next_piece = 0;
+
+	auto worker = [&]() {
+		while (true) {
+			auto index = next_piece.fetch_add(1);
+			if (index >= pieces.size()) {
+				return;
+			}
+			auto& p = pieces[index];
+			if (!p.task) {
+				continue;
+			}
+
+			std::string text;
+			std::exception_ptr exception;
+			try {
+				text = p.task();
+			} catch (...) {
+				exception = std::current_exception();
+			}
+
+			{
+				std::lock_guard lock(mutex);
+				p.text = std::move(text);
+				p.exception = std::move(exception);
+				p.ready = true;
+			}
+			cv.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(num_threads);
+
+	// make sure the threads are joined even in case of exception
+	utki::scope_exit join_threads_scope_exit([&]() {
+		next_piece = pieces.size();
+		for (auto& t : threads) {
+			t.join();
+		}
+	});
+
+	for (unsigned i = 0; i != num_threads; ++i) {
+		threads.emplace_back(worker);
+	}
+
+	// output the pieces in order as they become ready
+	for (auto& p : pieces) {
+		if (p.task) {
+			std::unique_lock lock(mutex);
+			cv.wait(lock, [&p]() {
+				return p.ready;
+			});
+			if (p.exception) {
+				std::rethrow_exception(p.exception);
+			}
+		}
+
+		if (this->fi) {
+			// write the piece directly to the file to avoid copying it to the buffer
+			this->flush();
+			this->fi->write(utki::make_span(p.text));
+		} else {
+			this->buffer.append(p.text);
+		}
+
+		// free memory as soon as possible
+		p.text = std::string();
+	}
+}
+
+#if CFG_OS != CFG_OS_WINDOWS
+
+namespace {
+bool string_needs_escaping(std::string_view str, bool ensure_ascii)
+{
+	const char* i = str.data();
+	const char* end = std::next(i, ptrdiff_t(str.size()));
+
+	for (; end - i >= ptrdiff_t(sizeof(uint64_t)); i += sizeof(uint64_t)) {
+		uint64_t word = 0;
+		std::memcpy(&word, i, sizeof(word));
+		if (word_needs_escaping(word, ensure_ascii)) {
+			return true;
+		}
+	}
+	for (; i != end; ++i) {
+		if (needs_escaping(*i, ensure_ascii)) {
+			return true;
+		}
+	}
+	return false;
+}
+} // namespace
+
+namespace {
+// Collects the output as a list of iovecs and writes it to the file descriptor with writev().
+class iovec_output
+{
+	// strings shorter than that are copied, because copying is cheaper than an extra iovec
+	constexpr static const size_t min_reference_size = 32;
+
+#	ifdef IOV_MAX
+	constexpr static const size_t max_iovecs = std::min(size_t(IOV_MAX), size_t(utki::kilobyte));
+#	else
+	constexpr static const size_t max_iovecs = size_t(utki::kilobyte);
+#	endif
+
+	constexpr static const size_t max_batch_bytes = size_t(utki::megabyte);
+
+	constexpr static const size_t max_pending_batches = 2;
+
+	struct batch {
+		std::vector<iovec> iovecs;
+
+		// generated bytes, deque does not move its elements, so the pointers to the strings data remain valid
+		std::deque<std::string> generated{std::string()};
+
+		size_t num_bytes = 0;
+	};
+
+	int fd;
+	bool ensure_ascii;
+
+	batch cur;
+
+	bool background_flush;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::deque<batch> pending;
+	bool finished = false;
+	std::exception_ptr exception;
+	std::thread thread;
+
+	static void write_batch(int fd, batch& b)
+	{
+		auto iov = b.iovecs.data();
+		auto iov_end = std::next(iov, ptrdiff_t(b.iovecs.size()));
+
+		while (iov != iov_end) {
+			auto res = ::writev(fd, iov, int(std::distance(iov, iov_end)));
+			if (res < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw std::system_error(errno, std::generic_category(), "jsondom::write_fd(): writev() failed");
+			}
+
+			// skip fully written iovecs and adjust partially written one
+			auto written = size_t(res);
+			for (; iov != iov_end && written >= iov->iov_len; ++iov) {
+				written -= iov->iov_len;
+			}
+			if (written != 0) {
+				ASSERT(iov != iov_end)
+				iov->iov_base = std::next(static_cast<char*>(iov->iov_base), ptrdiff_t(written));
+				iov->iov_len -= written;
+			}
+		}
+	}
+
+	void run()
+	{
+		try {
+			while (true) {
+				batch b;
+				{
+					std::unique_lock lock(this->mutex);
+					this->cv.wait(lock, [this]() {
+						return this->finished || !this->pending.empty();
+					});
+					if (this->pending.empty()) {
+						return;
+					}
+					b = std::move(this->pending.front());
+				}
+
+				write_batch(this->fd, b);
+
+				{
+					std::lock_guard lock(this->mutex);
+					this->pending.pop_front();
+				}
+				this->cv.notify_all();
+			}
+		} catch (...) {
+			{
+				std::lock_guard lock(this->mutex);
+				this->exception = std::current_exception();
+			}
+			this->cv.notify_all();
+		}
+	}
+
+	void end_generated()
+	{
+		auto& str = this->cur.generated.back();
+		if (str.empty()) {
+			return;
+		}
+		this->cur.iovecs.push_back({str.data(), str.size()});
+		this->cur.generated.emplace_back();
+	}
+
+	void flush_if_needed()
+	{
+		if (this->cur.iovecs.size() + 1 >= max_iovecs || this->cur.num_bytes >= max_batch_bytes) {
+			this->flush();
+		}
+	}
+
+public:
+	iovec_output(
+		int fd, //
+		bool ensure_ascii,
+		bool background_flush
+	) :
+		fd(fd),
+		ensure_ascii(ensure_ascii),
+		background_flush(background_flush)
+	{
+		if (this->background_flush) {
+			this->thread = std::thread([this]() {
+				this->run();
+			});
+		}
+	}
+
+	iovec_output(const iovec_output&) = delete;
+	iovec_output& operator=(const iovec_output&) = delete;
+
+	iovec_output(iovec_output&&) = delete;
+	iovec_output& operator=(iovec_output&&) = delete;
+
+	~iovec_output()
+	{
+		if (this->thread.joinable()) {
+			{
+				std::lock_guard lock(this->mutex);
+				this->finished = true;
+			}
+			this->cv.notify_all();
+			this->thread.join();
+		}
+	}
+
+	void write(char c)
+	{
+		this->cur.generated.back().push_back(c);
+		++this->cur.num_bytes;
+	}
+
+	void write(std::string_view str)
+	{
+		this->cur.generated.back().append(str);
+		this->cur.num_bytes += str.size();
+	}
+
+	// Write string which remains valid until the output is finished.
+	void write_reference(std::string_view str)
+	{
+		if (str.size() < min_reference_size) {
+			this->write(str);
+			return;
+		}
+		this->end_generated();
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast, "iovec requires non-const pointer, but writev() does not modify the data")
+		this->cur.iovecs.push_back({const_cast<char*>(str.data()), str.size()});
+		this->cur.num_bytes += str.size();
+		this->flush_if_needed();
+	}
+
+	void write_string(std::string_view str)
+	{
+		this->write('"');
+		if (string_needs_escaping(str, this->ensure_ascii)) {
+			auto& out = this->cur.generated.back();
+			auto size = out.size();
+			write_escaped_string(out, str, this->ensure_ascii);
+			this->cur.num_bytes += out.size() - size;
+		} else {
+			this->write_reference(str);
+		}
+		this->write('"');
+	}
+
+	void flush()
+	{
+		this->end_generated();
+
+		if (this->cur.iovecs.empty()) {
+			return;
+		}
+
+		if (!this->background_flush) {
+			write_batch(this->fd, this->cur);
+			this->cur = batch();
+			return;
+		}
+
+		std::unique_lock lock(this->mutex);
+		this->cv.wait(lock, [this]() {
+			return this->exception || this->pending.size() < max_pending_batches;
+		});
+		if (this->exception) {
+			std::rethrow_exception(this->exception);
+		}
+		this->pending.push_back(std::move(this->cur));
+		lock.unlock();
+		this->cv.notify_all();
+
+		this->cur = batch();
+	}
+
+	void finish()
+	{
+		this->flush();
+
+		if (!this->background_flush) {
+			return;
+		}
+
+		std::unique_lock lock(this->mutex);
+		this->cv.wait(lock, [this]() {
+			return this->exception || this->pending.empty();
+		});
+		if (this->exception) {
+			std::rethrow_exception(this->exception);
+		}
+	}
+
+	void write_value(const jsondom::value& v)
+	{
+		switch (v.get_type()) {
+			default:
+			case type::null:
+				this->write(word_null);
+				break;
+			case type::boolean:
+				this->write(v.boolean() ? word_true : word_false);
+				break;
+			case type::number:
+				this->write_reference(v.number().get_string());
+				break;
+			case type::string:
+				this->write_string(v.string());
+				break;
+			case type::array:
+				this->write('[');
+				for (auto i = v.array().begin(); i != v.array().end(); ++i) {
+					if (i != v.array().begin()) {
+						this->write(',');
+					}
+					this->write_value(*i);
+				}
+				this->write(']');
+				break;
+			case type::object:
+				this->write('{');
+				for (auto i = v.object().begin(); i != v.object().end(); ++i) {
+					if (i != v.object().begin()) {
+						this->write(',');
+					}
+					this->write_string(i->first);
+					this->write(':');
+					this->write_value(i->second);
+				}
+				this->write('}');
+				break;
+		}
+		this->flush_if_needed();
+	}
+};
+} // namespace
+
+void jsondom::write_fd(
+	int fd, //
+	const jsondom::value& v,
+	const write_options& options,
+	bool background_flush
+)
+{
+	if (!v.is<type::object>()) {
+		throw std::logic_error("tried to write JSON with non-object root element");
+	}
+
+	iovec_output out(fd, options.ensure_ascii, background_flush);
+	out.write_value(v);
+	out.finish();
+}
+
+#endif
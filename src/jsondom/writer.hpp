@@ -0,0 +1,264 @@
+/*
+MIT License
+
+Copyright (c) 2020-2024 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fsif/file.hpp>
+#include <utki/config.hpp>
+
+#include "dom.hpp"
+#include "string_number.hpp"
+
+namespace jsondom {
+
+namespace internal {
+struct writer_access;
+} // namespace internal
+
+/**
+ * @brief SAX style JSON writer.
+ * Writes JSON document element by element, without building a DOM for it first.
+ * The output is buffered and written to the file by large chunks.
+ *
+ * Example:
+ * @code
+ * fsif::file::guard file_guard(fi, fsif::mode::create);
+ * jsondom::writer w(fi);
+ * w.begin_object();
+ * w.key("name");
+ * w.value("hello");
+ * w.key("values");
+ * w.begin_array();
+ * w.value(jsondom::string_number(13));
+ * w.value(true);
+ * w.value(nullptr);
+ * w.end_array();
+ * w.end_object(); // root value is complete, the output is flushed to the file
+ * @endcode
+ *
+ * In debug build the writer asserts that the sequence of calls forms a structurally valid JSON document,
+ * e.g. that a key is written before each value inside of an object, that object is ended with end_object(), etc.
+ */
+class writer
+{
+	// gives typed serialization access to the buffer
+	friend struct internal::writer_access;
+
+	fsif::file* fi = nullptr;
+
+	write_options options;
+
+	std::string buffer;
+
+	struct level {
+		bool is_object;
+		bool is_first = true;
+	};
+
+	std::vector<level> stack;
+
+	// whether the key has been written and the value for it is expected
+	bool key_written = false;
+
+	// whether the root value has been written completely
+	bool root_written = false;
+
+	void before_value();
+	void after_value();
+
+	void flush_if_needed();
+
+	void write_escaped_string(std::string_view str);
+	void write_value(const jsondom::value& v);
+	void write_value_parallel(const jsondom::value& v, size_t estimated_size);
+	void write_value_cached(const jsondom::value& v);
+
+public:
+	/**
+	 * @brief Construct writer to file.
+	 * The file must be opened for writing and must remain opened while the writer writes to it.
+	 * The output is flushed to the file when the root value is written completely,
+	 * or by calling flush() explicitly.
+	 * @param fi - file to write the JSON document to.
+	 * @param options - writing options.
+	 */
+	writer(
+		fsif::file& fi, //
+		const write_options& options = {}
+	);
+
+	/**
+	 * @brief Construct writer to memory buffer.
+	 * The whole output is accumulated in the memory buffer,
+	 * use reset_data() to get it.
+	 * @param options - writing options.
+	 */
+	explicit writer(const write_options& options = {}) :
+		options(options)
+	{}
+
+	writer(const writer&) = delete;
+	writer& operator=(const writer&) = delete;
+
+	writer(writer&&) = default;
+	writer& operator=(writer&&) = default;
+
+	~writer() = default;
+
+	/**
+	 * @brief Start JSON object.
+	 */
+	void begin_object();
+
+	/**
+	 * @brief End JSON object.
+	 */
+	void end_object();
+
+	/**
+	 * @brief Start JSON array.
+	 */
+	void begin_array();
+
+	/**
+	 * @brief End JSON array.
+	 */
+	void end_array();
+
+	/**
+	 * @brief Write key of the key-value pair.
+	 * Must be followed by the value.
+	 * @param key - key to write.
+	 */
+	void key(std::string_view key);
+
+	/**
+	 * @brief Write string value.
+	 * @param str - string to write.
+	 */
+	void value(std::string_view str);
+
+	/**
+	 * @brief Write string value.
+	 * @param str - string to write.
+	 */
+	void value(const std::string& str)
+	{
+		this->value(std::string_view(str));
+	}
+
+	/**
+	 * @brief Write string value.
+	 * @param str - string to write.
+	 */
+	void value(const char* str)
+	{
+		this->value(std::string_view(str));
+	}
+
+	/**
+	 * @brief Write number value.
+	 * @param num - number to write.
+	 */
+	void value(const string_number& num);
+
+	/**
+	 * @brief Write boolean value.
+	 * @param b - boolean to write.
+	 */
+	void value(bool b);
+
+	/**
+	 * @brief Write null value.
+	 */
+	void value(std::nullptr_t);
+
+	/**
+	 * @brief Write DOM value.
+	 * Writes the given value along with all its children.
+	 * @param v - value to write.
+	 */
+	void value(const jsondom::value& v);
+
+	/**
+	 * @brief Reserve memory buffer.
+	 * Makes sure the memory buffer can hold the given number of bytes without reallocation.
+	 * Useful when writing to memory and expected output size is known in advance.
+	 * @param size - number of bytes to reserve.
+	 */
+	void reserve(size_t size)
+	{
+		this->buffer.reserve(size);
+	}
+
+	/**
+	 * @brief Write buffered output to the file.
+	 * Does nothing in case the writer writes to memory buffer.
+	 */
+	void flush();
+
+	/**
+	 * @brief Get written data.
+	 * Only makes sense for writer to memory buffer.
+	 * The memory buffer is cleared.
+	 * @return written data.
+	 */
+	std::string reset_data()
+	{
+		auto ret = std::move(this->buffer);
+		this->buffer.clear();
+		return ret;
+	}
+};
+
+#if CFG_OS != CFG_OS_WINDOWS
+
+/**
+ * @brief Write the JSON document to a native file descriptor.
+ * The document is written using scatter-gather writev() calls. Keys, strings which do not need escaping
+ * and number strings are referenced directly from the value tree instead of being copied to intermediate buffer,
+ * only structural characters and escaped strings are generated.
+ * @param fd - file descriptor to write the JSON document to.
+ * @param v - root value of the JSON document to write.
+ * @param options - writing options. The num_threads and cache_subtrees options are ignored.
+ * @param background_flush - if true, the writev() calls are issued from a separate thread,
+ *                           while the calling thread prepares the next portion of output.
+ * @throw std::system_error in case writing to the file descriptor fails.
+ */
+void write_fd(
+	int fd, //
+	const jsondom::value& v,
+	const write_options& options = {},
+	bool background_flush = false
+);
+
+#endif
+
+} // namespace jsondom
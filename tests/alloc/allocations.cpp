@@ -0,0 +1,69 @@
+#include "allocations.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Replacements of global operator new and delete which count the allocations.
+// Over-aligned allocations are not counted, those are not used by the library.
+
+namespace{
+thread_local allocations::stats thread_stats;
+
+void* allocate(std::size_t size)noexcept{
+	++thread_stats.num_allocations;
+	thread_stats.num_bytes += size;
+
+	// malloc(0) is allowed to return nullptr, while operator new must return unique pointer
+	return std::malloc(size == 0 ? 1 : size);
+}
+}
+
+allocations::stats allocations::get_thread_stats()noexcept{
+	return thread_stats;
+}
+
+void* operator new(std::size_t size){
+	if(auto p = allocate(size)){
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size){
+	if(auto p = allocate(size)){
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&)noexcept{
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&)noexcept{
+	return allocate(size);
+}
+
+void operator delete(void* p)noexcept{
+	std::free(p);
+}
+
+void operator delete[](void* p)noexcept{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t)noexcept{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t)noexcept{
+	std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&)noexcept{
+	std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&)noexcept{
+	std::free(p);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+// Counting of memory allocations done via global operator new.
+// The counters are per thread, so that tests running in parallel do not affect each other.
+namespace allocations{
+
+struct stats{
+	size_t num_allocations = 0;
+	size_t num_bytes = 0;
+};
+
+// Get number of allocations and allocated bytes done by the current thread so far.
+stats get_thread_stats()noexcept;
+
+// Counts allocations done by the current thread during the counter's lifetime.
+class counter{
+	stats start = get_thread_stats();
+
+public:
+	stats get()const noexcept{
+		auto s = get_thread_stats();
+		return {s.num_allocations - this->start.num_allocations, s.num_bytes - this->start.num_bytes};
+	}
+};
+
+}
@@ -0,0 +1,319 @@
+#include <cstdint>
+#include <map>
+#include <regex>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <fsif/native_file.hpp>
+#include <fsif/vector_file.hpp>
+
+#include "../../src/jsondom/dom.hpp"
+#include "../../src/jsondom/dom_parser.hpp"
+#include "../../src/jsondom/extractor.hpp"
+#include "../../src/jsondom/reader.hpp"
+
+#include "allocations.hpp"
+
+// The budgets are the numbers measured at the time of writing with some headroom (about 10%).
+// If a change makes the library allocate more, then the test fails. If a change reduces number
+// of allocations, then the budgets should be lowered accordingly, so that the gain is not lost later.
+//
+// The numbers were measured with libstdc++ on a 64-bit platform. Other standard libraries have different
+// small string buffer sizes, container node sizes and so on, so there the budgets are not checked and
+// the measured numbers are only printed. Checks which compare to numbers measured at run time,
+// or which do not depend on the standard library, are done on all platforms.
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace{
+#if defined(__GLIBCXX__) && SIZE_MAX == UINT64_MAX
+constexpr bool budgets_apply = true;
+#else
+constexpr bool budgets_apply = false;
+#endif
+
+const std::string data_dir = "../unit/samples_data/";
+
+struct budget{
+	size_t num_allocations;
+	size_t num_bytes;
+};
+
+// allocations per document, the document data is already in memory
+const std::map<std::string, budget, std::less<>> read_budgets = {
+	{"sample1.json", {8, 240}},
+	{"sample2.json", {13, 400}},
+	{"sample3.json", {19, 820}},
+	{"sample4.json", {30, 1700}},
+	{"sample5.json", {24, 1530}},
+	{"sample6.json", {36, 2200}},
+	{"sample7.json", {20, 600}},
+	{"tradier_prices.json", {7300, 755000}},
+};
+
+// the output buffer, which grows on demand up to the flush threshold, and the data of the output file
+const std::map<std::string, budget, std::less<>> write_budgets = {
+	{"sample1.json", {1, 16}},
+	{"sample2.json", {2, 64}},
+	{"sample3.json", {3, 150}},
+	{"sample4.json", {4, 310}},
+	{"sample5.json", {4, 340}},
+	{"sample6.json", {5, 750}},
+	{"sample7.json", {4, 310}},
+	{"tradier_prices.json", {16, 430000}},
+};
+
+std::vector<std::string> list_samples(){
+	const std::regex suffix_regex("^.*\\.json$");
+	auto all_files = fsif::native_file(data_dir).list_dir();
+
+	std::vector<std::string> files;
+	std::copy_if(
+			all_files.begin(),
+			all_files.end(),
+			std::back_inserter(files),
+			[&suffix_regex](auto& f){
+				return std::regex_match(f, suffix_regex);
+			}
+		);
+	return files;
+}
+
+void print_stats(const allocations::stats& s, std::string_view what){
+	std::cout << "allocations: " << what << ": " << s.num_allocations << " allocations, " << s.num_bytes << " bytes" << std::endl;
+}
+
+// checks limit which holds on any platform
+void check_limit(const allocations::stats& s, const budget& b, std::string_view what){
+	print_stats(s, what);
+	tst::check_le(s.num_allocations, b.num_allocations, SL) << what;
+	tst::check_le(s.num_bytes, b.num_bytes, SL) << what;
+}
+
+// checks budget measured on the platform the budgets were written for
+void check_budget(const allocations::stats& s, const budget& b, std::string_view what){
+	if constexpr (budgets_apply){
+		check_limit(s, b, what);
+	}else{
+		print_stats(s, what);
+	}
+}
+}
+
+namespace{
+// Parser which does nothing, to measure allocations done by the parser itself.
+class null_parser : public jsondom::parser{
+public:
+	void on_object_start()override{}
+	void on_object_end()override{}
+	void on_array_start()override{}
+	void on_array_end()override{}
+	void on_key_parsed(utki::span<const char> str)override{}
+	void on_string_parsed(utki::span<const char> str)override{}
+	void on_number_parsed(utki::span<const char> str)override{}
+	void on_boolean_parsed(bool b)override{}
+	void on_null_parsed()override{}
+};
+
+// number of tokens in the generated documents
+constexpr size_t num_tokens = 1000;
+
+struct token_kind{
+	std::string name;
+
+	// text of the i-th member of the root object
+	std::function<std::string(size_t)> member;
+
+	// allocations per token done by dom_parser
+	budget dom_budget;
+};
+
+const std::vector<token_kind> token_kinds = {
+	{"key", [](size_t i){
+		// the key is long enough to not fit into small string buffer
+		return "\"a_rather_long_key_number_" + std::to_string(i) + "\":null";
+	}, {3, 180}},
+	{"string", [](size_t i){
+		return "\"k" + std::to_string(i) + "\":\"a string value which is not too short\"";
+	}, {2, 157}},
+	{"number", [](size_t i){
+		return "\"k" + std::to_string(i) + "\":" + std::to_string(i * 1000003);
+	}, {1, 115}},
+	{"boolean", [](size_t i){
+		return "\"k" + std::to_string(i) + (i % 2 == 0 ? "\":true"s : "\":false"s);
+	}, {1, 115}},
+	{"null", [](size_t i){
+		return "\"k" + std::to_string(i) + "\":null";
+	}, {1, 115}},
+	{"object", [](size_t i){
+		return "\"k" + std::to_string(i) + "\":{}";
+	}, {2, 203}},
+	{"array", [](size_t i){
+		return "\"k" + std::to_string(i) + "\":[]";
+	}, {2, 177}},
+};
+
+// extractor which drops the matches, to measure allocations done by the extractor itself
+class null_extractor : public jsondom::extractor{
+public:
+	using jsondom::extractor::extractor;
+
+	size_t num_matches = 0;
+
+	void on_match(size_t path_index, jsondom::value v)override{
+		++this->num_matches;
+	}
+};
+
+std::string generate(const token_kind& kind){
+	std::string ret = "{";
+	for(size_t i = 0; i != num_tokens; ++i){
+		if(i != 0){
+			ret.push_back(',');
+		}
+		ret.append(kind.member(i));
+	}
+	ret.push_back('}');
+	return ret;
+}
+}
+
+namespace{
+const tst::set set("allocations", [](tst::suite& suite){
+	suite.add<std::string>(
+		"read",
+		list_samples(),
+		[](const auto& p){
+			auto data = fsif::native_file(data_dir + p).load();
+
+			allocations::counter c;
+			auto json = jsondom::read(utki::make_span(data));
+			auto s = c.get();
+
+			auto i = read_budgets.find(p);
+			tst::check(i != read_budgets.end(), SL) << "no budget for " << p;
+			check_budget(s, i->second, "read " + p);
+		}
+	);
+
+	suite.add<std::string>(
+		"reader",
+		list_samples(),
+		[](const auto& p){
+			auto data = fsif::native_file(data_dir + p).load();
+
+			allocations::counter read_counter;
+			jsondom::read(utki::make_span(data));
+			auto read_stats = read_counter.get();
+
+			// warm up the buffers
+			jsondom::reader r;
+			r.read(utki::make_span(data));
+
+			allocations::counter c;
+			auto json = r.read(utki::make_span(data));
+			auto s = c.get();
+
+			print_stats(s, "reader " + p);
+
+			// the parser and its buffers are not allocated again
+			tst::check_lt(s.num_allocations, read_stats.num_allocations, SL) << p;
+			tst::check_lt(s.num_bytes, read_stats.num_bytes, SL) << p;
+		}
+	);
+
+	suite.add<std::string>(
+		"write",
+		list_samples(),
+		[](const auto& p){
+			auto json = jsondom::read(fsif::native_file(data_dir + p));
+
+			fsif::vector_file fi;
+
+			allocations::counter c;
+			jsondom::write(fi, json);
+			auto s = c.get();
+
+			auto i = write_budgets.find(p);
+			tst::check(i != write_budgets.end(), SL) << "no budget for " << p;
+			check_budget(s, i->second, "write " + p);
+		}
+	);
+
+	suite.add<token_kind>(
+		"parser_callbacks",
+		token_kinds,
+		[](const auto& kind){
+			auto text = generate(kind);
+
+			// the parser itself should not allocate per token, only for growing its buffers
+			{
+				null_parser p;
+
+				allocations::counter c;
+				p.feed(text);
+				auto s = c.get();
+
+				constexpr auto max_parser_allocations = 16;
+				check_limit(s, {max_parser_allocations, text.size()}, "parser " + kind.name);
+			}
+
+			// allocations done when building DOM
+			{
+				jsondom::dom_parser p;
+
+				allocations::counter c;
+				p.feed(text);
+				auto json = p.release_document();
+				auto s = c.get();
+
+				// allow for some allocations not depending on number of tokens
+				constexpr auto max_constant_allocations = 16;
+				constexpr auto max_constant_bytes = 4096;
+				check_budget(
+					s,
+					{
+						kind.dom_budget.num_allocations * num_tokens + max_constant_allocations,
+						kind.dom_budget.num_bytes * num_tokens + max_constant_bytes
+					},
+					"dom_parser " + kind.name
+				);
+			}
+		}
+	);
+
+	suite.add("extractor", [](){
+		std::string text = "{\"values\":[";
+		for(size_t i = 0; i != num_tokens; ++i){
+			if(i != 0){
+				text.push_back(',');
+			}
+			text.append("{\"a\":" + std::to_string(i) + "}");
+		}
+		text.append("]}");
+
+		null_extractor e({"/values/*/a"});
+
+		allocations::counter c;
+		e.feed(text);
+		auto s = c.get();
+
+		tst::check_eq(e.num_matches, num_tokens, SL);
+
+		// the value builders are reused, so only bookkeeping of the matched paths allocates per match
+		constexpr budget per_match = {2, 20};
+		constexpr auto max_constant_allocations = 16;
+		constexpr auto max_constant_bytes = 4096;
+		check_budget(
+			s,
+			{
+				per_match.num_allocations * num_tokens + max_constant_allocations,
+				per_match.num_bytes * num_tokens + max_constant_bytes
+			},
+			"extractor"
+		);
+	});
+});
+}
@@ -0,0 +1,526 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <fsif/native_file.hpp>
+#include <fsif/vector_file.hpp>
+
+#include "../../src/jsondom/cbor.hpp"
+#include "../../src/jsondom/dom.hpp"
+#include "../../src/jsondom/msgpack.hpp"
+#include "../../src/jsondom/parser.hpp"
+#include "../../src/jsondom/reader.hpp"
+#include "../../src/jsondom/writer.hpp"
+
+// Throughput benchmark.
+//
+// Generates deterministic synthetic JSON documents (corpora) and measures speed of
+// parsing, DOM building and serialization on them.
+// Then does the same for the real documents from the samples directory.
+// Throughput of all operations is given in megabytes of JSON text per second,
+// so that the numbers of different operations on the same corpus are comparable.
+// Next to the throughput the size of the operation's data in its own format
+// (JSON text, CBOR or MessagePack) is printed, so that the binary formats can be compared
+// to JSON text both in size and in speed.
+//
+// Usage: bench [--size=<megabytes>] [--time=<seconds>] [--filter=<substring>] [--samples=<dir>] [--format=text|json]
+//   --size    - approximate size of each generated document, default is 8.
+//   --time    - minimal time to run each operation for, default is 1.
+//   --filter  - only run benchmarks which "<corpus>/<operation>" name contains the substring.
+//   --samples - directory with *.json sample documents, default is ../unit/samples_data/,
+//               empty value disables the samples run.
+//   --format  - output format, json is for tracking regressions by scripts, default is text.
+
+using namespace std::string_view_literals;
+
+namespace{
+struct options{
+	double size_mb = 8;
+	double min_seconds = 1;
+	std::string filter;
+	std::string samples_dir = "../unit/samples_data/";
+	bool json_output = false;
+};
+
+options parse_command_line(int argc, char** argv){
+	options ret;
+	for(int i = 1; i < argc; ++i){
+		std::string_view arg(argv[i]);
+		auto value_of = [&arg](std::string_view name) -> std::optional<std::string> {
+			if(arg.substr(0, name.size()) != name){
+				return {};
+			}
+			return std::string(arg.substr(name.size()));
+		};
+
+		if(auto v = value_of("--size="sv)){
+			ret.size_mb = std::stod(*v);
+		}else if(auto v = value_of("--time="sv)){
+			ret.min_seconds = std::stod(*v);
+		}else if(auto v = value_of("--filter="sv)){
+			ret.filter = *v;
+		}else if(auto v = value_of("--samples="sv)){
+			ret.samples_dir = *v;
+			if(!ret.samples_dir.empty() && ret.samples_dir.back() != '/'){
+				ret.samples_dir.push_back('/');
+			}
+		}else if(auto v = value_of("--format="sv)){
+			if(*v != "text"sv && *v != "json"sv){
+				throw std::invalid_argument("unknown output format: " + *v);
+			}
+			ret.json_output = *v == "json"sv;
+		}else{
+			throw std::invalid_argument("unknown command line argument: " + std::string(arg));
+		}
+	}
+	return ret;
+}
+}
+
+namespace{
+// Generates the corpora.
+// Uses fixed seed and does not use standard distributions, since those are implementation defined,
+// so that the documents are the same on all platforms.
+class generator{
+	std::mt19937_64 rng{13}; // NOLINT
+
+public:
+	uint64_t next(uint64_t max){
+		return this->rng() % max;
+	}
+
+	std::string word(){
+		constexpr auto letters = "abcdefghijklmnopqrstuvwxyz"sv;
+		std::string ret;
+		for(auto n = 2 + this->next(10); n != 0; --n){
+			ret.push_back(letters[this->next(letters.size())]);
+		}
+		return ret;
+	}
+
+	jsondom::string_number decimal(uint64_t max, unsigned num_fraction_digits){
+		std::string ret = std::to_string(this->next(max));
+		ret.push_back('.');
+		for(unsigned i = 0; i != num_fraction_digits; ++i){
+			ret.push_back(char('0' + this->next(10)));
+		}
+		return jsondom::string_number(std::move(ret));
+	}
+};
+
+struct corpus{
+	std::string name;
+	std::string text;
+};
+
+// Generate document of about the given size by writing the same kind of element until the size is reached.
+corpus generate(std::string name, std::string_view array_key, size_t size, const std::function<void(jsondom::writer& w)>& write_element){
+	std::string text;
+	text.reserve(size + size_t(utki::kilobyte));
+	text.append(R"({")"sv).append(array_key).append(R"(":[)"sv);
+
+	for(bool first = true; text.size() < size; first = false){
+		if(!first){
+			text.push_back(',');
+		}
+		jsondom::writer w;
+		write_element(w);
+		text.append(w.reset_data());
+	}
+
+	text.append("]}"sv);
+	return {std::move(name), std::move(text)};
+}
+
+std::vector<corpus> generate_corpora(size_t size){
+	std::vector<corpus> ret;
+
+	generator g;
+
+	ret.push_back(generate("numbers", "values"sv, size, [&g](jsondom::writer& w){
+		w.begin_array();
+		for(unsigned i = 0; i != 16; ++i){ // NOLINT
+			switch(g.next(4)){
+				case 0:
+					w.value(jsondom::string_number(g.next(1000)));
+					break;
+				case 1:
+					w.value(jsondom::string_number(int64_t(g.next(uint64_t(1) << 40)) - (int64_t(1) << 39)));
+					break;
+				case 2:
+					w.value(g.decimal(10000, 6)); // NOLINT
+					break;
+				default:
+					w.value(jsondom::string_number(std::to_string(g.next(10)) + "." + std::to_string(g.next(1000)) + "e-" + std::to_string(g.next(300))));
+					break;
+			}
+		}
+		w.end_array();
+	}));
+
+	ret.push_back(generate("strings", "strings"sv, size, [&g](jsondom::writer& w){
+		std::string str;
+		for(auto n = 1 + g.next(8); n != 0; --n){
+			str.append(g.word());
+			switch(g.next(16)){ // NOLINT
+				case 0:
+					str.append("\n"sv);
+					break;
+				case 1:
+					str.append("\"quoted\""sv);
+					break;
+				case 2:
+					str.append("d\xC3\xA9j\xC3\xA0 vu"sv);
+					break;
+				default:
+					str.push_back(' ');
+					break;
+			}
+		}
+		w.value(str);
+	}));
+
+	ret.push_back(generate("nested", "nested"sv, size, [&g](jsondom::writer& w){
+		auto depth = 8 + g.next(56); // NOLINT
+		for(unsigned i = 0; i != depth; ++i){
+			if(i % 2 == 0){
+				w.begin_object();
+				w.key(g.word());
+			}else{
+				w.begin_array();
+			}
+		}
+		w.value(jsondom::string_number(g.next(1000)));
+		for(auto i = depth; i != 0; --i){
+			if((i - 1) % 2 == 0){
+				w.end_object();
+			}else{
+				w.end_array();
+			}
+		}
+	}));
+
+	ret.push_back(generate("small_objects", "items"sv, size, [&g](jsondom::writer& w){
+		w.begin_object();
+		w.key("id"sv);
+		w.value(jsondom::string_number(g.next(1000000)));
+		w.key("ok"sv);
+		w.value(g.next(2) == 0);
+		w.key("tag"sv);
+		w.value(g.word());
+		if(g.next(4) == 0){
+			w.key("parent"sv);
+			w.value(nullptr);
+		}
+		w.end_object();
+	}));
+
+	// like tests/unit/samples_data/tradier_prices.json
+	{
+		uint64_t timestamp = 1594831980; // NOLINT
+		auto c = generate("records", "data"sv, size, [&g, &timestamp](jsondom::writer& w){
+			constexpr auto seconds_per_minute = 60;
+			timestamp += seconds_per_minute;
+
+			w.begin_object();
+			w.key("time"sv);
+			w.value("2020-07-15T" + std::to_string(10 + g.next(10)) + ":" + std::to_string(10 + g.next(50)) + ":00"); // NOLINT
+			w.key("timestamp"sv);
+			w.value(jsondom::string_number(timestamp));
+			for(auto key : {"price"sv, "open"sv, "high"sv, "low"sv, "close"sv}){
+				w.key(key);
+				w.value(g.decimal(100, 2 + unsigned(g.next(3)))); // NOLINT
+			}
+			w.key("volume"sv);
+			w.value(jsondom::string_number(g.next(100000)));
+			w.key("vwap"sv);
+			w.value(g.decimal(100, 6)); // NOLINT
+			w.end_object();
+		});
+
+		// wrap into "series" object
+		c.text = R"({"series":)" + c.text + "}";
+		ret.push_back(std::move(c));
+	}
+
+	return ret;
+}
+
+// Loads the *.json documents from the samples directory, sorted by file name.
+std::vector<corpus> load_samples(const std::string& dir){
+	std::vector<corpus> ret;
+	if(dir.empty()){
+		return ret;
+	}
+
+	auto files = fsif::native_file(dir).list_dir();
+	std::sort(files.begin(), files.end());
+
+	constexpr auto suffix = ".json"sv;
+	for(const auto& f : files){
+		if(f.size() <= suffix.size() || std::string_view(f).substr(f.size() - suffix.size()) != suffix){
+			continue;
+		}
+		auto data = fsif::native_file(dir + f).load();
+		ret.push_back({f, std::string(data.begin(), data.end())});
+	}
+
+	if(ret.empty()){
+		std::cerr << "warning: no *.json samples found in " << dir << std::endl;
+	}
+	return ret;
+}
+}
+
+namespace{
+// Parser which only counts the parsing events, to measure the raw parsing speed.
+class counting_parser : public jsondom::parser{
+public:
+	size_t num_events = 0;
+
+	void on_object_start()override{
+		++this->num_events;
+	}
+	void on_object_end()override{
+		++this->num_events;
+	}
+	void on_array_start()override{
+		++this->num_events;
+	}
+	void on_array_end()override{
+		++this->num_events;
+	}
+	void on_key_parsed(utki::span<const char> str)override{
+		this->num_events += str.size();
+	}
+	void on_string_parsed(utki::span<const char> str)override{
+		this->num_events += str.size();
+	}
+	void on_number_parsed(utki::span<const char> str)override{
+		this->num_events += str.size();
+	}
+	void on_boolean_parsed(bool b)override{
+		this->num_events += b ? 1 : 0;
+	}
+	void on_null_parsed()override{
+		++this->num_events;
+	}
+};
+}
+
+namespace{
+struct result{
+	std::string corpus;
+	std::string operation;
+	size_t bytes;
+
+	// size of the data the operation reads or writes in its own format, i.e. JSON text, CBOR or MessagePack
+	size_t format_bytes;
+
+	size_t iterations;
+	double seconds;
+
+	double mb_per_second()const{
+		return double(this->bytes) * double(this->iterations) / this->seconds / double(utki::megabyte);
+	}
+
+	double documents_per_second()const{
+		return double(this->iterations) / this->seconds;
+	}
+};
+
+// Run the operation repeatedly for at least the given time.
+// The operation returns some number depending on the result, so that the compiler cannot optimize the work out.
+result measure(
+	const corpus& c,
+	std::string operation,
+	size_t format_bytes,
+	double min_seconds,
+	const std::function<size_t()>& op
+)
+{
+	constexpr size_t min_iterations = 3;
+
+	using clock = std::chrono::steady_clock;
+
+	// warm up caches and memory allocator
+	size_t checksum = op();
+
+	size_t iterations = 0;
+	auto start = clock::now();
+	std::chrono::duration<double> elapsed{};
+	do{
+		checksum += op();
+		++iterations;
+		elapsed = clock::now() - start;
+	}while(iterations < min_iterations || elapsed.count() < min_seconds);
+
+	// make sure the checksum is used,
+	// it can legitimately be 0, e.g. for an empty sample document, so it is not checked
+	volatile size_t sink = checksum;
+	std::ignore = sink;
+
+	return {c.name, std::move(operation), c.text.size(), format_bytes, iterations, elapsed.count()};
+}
+
+std::vector<result> run(const corpus& c, const options& opts){
+	std::vector<result> ret;
+
+	auto data = utki::make_span(c.text.data(), c.text.size());
+	jsondom::padded_buffer padded(data);
+
+	auto dom = jsondom::read(data);
+	auto cbor = jsondom::to_cbor(dom);
+	auto msgpack = jsondom::to_msgpack(dom);
+
+	jsondom::reader reader;
+
+	const auto text_size = c.text.size();
+
+	struct operation{
+		std::string_view name;
+		size_t format_bytes;
+		std::function<size_t()> op;
+	};
+
+	std::vector<operation> operations = {
+		{"parser_feed"sv, text_size, [&](){
+			counting_parser p;
+			p.feed(data);
+			return p.num_events;
+		}},
+		{"parser_feed_padded"sv, text_size, [&](){
+			counting_parser p;
+			p.feed(padded);
+			return p.num_events;
+		}},
+		{"read"sv, text_size, [&](){
+			return jsondom::read(data).object().size();
+		}},
+		{"read_padded"sv, text_size, [&](){
+			return jsondom::read(padded).object().size();
+		}},
+		{"reader"sv, text_size, [&](){
+			return reader.read(data).object().size();
+		}},
+		{"write"sv, text_size, [&](){
+			fsif::vector_file fi;
+			jsondom::write(fi, dom);
+			return fi.reset_data().size();
+		}},
+		{"to_string"sv, text_size, [&](){
+			return dom.to_string().size();
+		}},
+		{"round_trip"sv, text_size, [&](){
+			return jsondom::read(data).to_string().size();
+		}},
+		{"cbor_encode"sv, cbor.size(), [&](){
+			return jsondom::to_cbor(dom).size();
+		}},
+		{"cbor_decode"sv, cbor.size(), [&](){
+			return jsondom::read_cbor(utki::make_span(cbor)).object().size();
+		}},
+		{"msgpack_encode"sv, msgpack.size(), [&](){
+			return jsondom::to_msgpack(dom).size();
+		}},
+		{"msgpack_decode"sv, msgpack.size(), [&](){
+			return jsondom::read_msgpack(utki::make_span(msgpack)).object().size();
+		}},
+	};
+
+	for(const auto& [name, format_bytes, op] : operations){
+		if(c.name.find(opts.filter) == std::string::npos &&
+			(c.name + "/" + std::string(name)).find(opts.filter) == std::string::npos)
+		{
+			continue;
+		}
+		ret.push_back(measure(c, std::string(name), format_bytes, opts.min_seconds, op));
+
+		if(!opts.json_output){
+			const auto& r = ret.back();
+			std::printf(
+				"%-20s %-20s %10.1f MB/s %12.1f docs/s %10zu bytes\n",
+				r.corpus.c_str(),
+				r.operation.c_str(),
+				r.mb_per_second(),
+				r.documents_per_second(),
+				r.format_bytes
+			);
+			std::fflush(stdout);
+		}
+	}
+
+	return ret;
+}
+}
+
+int main(int argc, char** argv){
+	try{
+		auto opts = parse_command_line(argc, argv);
+
+#ifdef DEBUG
+		std::cerr << "warning: benchmark is built in debug configuration, the results are not representative" << std::endl;
+#endif
+
+		auto corpora = generate_corpora(size_t(opts.size_mb * double(utki::megabyte)));
+		{
+			auto samples = load_samples(opts.samples_dir);
+			corpora.insert(
+				corpora.end(),
+				std::make_move_iterator(samples.begin()),
+				std::make_move_iterator(samples.end())
+			);
+		}
+
+		std::vector<result> results;
+		for(const auto& c : corpora){
+			auto r = run(c, opts);
+			results.insert(results.end(), r.begin(), r.end());
+		}
+
+		if(opts.json_output){
+			jsondom::writer w;
+			w.begin_object();
+			w.key("results"sv);
+			w.begin_array();
+			for(const auto& r : results){
+				w.begin_object();
+				w.key("corpus"sv);
+				w.value(r.corpus);
+				w.key("operation"sv);
+				w.value(r.operation);
+				w.key("bytes"sv);
+				w.value(jsondom::string_number(r.bytes));
+				w.key("format_bytes"sv);
+				w.value(jsondom::string_number(r.format_bytes));
+				w.key("iterations"sv);
+				w.value(jsondom::string_number(r.iterations));
+				w.key("seconds"sv);
+				w.value(jsondom::string_number(r.seconds));
+				w.key("mb_per_s"sv);
+				w.value(jsondom::string_number(r.mb_per_second()));
+				w.key("docs_per_s"sv);
+				w.value(jsondom::string_number(r.documents_per_second()));
+				w.end_object();
+			}
+			w.end_array();
+			w.end_object();
+			std::cout << w.reset_data() << std::endl;
+		}
+	}catch(std::exception& e){
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
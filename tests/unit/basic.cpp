@@ -1,9 +1,16 @@
 #include <tst/set.hpp>
 #include <tst/check.hpp>
 
+#include <thread>
+
+#include <fsif/vector_file.hpp>
+
 #include "../../src/jsondom/dom.hpp"
+#include "../../src/jsondom/dom_parser.hpp"
+#include "../../src/jsondom/reader.hpp"
 
 #include <utki/debug.hpp>
+#include <utki/string.hpp>
 
 using namespace std::string_literals;
 
@@ -41,6 +48,126 @@ const tst::set set("basic", [](tst::suite& suite){
 		}
 	);
 
+	suite.add("read_padded_buffer_long_strings", [](){
+		// strings are longer than machine word to exercise word-wise scanning
+		jsondom::padded_buffer buf(utki::make_span(std::string_view(R"qwertyuiop(
+				{
+					"a_long_key_name": "a long string value with \"escapes\" inside",
+					"numbers" : [1234567890123456789, -0.25e+10, true, null]
+				}
+			)qwertyuiop")));
+
+		auto json = jsondom::read(buf);
+
+		tst::check_eq(
+			json.to_string(),
+			R"({"a_long_key_name":"a long string value with \"escapes\" inside","numbers":[1234567890123456789,-0.25e+10,true,null]})"s,
+			SL
+		);
+	});
+
+	suite.add("write_large_document_flushes_in_order", [](){
+		// document larger than the write buffer to make the writer flush several times
+		jsondom::value json(jsondom::type::object);
+		auto& arr = json.object()["array"] = jsondom::value(jsondom::type::array);
+		for (unsigned i = 0; i != 20000; ++i) {
+			arr.array().emplace_back(std::to_string(i) + "\t\"escaped\"");
+		}
+
+		fsif::vector_file file;
+		jsondom::write(file, json);
+		auto str = utki::make_string(file.reset_data());
+
+		tst::check_eq(str, json.to_string(), SL);
+		tst::check_eq(jsondom::read(str).to_string(), str, SL);
+	});
+
+	suite.add("write_escapes_control_characters", [](){
+		jsondom::value json(jsondom::type::object);
+		json.object()["key"] = jsondom::value("long enough prefix \x01\x1f\n\"/\\ and suffix"s);
+
+		tst::check_eq(
+			json.to_string(),
+			R"({"key":"long enough prefix \u0001\u001f\n\"\/\\ and suffix"})"s,
+			SL
+		);
+	});
+
+	suite.add("write_ensure_ascii", [](){
+		jsondom::value json(jsondom::type::object);
+		// U+00E9, U+20AC, U+1F600 and an invalid byte
+		json.object()["caf\xc3\xa9"] = jsondom::value("\xe2\x82\xac \xf0\x9f\x98\x80 \xff"s);
+
+		jsondom::write_options options;
+		options.ensure_ascii = true;
+
+		tst::check_eq(
+			json.to_string(options),
+			R"({"caf\u00e9":"\u20ac \ud83d\ude00 \ufffd"})"s,
+			SL
+		);
+
+		// the surrogate pair is read back as one character, the invalid byte was replaced on writing
+		tst::check_eq(
+			jsondom::read(json.to_string(options)).to_string(),
+			"{\"caf\xc3\xa9\":\"\xe2\x82\xac \xf0\x9f\x98\x80 \xef\xbf\xbd\"}"s,
+			SL
+		);
+
+		tst::check_eq(
+			json.to_string(),
+			"{\"caf\xc3\xa9\":\"\xe2\x82\xac \xf0\x9f\x98\x80 \xff\"}"s,
+			SL
+		);
+	});
+
+	suite.add<std::pair<std::string, std::string>>(
+		"read_surrogate_pairs",
+		{
+			{R"(\ud83d\ude00)", "\xf0\x9f\x98\x80"},
+			{R"(a\uD800\uDC00b)", "a\xf0\x90\x80\x80" "b"},
+			{R"(\udbff\udfff)", "\xf4\x8f\xbf\xbf"},
+
+			// lone surrogates are malformed
+			{R"(\ud83d)", ""},
+			{R"(\ud83d )", ""},
+			{R"(\ud83d\n)", ""},
+			{R"(\ud83d\u0041)", ""},
+			{R"(\ud83d\ud83d)", ""},
+			{R"(\ude00)", ""},
+			{R"(\ude00\ud83d)", ""},
+		},
+		[](const auto& p){
+			// the escaped string as a value and as a key
+			for(const auto& text : {R"({"k":")" + p.first + R"("})", R"({")" + p.first + R"(":null})"}){
+				// feed whole text at once and also by single bytes, so that the pair is split across the feed() calls
+				for(size_t chunk_size : {text.size(), size_t(1)}){
+					jsondom::dom_parser parser;
+
+					bool thrown = false;
+					try{
+						for(size_t i = 0; i < text.size(); i += chunk_size){
+							parser.feed(utki::make_span(text).subspan(i, chunk_size));
+						}
+					}catch(jsondom::malformed_json_error&){
+						thrown = true;
+					}
+					tst::check_eq(thrown, p.second.empty(), SL) << "text = " << text << ", chunk_size = " << chunk_size;
+
+					if(thrown){
+						continue;
+					}
+
+					auto json = parser.release_document();
+					auto& o = json.object();
+					tst::check_eq(o.size(), size_t(1), SL);
+					const auto& [key, value] = *o.begin();
+					tst::check_eq(value.is_string() ? value.string() : key, p.second, SL) << "text = " << text;
+				}
+			}
+		}
+	);
+
 	suite.add("value_to_string", [](){
 		auto json = jsondom::read(R"qwertyuiop(
 				{
@@ -57,5 +184,385 @@ const tst::set set("basic", [](tst::suite& suite){
 			SL
 		);
 	});
+
+	suite.add("moved_from_value", [](){
+		auto obj = jsondom::read(R"({"a": [1, 2], "b": {"c": true}})"s);
+		auto arr = obj.object()["a"];
+
+		auto moved_obj = std::move(obj);
+		tst::check(obj.is_null(), SL);
+		tst::check_eq(moved_obj.object().size(), size_t(2), SL);
+
+		jsondom::value moved_arr;
+		moved_arr = std::move(arr);
+		tst::check(arr.is_null(), SL);
+		tst::check_eq(moved_arr.array().size(), size_t(2), SL);
+
+		// moved-from values are usable
+		obj = jsondom::value(jsondom::type::object);
+		obj.object()["x"] = std::move(moved_arr);
+		tst::check(moved_arr.is_null(), SL);
+		tst::check_eq(obj.to_string(), R"({"x":[1,2]})"s, SL);
+		tst::check_eq(arr.memory_usage().total(), size_t(0), SL);
+
+		// self move assignment keeps the value
+		auto& self = moved_obj;
+		moved_obj = std::move(self);
+		tst::check_eq(moved_obj.object().size(), size_t(2), SL);
+	});
+
+	suite.add("copy_on_write", [](){
+		auto base = jsondom::read(R"qwertyuiop(
+				{
+					"shared": {"a": [1, 2, 3]},
+					"tenant": {"name": "base"}
+				}
+			)qwertyuiop");
+
+		auto copy = base;
+
+		// copy shares the containers until modified
+		tst::check(&copy.object() != &base.object(), SL);
+		tst::check(&std::as_const(copy).object().at("shared").object() == &std::as_const(base).object().at("shared").object(), SL);
+
+		copy.object()["tenant"].object()["name"] = jsondom::value("tenant1"s);
+
+		tst::check_eq(base.object()["tenant"].object()["name"].string(), "base"s, SL);
+		tst::check_eq(copy.object()["tenant"].object()["name"].string(), "tenant1"s, SL);
+
+		// unmodified subtree is still shared
+		tst::check(&std::as_const(copy).object().at("shared").object() == &std::as_const(base).object().at("shared").object(), SL);
+
+		copy.object()["shared"].object()["a"].array().emplace_back(jsondom::string_number(4));
+		tst::check_eq(base.object()["shared"].object()["a"].array().size(), size_t(3), SL);
+		tst::check_eq(copy.object()["shared"].object()["a"].array().size(), size_t(4), SL);
+	});
+
+	suite.add("copy_on_write_threads", [](){
+		auto base = jsondom::read(R"({"config": {"values": [1, 2, 3]}, "name": "base"})");
+
+		constexpr auto num_threads = 8;
+		std::vector<std::string> results(num_threads);
+		std::vector<std::thread> threads;
+		for(size_t i = 0; i != num_threads; ++i){
+			threads.emplace_back([base, i, &result = results[i]]() mutable {
+				auto copy = base;
+				copy.object()["name"] = jsondom::value(std::to_string(i));
+				copy.object()["config"].object()["values"].array().front() = jsondom::value(jsondom::string_number(i));
+				result = copy.to_string();
+			});
+		}
+		for(auto& t : threads){
+			t.join();
+		}
+
+		for(size_t i = 0; i != num_threads; ++i){
+			tst::check_eq(
+				results[i],
+				utki::cat(R"({"config":{"values":[)", i, R"(,2,3]},"name":")", i, R"("})"),
+				SL
+			);
+		}
+		tst::check_eq(base.to_string(), R"({"config":{"values":[1,2,3]},"name":"base"})"s, SL);
+	});
+	suite.add("parser_stats", [](){
+		const auto text = R"qwertyuiop({"a": [1, 2.5, true, false, null], "b": {"c": {"d": "e\u0041"}}, "long_key": "str", "e": []})qwertyuiop"s;
+
+		jsondom::dom_parser p;
+		tst::check(!p.get_stats(), SL);
+
+		p.enable_stats();
+
+		// feed by parts
+		p.feed(utki::make_span(text.data(), 10));
+		p.feed(utki::make_span(text.data() + 10, text.size() - 10));
+
+		auto json = p.release_document();
+		tst::check(json.is_object(), SL);
+
+		auto stats = p.get_stats();
+		tst::check(stats, SL);
+		tst::check_eq(stats->num_bytes, text.size(), SL);
+		tst::check_eq(stats->num_objects, size_t(3), SL);
+		tst::check_eq(stats->num_arrays, size_t(2), SL);
+		tst::check_eq(stats->num_keys, size_t(6), SL);
+		tst::check_eq(stats->num_strings, size_t(2), SL);
+		tst::check_eq(stats->num_numbers, size_t(2), SL);
+		tst::check_eq(stats->num_booleans, size_t(2), SL);
+		tst::check_eq(stats->num_nulls, size_t(1), SL);
+		tst::check_eq(stats->max_depth, size_t(3), SL);
+		tst::check_eq(stats->max_string_length, "long_key"s.size(), SL);
+
+		// keys, strings and scalars
+		size_t expected_copied = "abcdlong_keye"s.size() + "eA"s.size() + "str"s.size() + "12.5truefalsenull"s.size();
+		tst::check_eq(stats->num_bytes_copied, expected_copied, SL);
+
+		// time is not measured
+		tst::check_eq(stats->parsing_time.count(), decltype(stats->parsing_time)::rep(0), SL);
+		tst::check_eq(stats->callbacks_time.count(), decltype(stats->callbacks_time)::rep(0), SL);
+	});
+
+	suite.add("parser_stats_time", [](){
+		class slow_parser : public jsondom::dom_parser{
+		public:
+			void on_null_parsed()override{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				this->jsondom::dom_parser::on_null_parsed();
+			}
+		};
+
+		slow_parser p;
+		p.enable_stats(true);
+		p.feed(R"({"a": null, "b": null})"s);
+
+		tst::check(p.get_stats()->callbacks_time >= std::chrono::milliseconds(2), SL);
+		tst::check(p.get_stats()->parsing_time < p.get_stats()->callbacks_time, SL);
+	});
+
+	suite.add("read_stats", [](){
+		const auto text = R"({"a": [{}, {"b": [[]]}]})"s;
+
+		fsif::vector_file fi(std::vector<uint8_t>(text.begin(), text.end()));
+
+		jsondom::parser_stats stats;
+		jsondom::read_options options;
+		options.stats = &stats;
+		options.chunk_size = 3;
+
+		auto json = jsondom::read(fi, options);
+		tst::check(json.is_object(), SL);
+
+		tst::check_eq(stats.num_bytes, text.size(), SL);
+		tst::check_eq(stats.num_objects, size_t(3), SL);
+		tst::check_eq(stats.num_arrays, size_t(3), SL);
+		tst::check_eq(stats.max_depth, size_t(5), SL);
+	});
+
+	suite.add("read_stats_from_memory", [](){
+		const auto text = R"({"a": [{}, {"b": [[]]}]})"s;
+
+		jsondom::parser_limits limits;
+		limits.max_depth = 5;
+
+		jsondom::parser_stats stats;
+		jsondom::read_options options;
+		options.stats = &stats;
+		options.limits = &limits;
+
+		auto check_stats = [&](){
+			tst::check_eq(stats.num_bytes, text.size(), SL);
+			tst::check_eq(stats.num_objects, size_t(3), SL);
+			tst::check_eq(stats.num_arrays, size_t(3), SL);
+			tst::check_eq(stats.max_depth, size_t(5), SL);
+		};
+
+		jsondom::read(utki::make_span(text), options);
+		check_stats();
+
+		stats = {};
+		jsondom::read(jsondom::padded_buffer(utki::make_span(text)), options);
+		check_stats();
+
+		// stats are of the last read document only
+		jsondom::reader r(options);
+		for(unsigned i = 0; i != 2; ++i){
+			stats = {};
+			r.read(text);
+			check_stats();
+
+			stats = {};
+			r.read(jsondom::padded_buffer(utki::make_span(text)));
+			check_stats();
+		}
+
+		// limits are applied as well
+		limits.max_depth = 4;
+		bool thrown = false;
+		try{
+			jsondom::read(utki::make_span(text), options);
+		}catch(jsondom::limit_exceeded_error&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+	});
+
+	suite.add<std::pair<std::string, bool>>(
+		"parser_limits",
+		{
+			// the limits are set so that the first text of each pair is just within them
+			{R"({"a": [{}, [1]]})", false},
+			{R"({"a": [{}, [[1]]]})", true}, // depth
+			{R"({"abcd": "efgh"})", false},
+			{R"({"abcde": "efgh"})", true}, // key length
+			{R"({"abcd": "efghi"})", true}, // string length
+			{R"({"abcd": "\n\n\n\n"})", false},
+			{R"({"abcd": "\n\n\n\n\n"})", true}, // string length after unescaping
+			{R"({"abcd": "\u0444\u0444"})", false},
+			{R"({"abcd": "\u0444\u0444\u0444"})", true}, // string length after unescaping
+			{R"({"a": 12345, "b": false})", false},
+			{R"({"a": 123456})", true}, // number length
+			{R"({"a": [1, 2, 3, 4]})", false},
+			{R"({"a": [1, 2, 3, 4, 5]})", true}, // number of values
+			{R"({"a": [null, true, {}, 1]})", false},
+			{R"({"a": [null, true, {}, 1, ""]})", true}, // number of values
+			{R"({"a": [null, true, {}, 1, false]})", true}, // number of values
+			{R"({"a": [null, true, {}, 1, []]})", true}, // number of values
+			{R"({"a":                                []})", false},
+			{R"({"a":                                 []})", true}, // document size
+		},
+		[](const auto& p){
+			jsondom::parser_limits limits;
+			limits.max_depth = 3;
+			limits.max_string_length = 4;
+			limits.max_number_length = 5;
+			limits.max_document_size = 40;
+			limits.max_num_values = 6;
+
+			// feed whole text at once and also by single bytes, so that the limits are checked across the feed() calls
+			for(size_t chunk_size : {p.first.size(), size_t(1)}){
+				jsondom::dom_parser parser;
+				parser.set_limits(limits);
+
+				bool thrown = false;
+				try{
+					for(size_t i = 0; i < p.first.size(); i += chunk_size){
+						parser.feed(utki::make_span(p.first).subspan(i, chunk_size));
+					}
+				}catch(jsondom::limit_exceeded_error&){
+					thrown = true;
+				}
+				tst::check_eq(thrown, p.second, SL) << "text = " << p.first << ", chunk_size = " << chunk_size;
+
+				if(!thrown){
+					tst::check(parser.release_document().is_object(), SL);
+				}
+			}
+		}
+	);
+
+	suite.add("read_limits", [](){
+		const auto text = R"({"a": [{}, {"b": [[]]}]})"s;
+
+		fsif::vector_file fi(std::vector<uint8_t>(text.begin(), text.end()));
+
+		jsondom::parser_limits limits;
+		limits.max_depth = 4;
+
+		jsondom::read_options options;
+		options.limits = &limits;
+		options.chunk_size = 3;
+
+		bool thrown = false;
+		try{
+			jsondom::read(fi, options);
+		}catch(jsondom::limit_exceeded_error&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		limits.max_depth = 5;
+		auto json = jsondom::read(fi, options);
+		tst::check(json.is_object(), SL);
+	});
+
+	suite.add("parser_reset", [](){
+		jsondom::dom_parser p;
+
+		bool thrown = false;
+		try{
+			p.feed(R"({"a": [1, 2}, "b": true})"s);
+		}catch(jsondom::malformed_json_error&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		// incomplete document
+		p.reset();
+		p.feed(R"({"a": [1, 2)"s);
+
+		p.reset();
+		p.feed(R"({"a": [1, 2], "b": true})"s);
+		auto json = p.release_document();
+		tst::check_eq(json.to_string(), R"({"a":[1,2],"b":true})"s, SL);
+	});
+
+	suite.add("reader", [](){
+		jsondom::parser_limits limits;
+		limits.max_document_size = 30;
+
+		jsondom::reader r(limits);
+
+		// the limits apply to each document separately
+		for(unsigned i = 0; i != 3; ++i){
+			auto json = r.read(R"({"a": [1, 2], "b": true})"s);
+			tst::check_eq(json.to_string(), R"({"a":[1,2],"b":true})"s, SL);
+		}
+
+		bool thrown = false;
+		try{
+			r.read(R"({"a": [1, 2}, "b": true})"s);
+		}catch(jsondom::malformed_json_error&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		auto json = r.read(jsondom::padded_buffer(utki::make_span(R"({"c": null})"s)));
+		tst::check_eq(json.to_string(), R"({"c":null})"s, SL);
+
+		thrown = false;
+		try{
+			r.read(R"({"a": [1, 2], "b": true, "c": false})"s);
+		}catch(jsondom::limit_exceeded_error&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		json = r.read(R"({"d": "e"})"s);
+		tst::check_eq(json.to_string(), R"({"d":"e"})"s, SL);
+	});
+
+	suite.add("memory_usage", [](){
+		const auto long_text = std::string(100, 'a');
+		const auto long_number = std::string(50, '1');
+
+		auto json = jsondom::read(utki::make_span(
+			R"({"a": "b", "c": 1, "d": [true, null, {}], ")" + long_text + R"(": ")" + long_text + R"(", "n": )" + long_number + "}"
+		));
+
+		auto usage = json.memory_usage();
+
+		tst::check_le(long_text.size() + 1, usage.strings, SL);
+		tst::check_le(usage.strings, 2 * (long_text.size() + 1), SL);
+		tst::check_le(long_text.size() + 1, usage.keys, SL);
+		tst::check_le(usage.keys, 2 * (long_text.size() + 1), SL);
+		tst::check_le(long_number.size() + 1, usage.numbers, SL);
+		tst::check_le(usage.numbers, 2 * (long_number.size() + 1), SL);
+
+		// 3 objects, 1 array, 5 + 0 object members and 3 array elements at least
+		size_t min_containers = 5 * (sizeof(std::string) + sizeof(jsondom::value)) + 3 * sizeof(jsondom::value);
+		tst::check_le(min_containers, usage.containers, SL);
+
+		tst::check_eq(usage.total(), usage.containers + usage.strings + usage.keys + usage.numbers, SL);
+
+		// short strings and numbers take no heap memory
+		auto short_json = jsondom::read(utki::make_span(R"({"a": "b", "c": 1})"s));
+		auto short_usage = short_json.memory_usage();
+		tst::check_eq(short_usage.strings, size_t(0), SL);
+		tst::check_eq(short_usage.keys, size_t(0), SL);
+		tst::check_eq(short_usage.numbers, size_t(0), SL);
+		tst::check(short_usage.containers != 0, SL);
+
+		// shared subtree is counted once
+		jsondom::value doubled(jsondom::type::object);
+		doubled.object()["x"] = json;
+		doubled.object()["y"] = json;
+		auto doubled_usage = doubled.memory_usage();
+		tst::check_eq(doubled_usage.strings, usage.strings, SL);
+		tst::check_eq(doubled_usage.keys, usage.keys, SL);
+		tst::check_eq(doubled_usage.numbers, usage.numbers, SL);
+
+		// the same as an object with two members plus the shared subtree
+		tst::check_eq(doubled_usage.containers, usage.containers + short_usage.containers, SL);
+	});
 });
 }
@@ -0,0 +1,204 @@
+#include <regex>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <fsif/native_file.hpp>
+#include <fsif/vector_file.hpp>
+
+#include "../../src/jsondom/cbor.hpp"
+#include "../../src/jsondom/msgpack.hpp"
+
+namespace{
+const std::string data_dir = "samples_data/";
+
+const std::vector<std::string> numbers = {
+	"0",
+	"13",
+	"-1",
+	"-33",
+	"-129",
+	"255",
+	"65536",
+	"-2147483649",
+	"18446744073709551615",
+	"-9223372036854775808",
+	"-9223372036854775809",
+	"-18446744073709551616",
+	"18446744073709551616",
+	"1.5",
+	"1.50",
+	"1e2",
+	"-0",
+	"0.1",
+	"3.14159265358979",
+	"1e400"
+};
+
+std::vector<std::string> list_samples(){
+	std::vector<std::string> files;
+	const std::regex suffix_regex("^.*\\.json$");
+	auto all_files = fsif::native_file(data_dir).list_dir();
+
+	std::copy_if(
+			all_files.begin(),
+			all_files.end(),
+			std::back_inserter(files),
+			[&suffix_regex](auto& f){
+				return std::regex_match(f, suffix_regex);
+			}
+		);
+	return files;
+}
+}
+
+namespace{
+const tst::set set("binary", [](tst::suite& suite){
+	suite.add<std::string>(
+		"cbor_sample",
+		list_samples(),
+		[](const auto& p){
+			auto json = jsondom::read(fsif::native_file(data_dir + p));
+
+			auto cbor = jsondom::to_cbor(json);
+
+			tst::check_eq(jsondom::read_cbor(utki::make_span(cbor)).to_string(), json.to_string(), SL);
+		}
+	);
+
+	suite.add<std::string>(
+		"msgpack_sample",
+		list_samples(),
+		[](const auto& p){
+			auto json = jsondom::read(fsif::native_file(data_dir + p));
+
+			auto msgpack = jsondom::to_msgpack(json);
+
+			tst::check_eq(jsondom::read_msgpack(utki::make_span(msgpack)).to_string(), json.to_string(), SL);
+		}
+	);
+
+	suite.add<std::string>(
+		"cbor_number",
+		numbers,
+		[](const auto& p){
+			jsondom::value v(jsondom::type::array);
+			v.array().emplace_back(jsondom::string_number(p));
+
+			auto cbor = jsondom::to_cbor(v);
+			auto read = jsondom::read_cbor(utki::make_span(cbor));
+
+			tst::check_eq(read.array().front().number().get_string(), p, SL);
+		}
+	);
+
+	suite.add<std::string>(
+		"msgpack_number",
+		numbers,
+		[](const auto& p){
+			jsondom::value v(jsondom::type::array);
+			v.array().emplace_back(jsondom::string_number(p));
+
+			auto msgpack = jsondom::to_msgpack(v);
+			auto read = jsondom::read_msgpack(utki::make_span(msgpack));
+
+			tst::check_eq(read.array().front().number().get_string(), p, SL);
+		}
+	);
+
+	suite.add("cbor_file", [](){
+		auto json = jsondom::read(fsif::native_file(data_dir + "sample1.json"));
+
+		fsif::vector_file fi;
+		jsondom::write_cbor(fi, json);
+
+		auto data = fi.reset_data();
+		tst::check(data == jsondom::to_cbor(json), SL);
+
+		fsif::vector_file in(std::move(data));
+		tst::check_eq(jsondom::read_cbor(in).to_string(), json.to_string(), SL);
+	});
+
+	suite.add("msgpack_file", [](){
+		auto json = jsondom::read(fsif::native_file(data_dir + "sample1.json"));
+
+		fsif::vector_file fi;
+		jsondom::write_msgpack(fi, json);
+
+		auto data = fi.reset_data();
+		tst::check(data == jsondom::to_msgpack(json), SL);
+
+		fsif::vector_file in(std::move(data));
+		tst::check_eq(jsondom::read_msgpack(in).to_string(), json.to_string(), SL);
+	});
+
+	suite.add<std::vector<uint8_t>>(
+		"cbor_malformed",
+		{
+			{}, // no data
+			{0x82, 0x01}, // truncated array
+			{0x41, 0x00}, // byte string
+			{0xa1, 0x01, 0x01}, // non-text key
+			{0xf9, 0x7c, 0x00}, // infinity
+			{0x01, 0x01}, // extra data
+			{0xff}, // unexpected break
+			{0xd9, 0x4a, 0x4e, 0x63, 'a', 'b', 'c'}, // number tag with not a number
+			{0xd9, 0x4a, 0x4e, 0x60}, // number tag with empty string
+			{0xd9, 0x4a, 0x4e, 0x62, '1', '.'}, // number tag with incomplete number
+			{0xc0} // tag without data item
+		},
+		[](const auto& p){
+			bool thrown = false;
+			try{
+				jsondom::read_cbor(utki::make_span(p));
+			}catch(jsondom::malformed_binary_data_error&){
+				thrown = true;
+			}
+			tst::check(thrown, SL);
+		}
+	);
+
+	suite.add("cbor_long_run_of_tags", [](){
+		// unknown tags are skipped, a long run of them must not exhaust the stack
+		std::vector<uint8_t> data(1000000, 0xc0);
+		data.push_back(0xf6); // null
+
+		auto json = jsondom::read_cbor(utki::make_span(data));
+		tst::check(json.is_null(), SL);
+	});
+
+	suite.add("cbor_number_tag", [](){
+		// unknown tag, then number tag with "-1.5e3" text
+		std::vector<uint8_t> data = {0xc0, 0xd9, 0x4a, 0x4e, 0x66, '-', '1', '.', '5', 'e', '3'};
+
+		auto json = jsondom::read_cbor(utki::make_span(data));
+		tst::check_eq(json.number().get_string(), std::string("-1.5e3"), SL);
+	});
+
+	suite.add<std::vector<uint8_t>>(
+		"msgpack_malformed",
+		{
+			{}, // no data
+			{0x92, 0x01}, // truncated array
+			{0xc4, 0x01, 0x00}, // binary
+			{0x81, 0x01, 0x01}, // non-string key
+			{0xcb, 0x7f, 0xf0, 0, 0, 0, 0, 0, 0}, // infinity
+			{0xd4, 0x01, 0x00}, // unknown extension type
+			{0x01, 0x01}, // extra data
+			{0xc1}, // never used byte
+			{0xc7, 0x03, 0x4e, 'a', 'b', 'c'}, // number extension with not a number
+			{0xd4, 0x4e, '-'}, // number extension with incomplete number
+			{0xd5, 0x4e, '1', 'e'} // number extension with incomplete number
+		},
+		[](const auto& p){
+			bool thrown = false;
+			try{
+				jsondom::read_msgpack(utki::make_span(p));
+			}catch(jsondom::malformed_binary_data_error&){
+				thrown = true;
+			}
+			tst::check(thrown, SL);
+		}
+	);
+});
+}
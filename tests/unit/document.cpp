@@ -0,0 +1,187 @@
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include "../../src/jsondom/document.hpp"
+
+using namespace std::string_literals;
+
+namespace{
+const std::string source = R"qwertyuiop({
+	"name": "config",
+	"servers": [
+		{"host": "a.example.com", "ports": [80, 443]},
+		{"host": "b.example.com", "ports": [8080]}
+	],
+	"limits": {"cpu": 4, "memory": {"min": 1, "max": 8}},
+	"tags": ["x", "y"]
+})qwertyuiop";
+
+// apply edit replacing the first occurrence of the given text
+bool replace(jsondom::document& doc, std::string_view what, std::string_view with){
+	auto pos = doc.get_text().find(what);
+	tst::check(pos != std::string::npos, SL) << "text not found: " << what;
+	return doc.edit(pos, what.size(), with);
+}
+
+// check that parsed value is the same as if the whole text is parsed
+void check_value(const jsondom::document& doc){
+	tst::check_eq(doc.get_value().to_string(), jsondom::read(doc.get_text()).to_string(), SL);
+}
+}
+
+namespace{
+const tst::set set("document", [](tst::suite& suite){
+	suite.add("parse", [](){
+		jsondom::document doc(source);
+		tst::check_eq(doc.get_text(), source, SL);
+		check_value(doc);
+	});
+
+	suite.add("edit_nested_values", [](){
+		jsondom::document doc(source);
+
+		// number in nested array
+		tst::check(replace(doc, "8080", "9090"), SL);
+		check_value(doc);
+		tst::check_eq(doc.get_value().object().at("servers").array()[1].object().at("ports").array()[0].number().to_int32(), 9090, SL);
+
+		// string in nested object, makes the text longer
+		tst::check(replace(doc, "a.example.com", "alpha.example.com"), SL);
+		check_value(doc);
+
+		// the following values are found after the text has shifted
+		tst::check(replace(doc, "\"max\": 8", "\"max\": 16"), SL);
+		check_value(doc);
+		tst::check(replace(doc, "\"y\"", "\"z\", \"w\""), SL);
+		check_value(doc);
+
+		// add member to the root object
+		tst::check(replace(doc, "\"name\"", "\"version\": 2, \"name\""), SL);
+		check_value(doc);
+
+		// rename key, the text gets shorter
+		tst::check(replace(doc, "\"memory\"", "\"mem\""), SL);
+		check_value(doc);
+		tst::check(doc.get_value().object().at("limits").object().at("mem").object().at("max").number().to_int32() == 16, SL);
+
+		// replace nested array by a scalar
+		tst::check(replace(doc, "[80, 443]", "null"), SL);
+		check_value(doc);
+
+		// edits of the same values again, to check the locations are updated correctly
+		tst::check(replace(doc, "9090", "1"), SL);
+		tst::check(replace(doc, "\"z\"", "{\"k\": [1, {}]}"), SL);
+		tst::check(replace(doc, "[1, {}]", "[]"), SL);
+		check_value(doc);
+	});
+
+	suite.add("edit_escaped_key", [](){
+		jsondom::document doc(R"({"a\"b": {"c": [1, 2]}, "d": 3})");
+		tst::check(replace(doc, "2", "5"), SL);
+		check_value(doc);
+		tst::check_eq(doc.get_value().object().at("a\"b").object().at("c").array()[1].number().to_int32(), 5, SL);
+	});
+
+	suite.add("edit_changing_structure", [](){
+		jsondom::document doc(source);
+
+		// splits "limits" object into two members of the root object
+		tst::check(!replace(doc, "\"cpu\": 4,", "\"cpu\": 4}, \"more\": {"), SL);
+		check_value(doc);
+		tst::check(doc.get_value().object().at("more").object().count("memory") == 1, SL);
+
+		// remove root object's closing bracket and add it back
+		auto size = doc.get_text().size();
+		tst::check_eq(doc.get_text()[size - 1], '}', SL);
+		tst::check(!doc.edit(size - 1, 1, "}"), SL);
+		check_value(doc);
+
+		// editing nested value works after the full reparse
+		tst::check(replace(doc, "443", "444"), SL);
+		check_value(doc);
+	});
+
+	suite.add("edit_duplicate_keys", [](){
+		jsondom::document doc(R"({"a": {"b": [1]}, "a": {"b": [2]}})");
+		tst::check(!replace(doc, "[1]", "[3]"), SL);
+		check_value(doc);
+		tst::check_eq(doc.get_value().object().at("a").object().at("b").array()[0].number().to_int32(), 2, SL);
+	});
+
+	suite.add("edit_duplicate_keys_of_different_types", [](){
+		jsondom::document doc(R"({"a": {"b": {"c": [1]}}, "d": [{"e": 1}], "a": {"f": 2}, "d": 3})");
+		check_value(doc);
+		tst::check(!replace(doc, "[1]", "[3]"), SL);
+		check_value(doc);
+		tst::check(!replace(doc, "\"e\"", "\"g\""), SL);
+		check_value(doc);
+		tst::check(!replace(doc, "2", "4"), SL);
+		check_value(doc);
+
+		// members of the root object are not overwritten
+		tst::check(doc.edit(doc.get_text().size() - 2, 1, "5"), SL);
+		check_value(doc);
+	});
+
+	suite.add("edit_malformed", [](){
+		jsondom::document doc(source);
+
+		bool thrown = false;
+		try{
+			replace(doc, "\"cpu\": 4", "\"cpu\": }");
+		}catch(jsondom::malformed_json_error&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		// document is unchanged
+		tst::check_eq(doc.get_text(), source, SL);
+		check_value(doc);
+
+		thrown = false;
+		try{
+			doc.edit(source.size(), 1, "");
+		}catch(std::out_of_range&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		// appending is allowed
+		tst::check(!doc.edit(source.size(), 0, "\n"), SL);
+		check_value(doc);
+	});
+	suite.add("edit_every_position", [](){
+		// remove or insert a character at every position of the text and compare to parsing the whole text
+		for(const auto& [removed_length, inserted] : {
+				std::make_pair(size_t(0), " "s),
+				std::make_pair(size_t(0), "1"s),
+				std::make_pair(size_t(1), ""s),
+				std::make_pair(size_t(1), "]"s)
+			})
+		{
+			for(size_t i = 0; i + removed_length <= source.size(); ++i){
+				auto text = source;
+				text.replace(i, removed_length, inserted);
+
+				// jsondom::read() does not detect unexpected end of document, so parse the whole text with document
+				std::string expected;
+				try{
+					expected = jsondom::document(text).get_value().to_string();
+				}catch(jsondom::malformed_json_error&){}
+
+				jsondom::document doc(source);
+				try{
+					doc.edit(i, removed_length, inserted);
+				}catch(jsondom::malformed_json_error&){
+					tst::check(expected.empty(), SL) << "i = " << i << ", text = " << text;
+					tst::check_eq(doc.get_text(), source, SL);
+					continue;
+				}
+				tst::check(!expected.empty(), SL) << "i = " << i << ", text = " << text;
+				tst::check_eq(doc.get_text(), text, SL);
+				tst::check_eq(doc.get_value().to_string(), expected, SL);
+			}
+		}
+	});
+});
+}
@@ -0,0 +1,121 @@
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include "../../src/jsondom/dom_parser.hpp"
+#include "../../src/jsondom/event_stream.hpp"
+
+using namespace std::string_literals;
+
+namespace{
+const std::string source = R"({"a": [1, "b\n", {}], "c": {"d": true, "e": null}, "f": false})";
+
+const std::vector<std::string> expected_events = {
+	"{", "key:a", "[", "number:1", "string:b\n", "{", "}", "]",
+	"key:c", "{", "key:d", "boolean:true", "key:e", "null", "}",
+	"key:f", "boolean:false", "}"
+};
+
+std::string to_string(const jsondom::event& e){
+	switch(e.type){
+		case jsondom::event_type::object_start:
+			return "{";
+		case jsondom::event_type::object_end:
+			return "}";
+		case jsondom::event_type::array_start:
+			return "[";
+		case jsondom::event_type::array_end:
+			return "]";
+		case jsondom::event_type::key:
+			return "key:"s.append(e.text);
+		case jsondom::event_type::string:
+			return "string:"s.append(e.text);
+		case jsondom::event_type::number:
+			return "number:"s.append(e.text);
+		case jsondom::event_type::boolean:
+			return e.boolean ? "boolean:true"s : "boolean:false"s;
+		case jsondom::event_type::null:
+			return "null"s;
+	}
+	return {};
+}
+}
+
+namespace{
+const tst::set set("event_stream", [](tst::suite& suite){
+	suite.add<size_t>(
+		"pull_events",
+		{1, 2, 3, 7, 1000},
+		[](const auto& chunk_size){
+			jsondom::event_stream s;
+
+			std::vector<std::string> events;
+
+			for(size_t i = 0; i < source.size(); i += chunk_size){
+				tst::check(!s.is_complete(), SL);
+				s.feed(utki::make_span(source).subspan(i, chunk_size));
+				while(auto e = s.next()){
+					events.push_back(to_string(*e));
+				}
+			}
+			tst::check(s.is_complete(), SL);
+			tst::check(!s.next().has_value(), SL);
+
+			tst::check(events == expected_events, SL);
+		}
+	);
+
+	suite.add("events_not_pulled_between_feeds", [](){
+		jsondom::event_stream s;
+
+		for(size_t i = 0; i != source.size(); ++i){
+			s.feed(utki::make_span(source).subspan(i, 1));
+		}
+		tst::check(s.is_complete(), SL);
+
+		std::vector<std::string> events;
+		while(auto e = s.next()){
+			events.push_back(to_string(*e));
+		}
+		tst::check(events == expected_events, SL);
+	});
+
+	suite.add("reset", [](){
+		jsondom::event_stream s;
+
+		s.feed(R"({"a": [1, 2)"s);
+		tst::check(!s.is_complete(), SL);
+		tst::check(s.next().has_value(), SL);
+
+		s.reset();
+		tst::check(!s.is_complete(), SL);
+		tst::check(!s.next().has_value(), SL);
+
+		s.feed(R"({"b": null})"s);
+		tst::check(s.is_complete(), SL);
+
+		std::vector<std::string> events;
+		while(auto e = s.next()){
+			events.push_back(to_string(*e));
+		}
+		tst::check(events == std::vector<std::string>{"{", "key:b", "null", "}"}, SL);
+	});
+
+	suite.add("dom_parser_is_complete", [](){
+		jsondom::dom_parser p;
+
+		tst::check(!p.is_complete(), SL);
+
+		for(size_t i = 0; i != source.size(); ++i){
+			tst::check(!p.is_complete(), SL) << "i = " << i;
+			p.feed(utki::make_span(source).subspan(i, 1));
+		}
+		tst::check(p.is_complete(), SL);
+
+		// trailing whitespace does not change anything
+		p.feed(" \n"s);
+		tst::check(p.is_complete(), SL);
+
+		tst::check_eq(p.release_document().to_string(), jsondom::read(source).to_string(), SL);
+	});
+});
+}
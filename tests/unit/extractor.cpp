@@ -0,0 +1,144 @@
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <fsif/native_file.hpp>
+
+#include "../../src/jsondom/extractor.hpp"
+#include "../../src/jsondom/writer.hpp"
+
+namespace{
+const std::string test_json = R"qwertyuiop(
+	{
+		"quotes": {
+			"quote": [
+				{"symbol": "A", "last": 1.5},
+				{"symbol": "B", "last": 2, "extra": {"last": 13}},
+				{"symbol": "C"}
+			]
+		},
+		"a/b": {"m~n": "escaped"},
+		"0": "zero"
+	}
+)qwertyuiop";
+}
+
+namespace{
+const tst::set set("extractor", [](tst::suite& suite){
+	suite.add<std::pair<std::string, std::string>>(
+		"extract",
+		{
+			{"", R"({"0":"zero","a\/b":{"m~n":"escaped"},"quotes":{"quote":[{"last":1.5,"symbol":"A"},{"extra":{"last":13},"last":2,"symbol":"B"},{"symbol":"C"}]}})"},
+			{"$", R"({"0":"zero","a\/b":{"m~n":"escaped"},"quotes":{"quote":[{"last":1.5,"symbol":"A"},{"extra":{"last":13},"last":2,"symbol":"B"},{"symbol":"C"}]}})"},
+			{"/quotes/quote/*/last", "1.5,2"},
+			{"$.quotes.quote[*].last", "1.5,2"},
+			{"$['quotes'][\"quote\"][1].symbol", R"("B")"},
+			{"/quotes/quote/1", R"({"extra":{"last":13},"last":2,"symbol":"B"})"},
+			{"/quotes/quote/3", ""},
+			{"/quotes/quote/01", ""},
+			{"/quotes/*/*/extra", R"({"last":13})"},
+			{"$.*.quote[2]", R"({"symbol":"C"})"},
+			{"/a~1b/m~0n", R"("escaped")"},
+			{"/0", R"("zero")"},
+			{"/quotes/quote/last", ""}
+		},
+		[](const auto& p){
+			auto matches = jsondom::extract(utki::make_span(test_json), {p.first});
+			tst::check_eq(matches.size(), size_t(1), SL);
+
+			std::string str;
+			for(const auto& m : matches.front()){
+				if(!str.empty()){
+					str.append(",");
+				}
+				jsondom::writer w;
+				w.value(m);
+				str.append(w.reset_data());
+			}
+
+			tst::check_eq(str, p.second, SL) << "path = " << p.first;
+		}
+	);
+
+	suite.add("several_overlapping_paths", [](){
+		auto matches = jsondom::extract(
+				utki::make_span(test_json),
+				{"/quotes/quote/1", "/quotes/quote/*/last", "$.quotes.quote[*]", "/quotes/quote/1"}
+			);
+		tst::check_eq(matches.size(), size_t(4), SL);
+		tst::check_eq(matches[0].size(), size_t(1), SL);
+		tst::check_eq(matches[1].size(), size_t(2), SL);
+		tst::check_eq(matches[2].size(), size_t(3), SL);
+		tst::check_eq(matches[3].size(), size_t(1), SL);
+		tst::check_eq(matches[0].front().to_string(), matches[2][1].to_string(), SL);
+		tst::check_eq(matches[0].front().to_string(), matches[3].front().to_string(), SL);
+		tst::check_eq(matches[1].back().number().get_string(), std::string("2"), SL);
+	});
+
+	suite.add<std::string>(
+		"malformed_path",
+		{
+			"quotes",
+			"/a~2",
+			"/a~",
+			"$..last",
+			"$.a[",
+			"$.a['b'",
+			"$.a[-1]",
+			"$.a[01]",
+			"$a"
+		},
+		[](const auto& p){
+			bool thrown = false;
+			try{
+				jsondom::extractor e({p});
+			}catch(std::invalid_argument&){
+				thrown = true;
+			}
+			tst::check(thrown, SL) << "path = " << p;
+		}
+	);
+
+	suite.add("sample_matches_dom", [](){
+		auto data = fsif::native_file("samples_data/tradier_prices.json").load();
+
+		auto json = jsondom::read(utki::make_span(data));
+		auto matches = jsondom::extract(
+				utki::to_char(utki::make_span(data)),
+				{"/series/data/*/price", "/series/data/0"}
+			);
+
+		const auto& series = json.object().at("series").object().at("data").array();
+
+		tst::check_eq(matches[0].size(), series.size(), SL);
+		for(size_t i = 0; i != series.size(); ++i){
+			tst::check_eq(
+					matches[0][i].number().get_string(),
+					series[i].object().at("price").number().get_string(),
+					SL
+				);
+		}
+
+		tst::check_eq(matches[1].size(), size_t(1), SL);
+		tst::check_eq(matches[1].front().to_string(), series.front().to_string(), SL);
+	});
+
+	suite.add("reset_in_the_middle_of_match", [](){
+		jsondom::extractor e({"/quotes/quote/*", "/quotes/quote/*/extra"});
+
+		// stop inside of the nested matches
+		auto pos = test_json.find("13");
+		e.feed(utki::make_span(test_json.data(), pos));
+		e.reset();
+
+		// the builders of the interrupted matches are reused, they must not keep the partially built values
+		e.feed(utki::make_span(test_json));
+		auto matches = e.release_matches();
+
+		tst::check_eq(matches.size(), size_t(2), SL);
+		tst::check_eq(matches[0].size(), size_t(3), SL);
+		tst::check_eq(matches[0][1].to_string(), std::string(R"({"extra":{"last":13},"last":2,"symbol":"B"})"), SL);
+		tst::check_eq(matches[1].size(), size_t(1), SL);
+		tst::check_eq(matches[1][0].to_string(), std::string(R"({"last":13})"), SL);
+	});
+});
+}
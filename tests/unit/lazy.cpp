@@ -0,0 +1,167 @@
+#include <regex>
+#include <thread>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <fsif/native_file.hpp>
+
+#include "../../src/jsondom/lazy.hpp"
+
+namespace{
+const std::string data_dir = "samples_data/";
+
+// check that lazy value tree is the same as the DOM
+bool equals(const jsondom::lazy_value& l, const jsondom::value& v){
+	if(l.get_type() != v.get_type()){
+		return false;
+	}
+	switch(v.get_type()){
+		case jsondom::type::null:
+			return true;
+		case jsondom::type::boolean:
+			return l.boolean() == v.boolean();
+		case jsondom::type::number:
+			return l.number().get_string() == v.number().get_string();
+		case jsondom::type::string:
+			return l.string() == v.string();
+		case jsondom::type::array:
+			return std::equal(
+					l.array().begin(),
+					l.array().end(),
+					v.array().begin(),
+					v.array().end(),
+					[](const auto& a, const auto& b){
+						return equals(a, b);
+					}
+				);
+		case jsondom::type::object:
+			return std::equal(
+					l.object().begin(),
+					l.object().end(),
+					v.object().begin(),
+					v.object().end(),
+					[](const auto& a, const auto& b){
+						return a.first == b.first && equals(a.second, b.second);
+					}
+				);
+		default:
+			return false;
+	}
+}
+}
+
+namespace{
+const tst::set set("lazy", [](tst::suite& suite){
+	suite.add("access", [](){
+		auto l = jsondom::read_lazy(std::string(R"qwertyuiop(
+			{
+				"string": "with \" {[ brackets",
+				"number": -1.50,
+				"array": [1, [2, [3]], {"a": "}"}, true, false, null],
+				"object": {"nested": {"deep": []}}
+			}
+		)qwertyuiop"));
+
+		tst::check(l.is_object(), SL);
+
+		const auto& o = l.object();
+		tst::check_eq(o.size(), size_t(4), SL);
+		tst::check_eq(o.at("string").string(), std::string("with \" {[ brackets"), SL);
+		tst::check_eq(o.at("number").number().get_string(), std::string("-1.50"), SL);
+
+		const auto& a = o.at("array");
+		tst::check(a.is_array(), SL);
+		tst::check_eq(a.array().size(), size_t(6), SL);
+		tst::check(a.array()[1].array()[1].is_array(), SL);
+		tst::check_eq(a.array()[2].object().at("a").string(), std::string("}"), SL);
+		tst::check(a.array()[3].boolean(), SL);
+		tst::check(a.array()[5].is_null(), SL);
+
+		tst::check(o.at("object").object().at("nested").object().at("deep").array().empty(), SL);
+
+		tst::check_eq(o.at("array").to_value().array().size(), size_t(6), SL);
+
+		bool thrown = false;
+		try{
+			o.at("object").array();
+		}catch(jsondom::unexpected_value_type&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+	});
+
+	suite.add("malformed", [](){
+		// malformed nested array is only detected when accessed
+		auto l = jsondom::read_lazy(std::string(R"({"good": [1, 2], "bad": [1 2]})"));
+		tst::check_eq(l.object().at("good").array().size(), size_t(2), SL);
+
+		for(unsigned i = 0; i != 2; ++i){
+			bool thrown = false;
+			try{
+				l.object().at("bad").array();
+			}catch(jsondom::malformed_json_error&){
+				thrown = true;
+			}
+			tst::check(thrown, SL);
+		}
+
+		for(const auto& s : {"", "[]", R"({"a": [})", R"({"a": "})", "{} {}"}){
+			bool thrown = false;
+			try{
+				jsondom::read_lazy(std::string(s));
+			}catch(jsondom::malformed_json_error&){
+				thrown = true;
+			}
+			tst::check(thrown, SL) << "json = " << s;
+		}
+	});
+
+	suite.add("concurrent_access", [](){
+		auto l = jsondom::read_lazy(fsif::native_file(data_dir + "tradier_prices.json"));
+		auto v = jsondom::read(fsif::native_file(data_dir + "tradier_prices.json"));
+
+		constexpr auto num_threads = 8;
+		std::vector<std::thread> threads;
+		std::vector<char> results(num_threads, false);
+		for(size_t i = 0; i != num_threads; ++i){
+			threads.emplace_back([&l, &v, &result = results[i]](){
+				result = equals(l, v);
+			});
+		}
+		for(auto& t : threads){
+			t.join();
+		}
+
+		for(auto r : results){
+			tst::check(r, SL);
+		}
+	});
+
+	std::vector<std::string> files;
+	{
+		const std::regex suffix_regex("^.*\\.json$");
+		auto all_files = fsif::native_file(data_dir).list_dir();
+
+		std::copy_if(
+				all_files.begin(),
+				all_files.end(),
+				std::back_inserter(files),
+				[&suffix_regex](auto& f){
+					return std::regex_match(f, suffix_regex);
+				}
+			);
+	}
+
+	suite.add<std::string>(
+		"sample",
+		std::move(files),
+		[](const auto& p){
+			auto v = jsondom::read(fsif::native_file(data_dir + p));
+
+			tst::check_eq(jsondom::read_lazy(fsif::native_file(data_dir + p)).to_value().to_string(), v.to_string(), SL);
+			tst::check(equals(jsondom::read_lazy(fsif::native_file(data_dir + p)), v), SL);
+		}
+	);
+});
+}
@@ -0,0 +1,77 @@
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include "../../src/jsondom/object_index.hpp"
+
+using namespace std::string_literals;
+
+namespace{
+constexpr jsondom::key bid_key = "bid";
+
+// the hash is computed at compile time
+static_assert(bid_key.get_hash() == jsondom::internal::key_hash("bid", 0));
+static_assert(bid_key.get_string().size() == 3);
+}
+
+namespace{
+const tst::set set("object_index", [](tst::suite& suite){
+	suite.add("find", [](){
+		auto json = jsondom::read(R"({"bid": 1.5, "ask": 1.6, "": null, "bi": true, "bidd": false})"s);
+
+		jsondom::object_index index(json);
+
+		auto bid = index.find(bid_key);
+		tst::check(bid, SL);
+		tst::check_eq(bid->number().get_string(), "1.5"s, SL);
+
+		tst::check(index.find("ask") == &json.object().at("ask"), SL);
+		tst::check(index.find("") == &json.object().at(""), SL);
+		tst::check(index.find("bi") == &json.object().at("bi"), SL);
+		tst::check(index.find("bidd") == &json.object().at("bidd"), SL);
+
+		tst::check(!index.find("bi_"), SL);
+		tst::check(!index.find("last"), SL);
+	});
+
+	suite.add("empty", [](){
+		jsondom::object_index index;
+		tst::check(!index.find(bid_key), SL);
+
+		index.rebuild(jsondom::value(jsondom::type::object).object());
+		tst::check(!index.find(bid_key), SL);
+	});
+
+	suite.add<size_t>(
+		"many_members",
+		{1, 2, 3, 100, 1000},
+		[](const auto& num_members){
+			jsondom::value json(jsondom::type::object);
+			for(size_t i = 0; i != num_members; ++i){
+				json.object()["key" + std::to_string(i)] = jsondom::value(jsondom::string_number(i));
+			}
+
+			jsondom::object_index index;
+			index.rebuild(std::as_const(json).object());
+
+			for(size_t i = 0; i != num_members; ++i){
+				auto k = "key" + std::to_string(i);
+				auto v = index.find(k);
+				tst::check(v, SL) << k;
+				tst::check_eq(v->number().to_uint32(), uint32_t(i), SL);
+			}
+			tst::check(!index.find("key"), SL);
+			tst::check(!index.find("key" + std::to_string(num_members)), SL);
+		}
+	);
+
+	suite.add("not_an_object", [](){
+		bool thrown = false;
+		try{
+			jsondom::object_index index(jsondom::value(true));
+		}catch(jsondom::unexpected_value_type&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+	});
+});
+}
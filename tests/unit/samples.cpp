@@ -32,7 +32,7 @@ const tst::set set("samples", [](tst::suite& suite){
 
     suite.add<std::string>(
         "sample",
-        std::move(files),
+        files,
         [](const auto& p){
             auto in_file_name = data_dir + p;
 
@@ -57,5 +57,40 @@ const tst::set set("samples", [](tst::suite& suite){
             }
         }
     );
+
+    suite.add<std::string>(
+        "sample_padded_buffer",
+        files,
+        [](const auto& p){
+            auto in_file_name = data_dir + p;
+
+            auto data = fsif::native_file(in_file_name).load();
+
+            auto expected = jsondom::read(utki::make_span(data)).to_string();
+
+            auto json = jsondom::read(jsondom::padded_buffer(utki::make_span(data)));
+
+            tst::check_eq(json.to_string(), expected, SL);
+        }
+    );
+
+    suite.add<std::string>(
+        "sample_background_io",
+        std::move(files),
+        [](const auto& p){
+            auto in_file_name = data_dir + p;
+
+            auto expected = jsondom::read(fsif::native_file(in_file_name)).to_string();
+
+            // use odd small chunk size to make chunk boundaries fall inside of tokens
+            jsondom::read_options options;
+            options.chunk_size = 13;
+            options.num_background_buffers = 3;
+
+            auto json = jsondom::read(fsif::native_file(in_file_name), options);
+
+            tst::check_eq(json.to_string(), expected, SL);
+        }
+    );
 });
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include <cstdio>
+#include <regex>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <fsif/native_file.hpp>
+#include <fsif/vector_file.hpp>
+
+#include "../../src/jsondom/snapshot.hpp"
+
+namespace{
+const std::string data_dir = "samples_data/";
+
+const std::string test_json = R"qwertyuiop(
+	{
+		"b": [1, "two", true, false, null, {"x": -1.5e3}],
+		"a": "hello",
+		"c": {"nested": {"deep": [[], {}]}},
+		"d": 0
+	}
+)qwertyuiop";
+}
+
+namespace{
+const tst::set set("snapshot", [](tst::suite& suite){
+	suite.add("navigate", [](){
+		auto json = jsondom::read(utki::make_span(test_json));
+
+		jsondom::snapshot s(jsondom::to_snapshot(json));
+
+		auto root = s.root();
+		tst::check(root.is_object(), SL);
+		tst::check_eq(root.size(), size_t(4), SL);
+		tst::check_eq(root.key(0), std::string_view("a"), SL);
+		tst::check_eq(root.key(3), std::string_view("d"), SL);
+		tst::check_eq(root.at("a").string(), std::string_view("hello"), SL);
+		tst::check_eq(root.at("d").number(), std::string_view("0"), SL);
+
+		auto b = root.at("b");
+		tst::check(b.is_array(), SL);
+		tst::check_eq(b.size(), size_t(6), SL);
+		tst::check_eq(b.at(0).number(), std::string_view("1"), SL);
+		tst::check_eq(b.at(1).string(), std::string_view("two"), SL);
+		tst::check(b.at(2).boolean(), SL);
+		tst::check(!b.at(3).boolean(), SL);
+		tst::check(b.at(4).is_null(), SL);
+		tst::check_eq(b.at(5).at("x").number(), std::string_view("-1.5e3"), SL);
+
+		tst::check(!root.find("e").has_value(), SL);
+		tst::check(!root.find("").has_value(), SL);
+		tst::check(root.at("c").at("nested").at("deep").at(1).is_object(), SL);
+
+		bool thrown = false;
+		try{
+			b.at(6);
+		}catch(std::out_of_range&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		thrown = false;
+		try{
+			root.at("a").number();
+		}catch(jsondom::unexpected_value_type&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		tst::check_eq(root.to_value().to_string(), json.to_string(), SL);
+	});
+
+	suite.add("corrupt_data", [](){
+		auto json = jsondom::read(utki::make_span(test_json));
+
+		auto data = jsondom::to_snapshot(json);
+
+		// corrupt a byte of the last node
+		data[data.size() - 3] ^= 0xff;
+
+		bool thrown = false;
+		try{
+			jsondom::snapshot s(utki::make_span(data));
+		}catch(jsondom::malformed_binary_data_error&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		// without checksum verification the node offsets are still range checked
+		jsondom::snapshot s(utki::make_span(data), false);
+		thrown = false;
+		try{
+			s.root().to_value();
+		}catch(jsondom::malformed_binary_data_error&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		thrown = false;
+		try{
+			jsondom::snapshot s(std::vector<uint8_t>{'j', 's', 'o', 'n'});
+		}catch(jsondom::malformed_binary_data_error&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+	});
+
+	suite.add("map_file", [](){
+		auto json = jsondom::read(utki::make_span(test_json));
+
+		const std::string file_name = "snapshot_map_file_test.snap";
+
+		{
+			fsif::native_file fi(file_name);
+			jsondom::write_snapshot(fi, json);
+		}
+
+		std::string read;
+		{
+			jsondom::snapshot s(file_name);
+			read = s.root().to_value().to_string();
+		}
+		std::remove(file_name.c_str());
+
+		tst::check_eq(read, json.to_string(), SL);
+	});
+
+	std::vector<std::string> files;
+	{
+		const std::regex suffix_regex("^.*\\.json$");
+		auto all_files = fsif::native_file(data_dir).list_dir();
+
+		std::copy_if(
+				all_files.begin(),
+				all_files.end(),
+				std::back_inserter(files),
+				[&suffix_regex](auto& f){
+					return std::regex_match(f, suffix_regex);
+				}
+			);
+	}
+
+	suite.add<std::string>(
+		"sample",
+		std::move(files),
+		[](const auto& p){
+			auto json = jsondom::read(fsif::native_file(data_dir + p));
+
+			fsif::vector_file fi;
+			jsondom::write_snapshot(fi, json);
+
+			jsondom::snapshot s(fi);
+
+			tst::check_eq(s.root().to_value().to_string(), json.to_string(), SL);
+		}
+	);
+});
+}
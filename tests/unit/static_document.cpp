@@ -0,0 +1,142 @@
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include "../../src/jsondom/static_document.hpp"
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace{
+constexpr char config_json[] = R"qwertyuiop({
+	"name": "config",
+	"timeout": -12.5e+3,
+	"features": {"fast_path": true, "slow_path": false, "legacy": null},
+	"ports": [80, 443, 8080],
+	"escapes": "a\"b\\c\/d\n\u0041\u0444\u20ac\u0000\ud83d\ude00",
+	"empty_object": {},
+	"empty_array": [],
+	"nested": [[1, [2]], {"a": [3]}]
+})qwertyuiop";
+
+constexpr auto config = jsondom::static_read<config_json>();
+
+// the document can be inspected at compile time
+static_assert(config.root().is_object());
+static_assert(config.root().object().size() == 8);
+static_assert(config.root().object().at("name").string() == "config");
+static_assert(config.root().object().at("timeout").number() == "-12.5e+3");
+static_assert(config.root().object().at("features").object().at("fast_path").boolean());
+static_assert(!config.root().object().at("features").object().at("slow_path").boolean());
+static_assert(config.root().object().at("features").object().at("legacy").is_null());
+static_assert(!config.root().object().contains("legacy"));
+static_assert(config.root().object().at("ports").array().size() == 3);
+static_assert(config.root().object().at("ports").array()[2].number() == "8080");
+static_assert(config.root().object().at("escapes").string() == std::string_view("a\"b\\c/d\nA\u0444\u20ac\0\U0001F600", 19));
+static_assert(config.root().object().at("empty_object").object().empty());
+static_assert(config.root().object().at("empty_array").array().empty());
+static_assert(config.root().object().at("nested").array()[0].array()[1].array()[0].number() == "2");
+static_assert(config.root().object().at("nested").array()[1].object().at("a").array()[0].number() == "3");
+
+constexpr char number_json[] = "123";
+static_assert(jsondom::static_read<number_json>().root().number() == "123");
+
+constexpr char string_json[] = R"( "abc" )";
+static_assert(jsondom::static_read<string_json>().root().string() == "abc");
+}
+
+namespace{
+const tst::set set("static_document", [](tst::suite& suite){
+	suite.add("iterate", [](){
+		auto root = config.root();
+
+		std::vector<std::string> keys;
+		for(const auto& m : root.object()){
+			keys.emplace_back(m.first);
+		}
+		tst::check(
+			keys == std::vector<std::string>{"name", "timeout", "features", "ports", "escapes", "empty_object", "empty_array", "nested"},
+			SL
+		);
+
+		std::vector<std::string> ports;
+		for(const auto& p : root.object().at("ports").array()){
+			ports.emplace_back(p.number());
+		}
+		tst::check(ports == std::vector<std::string>{"80", "443", "8080"}, SL);
+	});
+
+	suite.add("to_value", [](){
+		auto v = config.root().to_value();
+		tst::check_eq(v.to_string(), jsondom::read(config_json).to_string(), SL);
+	});
+
+	suite.add("access_errors", [](){
+		auto root = config.root();
+
+		bool thrown = false;
+		try{
+			root.object().at("name").boolean();
+		}catch(jsondom::unexpected_value_type&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		thrown = false;
+		try{
+			root.object().at("no_such_key");
+		}catch(std::out_of_range&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+
+		thrown = false;
+		try{
+			root.object().at("ports").array().at(3);
+		}catch(std::out_of_range&){
+			thrown = true;
+		}
+		tst::check(thrown, SL);
+	});
+
+	// at compile time these are compilation errors, check that the parser detects them at run time
+	suite.add<std::string>(
+		"malformed",
+		{
+			"",
+			"{",
+			"{\"a\" 1}",
+			"{\"a\": 1,}",
+			"{\"a\": 1 \"b\": 2}",
+			"{\"a\": 1, \"a\": 2}",
+			"[1 2]",
+			"[1,]",
+			"tru",
+			"nul",
+			"-",
+			"1.",
+			"1e",
+			"01a",
+			"\"abc",
+			"\"\\x\"",
+			"\"\\u12g4\"",
+			"\"\\ud83d\"",
+			"\"\\ud83d\\n\"",
+			"\"\\ud83d\\u0041\"",
+			"\"\\ude00\"",
+			"{} {}",
+		},
+		[](const auto& p){
+			bool thrown = false;
+			try{
+				jsondom::internal::static_parser parser(p, nullptr, nullptr);
+				std::vector<jsondom::internal::static_node> nodes(parser.num_nodes);
+				std::vector<char> text(parser.text_size);
+				jsondom::internal::static_parser(p, nodes.data(), text.data());
+			}catch(jsondom::malformed_json_error&){
+				thrown = true;
+			}
+			tst::check(thrown, SL) << "json = " << p;
+		}
+	);
+});
+}
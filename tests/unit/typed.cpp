@@ -0,0 +1,286 @@
+#include <limits>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <fsif/native_file.hpp>
+#include <fsif/vector_file.hpp>
+
+#include "../../src/jsondom/typed_parser.hpp"
+#include "../../src/jsondom/typed_writer.hpp"
+
+namespace{
+struct candle{
+	std::string time;
+	int64_t timestamp = 0;
+	double price = 0;
+	uint32_t volume = 0;
+};
+
+struct price_series{
+	std::vector<candle> data;
+};
+
+struct prices{
+	price_series series;
+};
+
+struct everything{
+	bool flag = false;
+	int8_t small = 0;
+	float real = 0;
+	std::string text;
+	jsondom::string_number exact;
+	std::optional<int> absent;
+	std::optional<int> null = 13;
+	std::optional<std::vector<std::string>> strings;
+	std::map<std::string, std::vector<int>> map;
+	std::vector<everything> children;
+	int untouched = 42;
+};
+
+struct special_keys{
+	int slash = 1;
+	std::string unicode = "\xd0\xb0";
+	std::optional<double> infinity = std::numeric_limits<double>::infinity();
+};
+
+struct no_fields{};
+
+struct single_float{
+	float v = 0;
+};
+}
+
+template <>
+struct jsondom::describe<candle>{
+	static constexpr auto fields = std::make_tuple(
+			jsondom::field("time", &candle::time),
+			jsondom::field("timestamp", &candle::timestamp),
+			jsondom::field("price", &candle::price),
+			jsondom::field("volume", &candle::volume)
+		);
+};
+
+template <>
+struct jsondom::describe<price_series>{
+	static constexpr auto fields = std::make_tuple(
+			jsondom::field("data", &price_series::data)
+		);
+};
+
+template <>
+struct jsondom::describe<prices>{
+	static constexpr auto fields = std::make_tuple(
+			jsondom::field("series", &prices::series)
+		);
+};
+
+template <>
+struct jsondom::describe<everything>{
+	static constexpr auto fields = std::make_tuple(
+			jsondom::field("flag", &everything::flag),
+			jsondom::field("small", &everything::small),
+			jsondom::field("real", &everything::real),
+			jsondom::field("text", &everything::text),
+			jsondom::field("exact", &everything::exact),
+			jsondom::field("absent", &everything::absent),
+			jsondom::field("null", &everything::null),
+			jsondom::field("strings", &everything::strings),
+			jsondom::field("map", &everything::map),
+			jsondom::field("children", &everything::children),
+			jsondom::field("untouched", &everything::untouched)
+		);
+};
+
+template <>
+struct jsondom::describe<special_keys>{
+	static constexpr auto fields = std::make_tuple(
+			jsondom::field("a/b", &special_keys::slash),
+			jsondom::field("\xd0\xb1", &special_keys::unicode),
+			jsondom::field("inf", &special_keys::infinity)
+		);
+};
+
+template <>
+struct jsondom::describe<no_fields>{
+	static constexpr auto fields = std::make_tuple();
+};
+
+template <>
+struct jsondom::describe<single_float>{
+	static constexpr auto fields = std::make_tuple(
+			jsondom::field("v", &single_float::v)
+		);
+};
+
+namespace{
+const tst::set set("typed", [](tst::suite& suite){
+	suite.add("read_all_types", [](){
+		const std::string json = R"qwertyuiop(
+			{
+				"flag": true,
+				"small": -128,
+				"unknown": {"skipped": [1, {"text": "not me"}]},
+				"real": 1.5,
+				"text": "hello\nworld",
+				"exact": 1.10,
+				"null": null,
+				"strings": ["a", "b"],
+				"map": {"x": [1, 2], "y": []},
+				"children": [{"text": "child", "children": [{"flag": true}]}, {}]
+			}
+		)qwertyuiop";
+
+		auto e = jsondom::read_typed<everything>(utki::make_span(json));
+
+		tst::check(e.flag, SL);
+		tst::check_eq(int(e.small), -128, SL);
+		tst::check_eq(e.real, 1.5f, SL);
+		tst::check_eq(e.text, std::string("hello\nworld"), SL);
+		tst::check_eq(e.exact.get_string(), std::string("1.10"), SL);
+		tst::check(!e.absent.has_value(), SL);
+		tst::check(!e.null.has_value(), SL);
+		tst::check(e.strings.has_value(), SL);
+		tst::check(e.strings.value() == std::vector<std::string>{"a", "b"}, SL);
+		tst::check_eq(e.map.size(), size_t(2), SL);
+		tst::check(e.map["x"] == std::vector<int>{1, 2}, SL);
+		tst::check(e.map["y"].empty(), SL);
+		tst::check_eq(e.children.size(), size_t(2), SL);
+		tst::check_eq(e.children[0].text, std::string("child"), SL);
+		tst::check_eq(e.children[0].children.size(), size_t(1), SL);
+		tst::check(e.children[0].children[0].flag, SL);
+		tst::check(e.children[1].children.empty(), SL);
+		tst::check_eq(e.untouched, 42, SL);
+	});
+
+	suite.add<std::string>(
+		"type_mismatch",
+		{
+			R"({"flag": 1})",
+			R"({"small": 128})",
+			R"({"small": 1.5})",
+			R"({"text": 13})",
+			R"({"strings": {}})",
+			R"({"map": []})",
+			R"({"children": [1]})",
+			R"({"untouched": null})"
+		},
+		[](const auto& p){
+			bool thrown = false;
+			try{
+				jsondom::read_typed<everything>(utki::make_span(p));
+			}catch(jsondom::unexpected_value_type&){
+				thrown = true;
+			}
+			tst::check(thrown, SL) << "json = " << p;
+		}
+	);
+
+	suite.add("sample_matches_dom", [](){
+		fsif::native_file fi("samples_data/tradier_prices.json");
+
+		auto json = jsondom::read(fi);
+		auto typed = jsondom::read_typed<prices>(fi);
+
+		const auto& data = json.object().at("series").object().at("data").array();
+
+		tst::check_eq(typed.series.data.size(), data.size(), SL);
+		for(size_t i = 0; i != data.size(); ++i){
+			const auto& o = data[i].object();
+			const auto& c = typed.series.data[i];
+			tst::check_eq(c.time, o.at("time").string(), SL);
+			tst::check_eq(c.timestamp, o.at("timestamp").number().to_int64(), SL);
+			tst::check_eq(c.price, o.at("price").number().to_double(), SL);
+			tst::check_eq(c.volume, o.at("volume").number().to_uint32(), SL);
+		}
+	});
+
+	suite.add("write_round_trip", [](){
+		everything e;
+		e.flag = true;
+		e.small = -5;
+		e.real = 0.1f;
+		e.text = "quote \" and slash /";
+		e.exact = jsondom::string_number(std::string("1.10"));
+		e.strings = std::vector<std::string>{"a", ""};
+		e.map["x"] = {1, 2, 3};
+		e.children.emplace_back().text = "child";
+		e.children.back().exact = jsondom::string_number(0);
+
+		auto json = jsondom::to_string_typed(e);
+
+		// float is formatted as float, not widened to double
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+		const std::string real = "0.1";
+#else
+		const std::string real = "0.100000001";
+#endif
+
+		tst::check_eq(
+				json,
+				std::string(R"({"flag":true,"small":-5,"real":)") + real + std::string(R"(,"text":"quote \" and slash \/","exact":1.10,"absent":null,"null":13,"strings":["a",""],"map":{"x":[1,2,3]},"children":[{"flag":false,"small":0,"real":0,"text":"child","exact":0,"absent":null,"null":13,"strings":null,"map":{},"children":[],"untouched":42}],"untouched":42})"),
+				SL
+			);
+
+		auto read = jsondom::read_typed<everything>(utki::make_span(json));
+		tst::check_eq(jsondom::to_string_typed(read), json, SL);
+
+	});
+
+	suite.add<float>(
+		"write_float_round_trip",
+		{
+			0.1f,
+			-1.5f,
+			1.0f / 3,
+			16777217.0f,
+			std::numeric_limits<float>::max(),
+			std::numeric_limits<float>::min(),
+			std::numeric_limits<float>::denorm_min(),
+		},
+		[](const auto& f){
+			auto json = jsondom::to_string_typed(single_float{f});
+			auto read = jsondom::read_typed<single_float>(utki::make_span(json));
+
+			tst::check(read.v == f, SL) << "json = " << json;
+
+			// float never needs more than 9 significant digits to parse back exactly
+			tst::check_le(json.size(), std::string(R"({"v":-1.23456789e-45})").size(), SL) << "json = " << json;
+		}
+	);
+
+	suite.add("write_escaped_keys", [](){
+		tst::check_eq(
+				jsondom::to_string_typed(special_keys()),
+				std::string("{\"a\\/b\":1,\"\xd0\xb1\":\"\xd0\xb0\",\"inf\":null}"),
+				SL
+			);
+
+		jsondom::write_options options;
+		options.ensure_ascii = true;
+		tst::check_eq(
+				jsondom::to_string_typed(special_keys(), options),
+				std::string(R"({"a\/b":1,"\u0431":"\u0430","inf":null})"),
+				SL
+			);
+
+		tst::check_eq(jsondom::to_string_typed(no_fields()), std::string("{}"), SL);
+	});
+
+	suite.add("write_typed_to_file", [](){
+		fsif::native_file fi("samples_data/tradier_prices.json");
+		auto typed = jsondom::read_typed<prices>(fi);
+
+		fsif::vector_file out;
+		jsondom::write_typed(out, typed);
+		auto data = out.reset_data();
+
+		tst::check_eq(
+				jsondom::to_string_typed(jsondom::read_typed<prices>(utki::to_char(utki::make_span(data)))),
+				jsondom::to_string_typed(typed),
+				SL
+			);
+	});
+});
+}
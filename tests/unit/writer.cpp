@@ -0,0 +1,242 @@
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include <fsif/vector_file.hpp>
+#include <utki/config.hpp>
+#include <utki/string.hpp>
+
+#include "../../src/jsondom/writer.hpp"
+
+using namespace std::string_literals;
+
+namespace{
+const tst::set set("writer", [](tst::suite& suite){
+	suite.add("write_to_memory", [](){
+		jsondom::writer w;
+
+		w.begin_object();
+		w.key("name");
+		w.value("hello");
+		w.key("values");
+		w.begin_array();
+		w.value(jsondom::string_number(13));
+		w.value(true);
+		w.value(false);
+		w.value(nullptr);
+		w.begin_object();
+		w.end_object();
+		w.begin_array();
+		w.end_array();
+		w.value("esc\"aped"s);
+		w.end_array();
+		w.key("dom");
+		w.value(jsondom::read(R"({"a":[1,2],"b":null})"));
+		w.end_object();
+
+		tst::check_eq(
+			w.reset_data(),
+			R"({"name":"hello","values":[13,true,false,null,{},[],"esc\"aped"],"dom":{"a":[1,2],"b":null}})"s,
+			SL
+		);
+	});
+
+	suite.add("write_to_file", [](){
+		fsif::vector_file file;
+
+		{
+			fsif::file::guard file_guard(file, fsif::mode::create);
+			jsondom::writer w(file);
+
+			w.begin_object();
+			w.key("array");
+			w.begin_array();
+			for(unsigned i = 0; i != 10000; ++i){
+				w.begin_object();
+				w.key("index");
+				w.value(jsondom::string_number(i));
+				w.key("name");
+				w.value("item");
+				w.end_object();
+			}
+			w.end_array();
+			w.end_object();
+		}
+
+		auto str = utki::make_string(file.reset_data());
+
+		auto json = jsondom::read(str);
+		tst::check_eq(json.to_string(), str, SL);
+		tst::check_eq(json.object().at("array").array().size(), size_t(10000), SL);
+		tst::check_eq(json.object().at("array").array().back().object().at("index").number().to_int32(), 9999, SL);
+	});
+
+	suite.add("parallel_serialization", [](){
+		// document big enough to be serialized in parallel, with nested big containers
+		jsondom::value json(jsondom::type::object);
+		auto& quotes = json.object()["quotes"] = jsondom::value(jsondom::type::object);
+		auto& quote = quotes.object()["quote"] = jsondom::value(jsondom::type::array);
+		for(unsigned i = 0; i != 30000; ++i){
+			jsondom::value q(jsondom::type::object);
+			q.object()["symbol"] = jsondom::value("SYM"s + std::to_string(i));
+			q.object()["last"] = jsondom::value(jsondom::string_number(i));
+			q.object()["description"] = jsondom::value("some \"quoted\" description text"s);
+			quote.array().push_back(std::move(q));
+		}
+		json.object()["a_small_one"] = jsondom::value(true);
+		json.object()["z_small_one"] = jsondom::value(jsondom::type::null);
+
+		auto expected = json.to_string();
+
+		jsondom::write_options options;
+		options.num_threads = 4;
+
+		tst::check_eq(json.to_string(options), expected, SL);
+
+		fsif::vector_file file;
+		jsondom::write(file, json, options);
+		tst::check(utki::make_string(file.reset_data()) == expected, SL);
+	});
+
+	suite.add("cache_subtrees", [](){
+		auto json = jsondom::read(R"qwertyuiop(
+				{
+					"state": {
+						"players": [{"name": "alice", "score": 10}, {"name": "bob", "score": 20}],
+						"map": {"size": [100, 200], "title": "d\u00e9j\u00e0 vu"}
+					},
+					"empty": {},
+					"tick": 1
+				}
+			)qwertyuiop");
+
+		jsondom::write_options options;
+		options.cache_subtrees = true;
+
+		auto check_output = [&json, &options](){
+			auto uncached_options = options;
+			uncached_options.cache_subtrees = false;
+			auto expected = json.to_string(uncached_options);
+
+			tst::check_eq(json.to_string(options), expected, SL);
+
+			fsif::vector_file file;
+			jsondom::write(file, json, options);
+			tst::check(utki::make_string(file.reset_data()) == expected, SL);
+		};
+
+		check_output();
+
+		// write again from cache
+		check_output();
+
+		// modify deeply nested value
+		json.object()["state"].object()["players"].array()[1].object()["score"] = jsondom::value(jsondom::string_number(21));
+		check_output();
+		tst::check(json.to_string(options).find(R"("score":21)") != std::string::npos, SL);
+
+		// add and remove elements
+		json.object()["state"].object()["players"].array().emplace_back(jsondom::type::object);
+		json.object().erase("empty");
+		json.object()["tick"].number() = jsondom::string_number(2);
+		check_output();
+
+		// cache written with different ensure_ascii option is not used
+		options.ensure_ascii = true;
+		check_output();
+		tst::check(json.to_string(options).find(R"(d\u00e9j\u00e0 vu)") != std::string::npos, SL);
+		options.ensure_ascii = false;
+		check_output();
+
+		// modifying a copy does not affect the cached text of the original
+		auto expected = json.to_string();
+		auto copy = json;
+		copy.object()["state"].object()["map"].object()["title"] = jsondom::value("changed"s);
+		tst::check_eq(json.to_string(options), expected, SL);
+		tst::check_eq(copy.to_string(options), copy.to_string(), SL);
+		tst::check(copy.to_string(options) != expected, SL);
+	});
+
+	suite.add("cache_subtrees_non_object_root", [](){
+		auto json = jsondom::read(R"({"a": [1, [2, 3], {"b": [4]}]})");
+
+		jsondom::value arr = json.object()["a"];
+
+		jsondom::write_options options;
+		options.cache_subtrees = true;
+
+		jsondom::writer w(options);
+		w.value(arr);
+		tst::check_eq(w.reset_data(), R"([1,[2,3],{"b":[4]}])"s, SL);
+
+		arr.array()[1].array().clear();
+
+		jsondom::writer w2(options);
+		w2.value(arr);
+		tst::check_eq(w2.reset_data(), R"([1,[],{"b":[4]}])"s, SL);
+	});
+
+	suite.add("cache_subtrees_threads", [](){
+		auto base = jsondom::read(R"({"shared": {"values": [1, 2, [3, 4]]}, "name": "base"})");
+
+		jsondom::write_options options;
+		options.cache_subtrees = true;
+
+		constexpr auto num_threads = 8;
+		std::vector<std::string> results(num_threads);
+		std::vector<std::thread> threads;
+		for(size_t i = 0; i != num_threads; ++i){
+			threads.emplace_back([base, i, &options, &result = results[i]]() mutable {
+				base.object()["name"] = jsondom::value(std::to_string(i));
+				result = base.to_string(options);
+			});
+		}
+		for(auto& t : threads){
+			t.join();
+		}
+
+		for(size_t i = 0; i != num_threads; ++i){
+			tst::check_eq(
+				results[i],
+				utki::cat(R"({"name":")", i, R"(","shared":{"values":[1,2,[3,4]]}})"),
+				SL
+			);
+		}
+	});
+
+#if CFG_OS != CFG_OS_WINDOWS
+	suite.add<bool>(
+		"write_fd",
+		{false, true},
+		[](const auto& background_flush){
+			jsondom::value json(jsondom::type::object);
+			auto& arr = json.object()["array"] = jsondom::value(jsondom::type::array);
+			for(unsigned i = 0; i != 50000; ++i){
+				jsondom::value e(jsondom::type::object);
+				e.object()["a_rather_long_key_to_be_referenced_directly"] = jsondom::value(jsondom::string_number(i));
+				e.object()["short"] = jsondom::value("a long string value which does not need escaping"s);
+				e.object()["escaped"] = jsondom::value("a long string value which \"needs\" escaping"s);
+				arr.array().push_back(std::move(e));
+			}
+
+			auto expected = json.to_string();
+
+			std::unique_ptr<FILE, decltype(&std::fclose)> file(std::tmpfile(), &std::fclose);
+			tst::check(file != nullptr, SL);
+
+			jsondom::write_fd(fileno(file.get()), json, {}, background_flush);
+
+			std::rewind(file.get());
+			std::string str(expected.size() + 1, '\0');
+			auto size = std::fread(str.data(), 1, str.size(), file.get());
+			str.resize(size);
+
+			tst::check(str == expected, SL);
+		}
+	);
+#endif
+});
+}